@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+#include <genetic_optimizer.h>
+#include <differential_evolution.h>
+
+#include "test_functions.h"
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 4;
+constexpr size_t bits = 32;
+constexpr size_t population_size = 100;
+constexpr size_t max_generations = 2000;
+
+// -1: the end-to-end GA pipeline, otherwise a DifferentialEvolutionPass strategy
+void register_pipeline(GeneticOptimizer& optimizer, int64_t engine) {
+    if (engine >= 0) {
+        optimizer.register_pass(std::make_unique<DifferentialEvolutionPass>(
+            static_cast<DifferentialEvolutionPass::DifferentialEvolutionStrategy>(engine)));
+        return;
+    }
+    optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(1.0 / (variables * bits)));
+}
+
+const char* engine_name(int64_t engine) {
+    static const char* names[] = {"ga", "de_rand_1_bin", "de_best_1_bin", "jade"};
+    return names[engine + 1];
+}
+
+// range(0): engine, range(1): index in test_functions. Runs until the function's target is
+// reached or max_generations passed, reports the evaluations needed (reached = share of runs
+// that got there) and the mean best objective value
+void BM_EvaluationsToTarget(benchmark::State& state) {
+    const int64_t engine = state.range(0);
+    const TestFunction& function = test_functions[state.range(1)];
+    state.SetLabel(std::string(engine_name(engine)) + "/" + function.name);
+
+    size_t evaluations = 0, reached = 0, evaluations_to_target = 0;
+    double best = 0;
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        GeneticOptimizer optimizer(population_size, max_generations, seed++);
+        register_pipeline(optimizer, engine);
+        optimizer.add_stop_condition(std::make_unique<FitnessTarget>(-function.target));
+        FitnessEvaluator evaluator([&function](std::span<const double> x, std::span<double> fits) {
+            for (size_t i = 0; i < fits.size(); ++i)
+                fits[i] = -function.value(x.subspan(i * variables, variables));
+        }, BoxTransformer<variables, bits>(function.start, function.end));
+        optimizer.optimize(evaluator);
+
+        evaluations += optimizer.statistics().evaluations;
+        if (-optimizer.best_fit() <= function.target) {
+            reached++;
+            evaluations_to_target += optimizer.statistics().evaluations;
+        }
+        best += -optimizer.best_fit();
+    }
+
+    const double runs = static_cast<double>(state.iterations());
+    state.counters["evals_per_second"] = benchmark::Counter(static_cast<double>(evaluations), benchmark::Counter::kIsRate);
+    state.counters["best"] = best / runs;
+    state.counters["reached"] = reached / runs;
+    state.counters["evaluations_to_target"] = reached ? static_cast<double>(evaluations_to_target) / reached : 0.0;
+}
+
+} // namespace
+
+BENCHMARK(BM_EvaluationsToTarget)->ArgsProduct({{-1, 0, 1, 2}, {0, 1, 2, 3}})->Unit(benchmark::kMillisecond)->UseRealTime();
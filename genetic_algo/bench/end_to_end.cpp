@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <omp.h>
+#include <genetic_optimizer.h>
+#include <static_optimizer.h>
+
+#include "test_functions.h"
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 4;
+constexpr size_t bits = 32;
+constexpr size_t population_size = 1000;
+constexpr size_t max_generations = 200;
+
+void register_pipeline(GeneticOptimizer& optimizer) {
+    optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(1.0 / (variables * bits)));
+}
+
+FitnessEvaluator test_function_evaluator(const TestFunction& function) {
+    const BoxTransformer<variables, bits> transformer(function.start, function.end);
+    return FitnessEvaluator([&function](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i)
+            fits[i] = -function.value(x.subspan(i * variables, variables));
+    }, transformer);
+}
+
+// range(0): index in test_functions, range(1): OpenMP threads. Reports evaluations per
+// second, the best objective value and the time and generations until the function's
+// target was first reached (reached = 0 if it never was)
+void BM_EndToEnd(benchmark::State& state) {
+    const TestFunction& function = test_functions[state.range(0)];
+    const int previous_threads = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(state.range(1)));
+    state.SetLabel(function.name);
+
+    size_t evaluations = 0, reached = 0, generations_to_target = 0;
+    double best = 0, seconds_to_target = 0;
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        GeneticOptimizer optimizer(population_size, max_generations, seed++);
+        register_pipeline(optimizer);
+        FitnessEvaluator evaluator = test_function_evaluator(function);
+
+        const auto begin = std::chrono::steady_clock::now();
+        bool target_reached = false;
+        optimizer.start(evaluator);
+        while (!optimizer.finished()) {
+            optimizer.step(evaluator);
+            if (!target_reached && -optimizer.best_fit() <= function.target) {
+                target_reached = true;
+                reached++;
+                generations_to_target += optimizer.generation();
+                seconds_to_target += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            }
+        }
+        optimizer.finish(evaluator);
+
+        evaluations += optimizer.statistics().evaluations;
+        best += -optimizer.best_fit();
+    }
+
+    const double runs = static_cast<double>(state.iterations());
+    state.counters["threads"] = static_cast<double>(state.range(1));
+    state.counters["evals_per_second"] = benchmark::Counter(static_cast<double>(evaluations), benchmark::Counter::kIsRate);
+    state.counters["best"] = best / runs;
+    state.counters["reached"] = reached / runs;
+    state.counters["generations_to_target"] = reached ? static_cast<double>(generations_to_target) / reached : 0.0;
+    state.counters["seconds_to_target"] = reached ? seconds_to_target / reached : 0.0;
+
+    omp_set_num_threads(previous_threads);
+}
+
+// BM_EndToEnd's pipeline and objective compiled into a StaticGeneticOptimizer, range(0): OpenMP
+// threads. Reports evaluations per second and the best objective value
+template <size_t Function>
+void BM_StaticEndToEnd(benchmark::State& state) {
+    constexpr TestFunction function = test_functions[Function];
+    const int previous_threads = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(state.range(0)));
+    state.SetLabel(function.name);
+
+    size_t evaluations = 0;
+    double best = 0;
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        StaticGeneticOptimizer optimizer(population_size, max_generations, seed++,
+            [](std::span<const double> x) { return -function.value(x); }, BoxTransformer<variables, bits>(function.start, function.end),
+            SelectionPass(SelectionPass::TOURNAMENT_SELECTION), CrossoverPass(), MutationPass(1.0 / (variables * bits)));
+        optimizer.optimize();
+        evaluations += optimizer.evaluations();
+        best += -optimizer.best_fit();
+    }
+
+    state.counters["threads"] = static_cast<double>(state.range(0));
+    state.counters["evals_per_second"] = benchmark::Counter(static_cast<double>(evaluations), benchmark::Counter::kIsRate);
+    state.counters["best"] = best / static_cast<double>(state.iterations());
+
+    omp_set_num_threads(previous_threads);
+}
+
+// One generation of BM_EndToEnd's pipeline on rastrigin, runtime-registered or static, range(0):
+// population size. Fusing crossover, mutation and evaluation saves two sweeps over the children,
+// which shows once the population no longer fits in cache
+template <bool Static>
+void BM_Generation(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    constexpr TestFunction function = test_functions[0];
+    const BoxTransformer<variables, bits> transformer(function.start, function.end);
+    const auto objective = [](std::span<const double> x) { return -function.value(x); };
+
+    if constexpr (Static) {
+        StaticGeneticOptimizer optimizer(size, 0, 1, objective, transformer, SelectionPass(SelectionPass::TOURNAMENT_SELECTION),
+            CrossoverPass(), MutationPass(1.0 / (variables * bits)));
+        optimizer.start();
+        for (auto _ : state)
+            optimizer.step();
+    } else {
+        GeneticOptimizer optimizer(size, 0, 1);
+        register_pipeline(optimizer);
+        FitnessEvaluator evaluator(MultiFitnessFunction(objective), transformer);
+        optimizer.start(evaluator);
+        for (auto _ : state)
+            optimizer.step(evaluator);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+
+// 1 and all processors
+void static_threads(benchmark::internal::Benchmark* benchmark) {
+    benchmark->Arg(1);
+    if (omp_get_num_procs() > 1)
+        benchmark->Arg(omp_get_num_procs());
+}
+
+// every test function with 1, 2, 4, ... up to all processors
+void thread_scaling(benchmark::internal::Benchmark* benchmark) {
+    const int processors = omp_get_num_procs();
+    for (size_t function = 0; function < std::size(test_functions); ++function) {
+        for (int threads = 1; threads < processors; threads *= 2)
+            benchmark->Args({static_cast<int64_t>(function), threads});
+        benchmark->Args({static_cast<int64_t>(function), processors});
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_EndToEnd)->Apply(thread_scaling)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StaticEndToEnd<0>)->Apply(static_threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StaticEndToEnd<1>)->Apply(static_threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StaticEndToEnd<2>)->Apply(static_threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StaticEndToEnd<3>)->Apply(static_threads)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Generation<false>)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Generation<true>)->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <expression.h>
+#include <rng.h>
+
+#include "test_functions.h"
+
+using namespace dl;
+
+namespace {
+
+// rows of one FitnessEvaluator chunk
+constexpr size_t rows = 1024;
+
+double target_function(std::span<const double> x) {
+    return x[0] * x[0] * std::sin(x[0] * x[0]) + 1 / (x[0] + 0.001);
+}
+
+struct Objective
+{
+    const char* name;
+    const char* text;
+    std::vector<std::string> variables;
+    double (*native)(std::span<const double> x);
+};
+
+const Objective objectives[] = {
+    {"target_function", "x*x*sin(x*x) + 1/(x+0.001)", {"x"}, target_function},
+    {"rastrigin4", "40 + x0^2 - 10*cos(2*pi*x0) + x1^2 - 10*cos(2*pi*x1) + x2^2 - 10*cos(2*pi*x2) + x3^2 - 10*cos(2*pi*x3)",
+        {"x0", "x1", "x2", "x3"}, rastrigin},
+    {"rosenbrock2", "100*(y - x^2)^2 + (1 - x)^2", {"x", "y"}, rosenbrock},
+    {"ackley2", "-20*exp(-0.2*sqrt((x^2 + y^2)/2)) - exp((cos(2*pi*x) + cos(2*pi*y))/2) + 20 + e", {"x", "y"}, ackley},
+};
+
+std::vector<double> points(const Objective& objective) {
+    std::vector<double> x(rows * objective.variables.size());
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (double& xi : x)
+        xi = 0.1 + 2.0 * engine.uniform();
+    return x;
+}
+
+// range(0): index in objectives. The objective compiled into the benchmark, one call per point
+void BM_NativeObjective(benchmark::State& state) {
+    const Objective& objective = objectives[state.range(0)];
+    state.SetLabel(objective.name);
+    const size_t variables = objective.variables.size();
+    const std::vector<double> x = points(objective);
+    std::vector<double> values(rows);
+    for (auto _ : state) {
+        for (size_t i = 0; i < rows; ++i)
+            values[i] = objective.native(std::span<const double>(x.data() + i * variables, variables));
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+void BM_CompiledExpression(benchmark::State& state) {
+    const Objective& objective = objectives[state.range(0)];
+    state.SetLabel(objective.name);
+    const Expression expression(objective.text, objective.variables);
+    const std::vector<double> x = points(objective);
+    std::vector<double> values(rows);
+    for (auto _ : state) {
+        expression(x, values);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+    state.counters["instructions"] = expression.instructions();
+}
+
+} // namespace
+
+BENCHMARK(BM_NativeObjective)->DenseRange(0, 3);
+BENCHMARK(BM_CompiledExpression)->DenseRange(0, 3);
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+#include <genetic_optimizer.h>
+#include <local_search.h>
+
+#include "test_functions.h"
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 4;
+constexpr size_t bits = 32;
+constexpr size_t population_size = 100;
+constexpr size_t max_generations = 2000;
+
+// range(0): evaluation budget of the local search per generation, 0 for the plain GA;
+// range(1): index in test_functions; range(2): divisor of the function's target, the larger
+// the more the final digits count. Reports the evaluations needed to reach the target
+// (reached = share of runs that got there) and the mean best objective value
+void BM_MemeticEvaluationsToTarget(benchmark::State& state) {
+    const size_t budget = state.range(0);
+    const TestFunction& function = test_functions[state.range(1)];
+    const double target = function.target / state.range(2);
+    state.SetLabel(std::string(budget ? "memetic" : "ga") + "/" + function.name);
+
+    size_t evaluations = 0, reached = 0, evaluations_to_target = 0;
+    double best = 0;
+    uint64_t seed = 1;
+    for (auto _ : state) {
+        GeneticOptimizer optimizer(population_size, max_generations, seed++);
+        if (budget)
+            optimizer.register_pass(std::make_unique<LocalSearchPass>(1, 8, budget));
+        optimizer.register_pass(std::make_unique<ElitismPass>(2));
+        optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+        optimizer.register_pass(std::make_unique<CrossoverPass>());
+        optimizer.register_pass(std::make_unique<MutationPass>(1.0 / (variables * bits)));
+        optimizer.add_stop_condition(std::make_unique<FitnessTarget>(-target));
+        FitnessEvaluator evaluator([&function](std::span<const double> x, std::span<double> fits) {
+            for (size_t i = 0; i < fits.size(); ++i)
+                fits[i] = -function.value(x.subspan(i * variables, variables));
+        }, BoxTransformer<variables, bits>(function.start, function.end));
+        optimizer.optimize(evaluator);
+
+        evaluations += optimizer.statistics().evaluations;
+        if (-optimizer.best_fit() <= target) {
+            reached++;
+            evaluations_to_target += optimizer.statistics().evaluations;
+        }
+        best += -optimizer.best_fit();
+    }
+
+    const double runs = static_cast<double>(state.iterations());
+    state.counters["evals_per_second"] = benchmark::Counter(static_cast<double>(evaluations), benchmark::Counter::kIsRate);
+    state.counters["best"] = best / runs;
+    state.counters["reached"] = reached / runs;
+    state.counters["evaluations_to_target"] = reached ? static_cast<double>(evaluations_to_target) / reached : 0.0;
+}
+
+} // namespace
+
+BENCHMARK(BM_MemeticEvaluationsToTarget)->ArgsProduct({{0, 32, 128}, {0, 1, 2, 3}, {1, 100}})->Unit(benchmark::kMillisecond)->UseRealTime();
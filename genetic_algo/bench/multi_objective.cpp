@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <cmath>
+#include <multi_objective.h>
+
+using namespace dl;
+
+namespace {
+
+std::vector<double> random_points(size_t size, size_t count) {
+    std::vector<double> points(size * count);
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (double& value : points)
+        value = engine.uniform();
+    return points;
+}
+
+// reference: Deb's fast non-dominated sort, domination counts of every pair, O(M N^2)
+void deb_fronts(std::span<const double> points, size_t count, std::vector<uint32_t>& fronts) {
+    const size_t size = points.size() / count;
+    const auto dominates = [&](size_t q, size_t p) {
+        bool better = false;
+        for (size_t j = 0; j < count; ++j) {
+            if (points[q * count + j] < points[p * count + j])
+                return false;
+            better |= points[q * count + j] > points[p * count + j];
+        }
+        return better;
+    };
+
+    std::vector<std::vector<size_t>> dominated(size);
+    std::vector<size_t> dominators(size, 0);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t p = 0; p < size; ++p) {
+        for (size_t q = 0; q < size; ++q) {
+            if (dominates(p, q))
+                dominated[p].push_back(q);
+            else if (dominates(q, p))
+                dominators[p]++;
+        }
+    }
+
+    fronts.assign(size, 0);
+    std::vector<size_t> current, next;
+    for (size_t p = 0; p < size; ++p) {
+        if (dominators[p] == 0)
+            current.push_back(p);
+    }
+    for (uint32_t front = 0; !current.empty(); ++front) {
+        next.clear();
+        for (const size_t q : current) {
+            fronts[q] = front;
+            for (const size_t p : dominated[q]) {
+                if (--dominators[p] == 0)
+                    next.push_back(p);
+            }
+        }
+        std::swap(current, next);
+    }
+}
+
+// range(0): points, range(1): objectives. Fronts, crowding distances and order of uniformly
+// random points
+void BM_ParetoRanking(benchmark::State& state) {
+    const size_t count = state.range(1);
+    const std::vector<double> points = random_points(state.range(0), count);
+    ParetoRanking ranking;
+    for (auto _ : state) {
+        ranking.rank(points, count);
+        benchmark::DoNotOptimize(ranking.order().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["fronts"] = ranking.front_count();
+}
+
+void BM_DebNonDominatedSort(benchmark::State& state) {
+    const size_t count = state.range(1);
+    const std::vector<double> points = random_points(state.range(0), count);
+    std::vector<uint32_t> fronts;
+    for (auto _ : state) {
+        deb_fronts(points, count, fronts);
+        benchmark::DoNotOptimize(fronts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// ZDT1 with 30 variables, objectives negated
+void negative_zdt1(std::span<const double> x, std::span<double> objectives) {
+    constexpr size_t variables = 30;
+    for (size_t i = 0; i < objectives.size() / 2; ++i) {
+        const double* xi = x.data() + i * variables;
+        double sum = 0;
+        for (size_t v = 1; v < variables; ++v)
+            sum += xi[v];
+        const double g = 1 + 9 * sum / (variables - 1);
+        objectives[2 * i] = -xi[0];
+        objectives[2 * i + 1] = -g * (1 - std::sqrt(xi[0] / g));
+    }
+}
+
+// range(0): population size. One NSGA-II generation: breeding, evaluation of the offspring,
+// ranking of parents and offspring, selection
+void BM_Nsga2Generation(benchmark::State& state) {
+    MultiObjectiveOptimizer optimizer(state.range(0), 1000, 2, 1);
+    optimizer.start(negative_zdt1, BoxTransformer<30, 32>(0.0, 1.0));
+    for (auto _ : state)
+        optimizer.step();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["front"] = optimizer.front().size();
+}
+
+} // namespace
+
+// five objectives stop at 100000 points: uniformly random points form a few huge fronts, the
+// quadratic worst case of ENS-BS
+BENCHMARK(BM_ParetoRanking)->ArgsProduct({{10000, 100000, 1000000}, {2, 3}})->Args({10000, 5})->Args({100000, 5})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_DebNonDominatedSort)->ArgsProduct({{10000}, {2, 3, 5}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Nsga2Generation)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
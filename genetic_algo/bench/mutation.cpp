@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <genome.h>
+
+using namespace dl;
+
+namespace {
+
+// reference: the former per-bit mutation, one uniform draw for every bit
+void per_bit_mutation(std::span<uint64_t> words, double probability, RandomEngine& engine) {
+    for (auto& word : words) {
+        for (size_t i = 0; i < 64; ++i) {
+            if (engine.uniform() < probability)
+                word ^= uint64_t{1} << i;
+        }
+    }
+}
+
+// range(0): mutation probability in 1/10000, range(1): words per genome
+void BM_PerBitMutation(benchmark::State& state) {
+    const double probability = state.range(0) / 10000.0;
+    std::vector<uint64_t> words(state.range(1));
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (auto _ : state) {
+        per_bit_mutation(words, probability, engine);
+        benchmark::DoNotOptimize(words.data());
+    }
+    state.SetItemsProcessed(state.iterations() * words.size() * 64);
+}
+
+void BM_BernoulliMaskMutation(benchmark::State& state) {
+    const BernoulliMaskGenerator generator(state.range(0) / 10000.0);
+    std::vector<uint64_t> words(state.range(1));
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (auto _ : state) {
+        generator.apply(words, 64, engine);
+        benchmark::DoNotOptimize(words.data());
+    }
+    state.SetItemsProcessed(state.iterations() * words.size() * 64);
+}
+
+} // namespace
+
+BENCHMARK(BM_PerBitMutation)->ArgsProduct({{10, 100, 1000, 5000}, {1, 16}});
+BENCHMARK(BM_BernoulliMaskMutation)->ArgsProduct({{10, 100, 1000, 5000}, {1, 16}});
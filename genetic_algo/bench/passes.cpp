@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <cmath>
+#include <genetic_optimizer.h>
+
+using namespace dl;
+
+namespace {
+
+Population random_population(size_t size, GenomeLayout layout = {}, bool with_swarm_state = false) {
+    Population population(size, layout, with_swarm_state);
+    RandomEngine engine = RandomSource(7).stream(0);
+    for (size_t i = 0; i < size; ++i) {
+        for (auto& word : population.genome(i))
+            word = engine() & layout.mask();
+        population.assign(i, population.genome(i), 0);
+        population.set_fit(i, engine.uniform() - 0.5);
+    }
+    return population;
+}
+
+void BM_GrayDecode(benchmark::State& state) {
+    std::vector<uint64_t> encoded(state.range(0));
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (auto& word : encoded)
+        word = engine();
+
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (const auto word : encoded)
+            sum += gray_decode(word);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * encoded.size());
+}
+
+void BM_GrayDecodeBatch(benchmark::State& state) {
+    std::vector<uint64_t> encoded(state.range(0));
+    std::vector<uint64_t> decoded(encoded.size());
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (auto& word : encoded)
+        word = engine();
+
+    for (auto _ : state) {
+        gray_decode<uint64_t>(encoded, decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetItemsProcessed(state.iterations() * encoded.size());
+}
+
+// range(0): population size, range(1): SelectionPass::SelectionStrategy
+void BM_SelectionPass(benchmark::State& state) {
+    Population population = random_population(state.range(0));
+    // rate 1 keeps the population size constant between iterations
+    const SelectionPass pass(static_cast<SelectionPass::SelectionStrategy>(state.range(1)), 1.0, 4);
+    // lent by the optimizer in a real run
+    GenerationArena arena;
+    size_t generation = 0;
+    for (auto _ : state) {
+        arena.prepare();
+        pass.run(population, PassContext{generation, RandomSource(generation++), &arena});
+    }
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+// range(0): population size, range(1): variables, range(2): CrossoverPass::CrossoverStrategy
+void BM_CrossoverPass(benchmark::State& state) {
+    const size_t size = state.range(0);
+    Population population = random_population(size, GenomeLayout{static_cast<size_t>(state.range(1)), 64});
+    const CrossoverPass pass(static_cast<CrossoverPass::CrossoverStrategy>(state.range(2)));
+    size_t generation = 0;
+    for (auto _ : state) {
+        pass.run(population, PassContext{generation, RandomSource(generation++)});
+        population.resize(size);
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+void BM_MutationPass(benchmark::State& state) {
+    Population population = random_population(state.range(0), GenomeLayout{static_cast<size_t>(state.range(1)), 64});
+    const MutationPass pass(0.01);
+    size_t generation = 0;
+    for (auto _ : state)
+        pass.run(population, PassContext{0, RandomSource(generation++)});
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+void BM_ParticleSwarmPass(benchmark::State& state) {
+    Population population = random_population(state.range(0), GenomeLayout{}, true);
+    const ParticleSwarmOptimizationPass pass(0.5, 0.5);
+    size_t generation = 0;
+    for (auto _ : state)
+        pass.run(population, PassContext{generation, RandomSource(generation++)});
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+void BM_SortByFit(benchmark::State& state) {
+    const Population population = random_population(state.range(0));
+    std::vector<size_t> order;
+    for (auto _ : state) {
+        sort_by_fit(population, order);
+        benchmark::DoNotOptimize(order.data());
+    }
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+// range(1): ranked individuals at each end, what the optimizer loop needs
+void BM_RankByFit(benchmark::State& state) {
+    const Population population = random_population(state.range(0));
+    FitRanking ranking;
+    for (auto _ : state) {
+        ranking.rank(population, state.range(1), state.range(1));
+        benchmark::DoNotOptimize(ranking.order().data());
+    }
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+void BM_UpdateFit(benchmark::State& state) {
+    Population population = random_population(state.range(0));
+    const FitnessFunction fitness_function = [](double x) { return -x * x * std::sin(x * x); };
+    const GenomeTranformer transformer = LinearTransformer{0.1, 3.0};
+    for (auto _ : state) {
+        for (size_t i = 0; i < population.size(); ++i)
+            population.update_fit(i, fitness_function, transformer);
+        benchmark::DoNotOptimize(population.fits().data());
+    }
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+void BM_EvaluateBatched(benchmark::State& state) {
+    Population population = random_population(state.range(0));
+    const FitnessEvaluator evaluator([](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < x.size(); ++i)
+            fits[i] = -x[i] * x[i] * std::sin(x[i] * x[i]);
+    }, LinearTransformer{0.1, 3.0});
+    for (auto _ : state) {
+        population.mark_all_dirty();
+        evaluator.evaluate(population);
+    }
+    state.SetItemsProcessed(state.iterations() * population.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_GrayDecode)->Arg(1 << 16);
+BENCHMARK(BM_GrayDecodeBatch)->Arg(1 << 16);
+BENCHMARK(BM_SelectionPass)->ArgsProduct({{1000, 100000}, {SelectionPass::ROULETTE_WHEEL_SELECTION,
+    SelectionPass::RANK_SELECTION, SelectionPass::TOURNAMENT_SELECTION}});
+BENCHMARK(BM_CrossoverPass)->ArgsProduct({{1000, 100000}, {1, 8}, {CrossoverPass::ONE_POINT_CROSSOVER,
+    CrossoverPass::TWO_POINT_CROSSOVER, CrossoverPass::UNIFORM_CROSSOVER, CrossoverPass::VARIABLE_CROSSOVER}});
+BENCHMARK(BM_MutationPass)->ArgsProduct({{1000, 100000}, {1, 8}});
+BENCHMARK(BM_ParticleSwarmPass)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_SortByFit)->Arg(100000)->Arg(1000000);
+BENCHMARK(BM_RankByFit)->ArgsProduct({{100000, 1000000}, {1, 16}});
+BENCHMARK(BM_UpdateFit)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_EvaluateBatched)->Arg(1000)->Arg(100000);
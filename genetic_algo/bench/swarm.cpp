@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+#include <genetic_optimizer.h>
+#include <swarm.h>
+
+#include "test_functions.h"
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 4;
+constexpr size_t bits = 32;
+// same evaluation budget for every engine: particles * (iterations + 1)
+constexpr size_t population_size = 1000;
+constexpr size_t max_generations = 200;
+
+enum Engine : int64_t {
+    // the demo's pipeline: selection, crossover, integer-space PSO pass and mutation
+    HYBRID,
+    // selection, crossover, continuous-space SwarmPass and mutation
+    HYBRID_SWARM_PASS,
+    // SwarmOptimizer on the decoded box
+    STANDALONE_SWARM,
+};
+
+const char* engine_names[] = {"hybrid", "hybrid_swarm_pass", "standalone_swarm"};
+
+BatchFitnessFunction test_function_objective(const TestFunction& function) {
+    return [&function](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i)
+            fits[i] = -function.value(x.subspan(i * variables, variables));
+    };
+}
+
+// returns the best objective value and adds the evaluations of the run
+double run_engine(Engine engine, const TestFunction& function, uint64_t seed, size_t& evaluations) {
+    const BoxTransformer<variables, bits> transformer(function.start, function.end);
+    if (engine == STANDALONE_SWARM) {
+        SwarmOptimizer optimizer(population_size, max_generations, {}, seed);
+        optimizer.optimize(test_function_objective(function), transformer);
+        evaluations += optimizer.evaluations();
+        return -optimizer.best_fit();
+    }
+
+    GeneticOptimizer optimizer(population_size, max_generations, seed);
+    optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    if (engine == HYBRID)
+        optimizer.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(0.3, 0.3));
+    else
+        optimizer.register_pass(std::make_unique<SwarmPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(1.0 / (variables * bits)));
+
+    FitnessEvaluator evaluator(test_function_objective(function), transformer);
+    optimizer.optimize(evaluator);
+    evaluations += optimizer.statistics().evaluations;
+    return -optimizer.best_fit();
+}
+
+// range(0): Engine, range(1): index in test_functions, range(2): OpenMP threads. Reports
+// evaluations per second and the mean best objective value
+void BM_SwarmEngines(benchmark::State& state) {
+    const Engine engine = static_cast<Engine>(state.range(0));
+    const TestFunction& function = test_functions[state.range(1)];
+    const int previous_threads = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(state.range(2)));
+    state.SetLabel(std::string(engine_names[engine]) + "/" + function.name);
+
+    size_t evaluations = 0;
+    double best = 0;
+    uint64_t seed = 1;
+    for (auto _ : state)
+        best += run_engine(engine, function, seed++, evaluations);
+
+    state.counters["threads"] = static_cast<double>(state.range(2));
+    state.counters["evals_per_second"] = benchmark::Counter(static_cast<double>(evaluations), benchmark::Counter::kIsRate);
+    state.counters["best"] = best / static_cast<double>(state.iterations());
+
+    omp_set_num_threads(previous_threads);
+}
+
+void engines(benchmark::internal::Benchmark* benchmark) {
+    const int processors = omp_get_num_procs();
+    for (const Engine engine : {HYBRID, HYBRID_SWARM_PASS, STANDALONE_SWARM}) {
+        for (size_t function = 0; function < std::size(test_functions); ++function) {
+            benchmark->Args({engine, static_cast<int64_t>(function), 1});
+            if (processors > 1)
+                benchmark->Args({engine, static_cast<int64_t>(function), processors});
+        }
+    }
+}
+
+// one update of the swarm kernel over particles x dimensions coordinates
+void BM_SwarmMove(benchmark::State& state) {
+    const size_t particles = static_cast<size_t>(state.range(0)), dimensions = static_cast<size_t>(state.range(1));
+    const size_t coordinates = particles * dimensions;
+    std::vector<double> positions(coordinates), velocities(coordinates, 0.0), personal_best(coordinates), social(coordinates);
+    std::vector<double> lower(swarm_block * dimensions, -1.0), upper(swarm_block * dimensions, 1.0), max_velocity(swarm_block * dimensions, 0.4);
+    RandomEngine engine = RandomSource(7).stream(0);
+    for (size_t k = 0; k < coordinates; ++k) {
+        positions[k] = 2.0 * engine.uniform() - 1.0;
+        personal_best[k] = 2.0 * engine.uniform() - 1.0;
+        social[k] = 2.0 * engine.uniform() - 1.0;
+    }
+
+    const SwarmParameters parameters;
+    uint64_t key = 1;
+    for (auto _ : state) {
+        for (size_t begin = 0; begin < coordinates; begin += swarm_block * dimensions) {
+            swarm_move(positions, velocities, personal_best, social, lower.data(), upper.data(), max_velocity.data(),
+                begin, std::min(begin + swarm_block * dimensions, coordinates), parameters, key, key + 1);
+        }
+        key += 2;
+        benchmark::DoNotOptimize(positions.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * coordinates));
+}
+
+} // namespace
+
+BENCHMARK(BM_SwarmEngines)->Apply(engines)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SwarmMove)->ArgsProduct({{1000, 100000}, {4, 32}});
@@ -0,0 +1,63 @@
+#ifndef TEST_FUNCTIONS_HEADER
+#define TEST_FUNCTIONS_HEADER
+
+#include <span>
+#include <cmath>
+#include <numbers>
+
+namespace dl
+{
+
+// Standard minimization benchmarks, all with a global minimum of 0
+struct TestFunction
+{
+    const char* name;
+    // search interval of every variable
+    double start;
+    double end;
+    // objective value counted as "target reached" by the time-to-target benchmarks
+    double target;
+    double (*value)(std::span<const double> x);
+};
+
+inline double rastrigin(std::span<const double> x) {
+    double sum = 10.0 * x.size();
+    for (const double xi : x)
+        sum += xi * xi - 10.0 * std::cos(2.0 * std::numbers::pi * xi);
+    return sum;
+}
+
+inline double rosenbrock(std::span<const double> x) {
+    double sum = 0;
+    for (size_t i = 0; i + 1 < x.size(); ++i)
+        sum += 100.0 * (x[i + 1] - x[i] * x[i]) * (x[i + 1] - x[i] * x[i]) + (1.0 - x[i]) * (1.0 - x[i]);
+    return sum;
+}
+
+inline double ackley(std::span<const double> x) {
+    double squares = 0, cosines = 0;
+    for (const double xi : x) {
+        squares += xi * xi;
+        cosines += std::cos(2.0 * std::numbers::pi * xi);
+    }
+    const double n = static_cast<double>(x.size());
+    return -20.0 * std::exp(-0.2 * std::sqrt(squares / n)) - std::exp(cosines / n) + 20.0 + std::numbers::e;
+}
+
+inline double schwefel(std::span<const double> x) {
+    double sum = 418.9828872724338 * x.size();
+    for (const double xi : x)
+        sum -= xi * std::sin(std::sqrt(std::abs(xi)));
+    return sum;
+}
+
+inline constexpr TestFunction test_functions[] = {
+    {"rastrigin", -5.12, 5.12, 1.0, rastrigin},
+    {"rosenbrock", -2.048, 2.048, 1.0, rosenbrock},
+    {"ackley", -32.768, 32.768, 0.1, ackley},
+    {"schwefel", -500.0, 500.0, 10.0, schwefel},
+};
+
+} // namespace dl
+
+#endif // #define TEST_FUNCTIONS_HEADER
@@ -0,0 +1,113 @@
+#ifndef ARENA_HEADER
+#define ARENA_HEADER
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <omp.h>
+
+#include "population.h"
+
+namespace dl
+{
+
+// Bump allocator for scratch memory: allocate() hands out uninitialized spans from one block
+// and reset() releases all of them at once. Requests beyond the block go to overflow chunks
+// that the next reset() merges into a single larger block, so a workload repeating every
+// generation stops reaching the heap after its first round
+class ScratchArena
+{
+    static constexpr size_t alignment = alignof(std::max_align_t);
+
+    std::unique_ptr<std::byte[]> m_block;
+    size_t m_capacity = 0;
+    size_t m_used = 0;
+    std::vector<std::unique_ptr<std::byte[]>> m_overflow;
+    // bytes requested since the last reset, alignment padding included
+    size_t m_requested = 0;
+public:
+    template <typename T>
+    std::span<T> allocate(size_t count) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= alignment, "arena holds plain values only");
+        const size_t bytes = (count * sizeof(T) + alignment - 1) / alignment * alignment;
+        m_requested += bytes;
+        if (m_used + bytes <= m_capacity) {
+            T* values = reinterpret_cast<T*>(m_block.get() + m_used);
+            m_used += bytes;
+            return {values, count};
+        }
+
+        m_overflow.emplace_back(new std::byte[std::max<size_t>(bytes, 1)]);
+        return {reinterpret_cast<T*>(m_overflow.back().get()), count};
+    }
+
+    // invalidates every span handed out so far
+    void reset() {
+        if (!m_overflow.empty()) {
+            m_capacity = std::max(2 * m_capacity, m_requested);
+            m_block.reset(new std::byte[m_capacity]);
+            m_overflow.clear();
+        }
+        m_used = 0;
+        m_requested = 0;
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+};
+
+// Memory an optimizer lends its passes for one generation (see PassContext): a spare
+// population that passes rebuilding the population fill and swap with the current one, and a
+// ScratchArena per OpenMP thread. Keeping it out of the passes lets them stay stateless, and
+// the optimizer's two population buffers stop growing once they reached their peak size
+class GenerationArena
+{
+    Population m_spare;
+    Population m_elites;
+    FitRanking m_ranking;
+    std::vector<ScratchArena> m_scratch;
+    // active parallel level the optimizer runs at, e.g. 1 on an island thread
+    int m_level = 0;
+public:
+    GenerationArena() {
+        prepare();
+    }
+
+    // called before every pass: resets the scratch arenas and adds one for every thread the
+    // next parallel region may use
+    void prepare() {
+        m_level = omp_get_active_level();
+        const size_t threads = static_cast<size_t>(std::max(omp_get_max_threads(), 1));
+        if (m_scratch.size() < threads)
+            m_scratch.resize(threads);
+        for (auto& scratch : m_scratch)
+            scratch.reset();
+    }
+
+    Population& spare() {
+        return m_spare;
+    }
+
+    // individuals a pass sets aside in run() and puts back in complete(), kept for the
+    // whole generation
+    Population& elites() {
+        return m_elites;
+    }
+
+    FitRanking& ranking() {
+        return m_ranking;
+    }
+
+    // arena of the calling thread, inside or outside of the passes' parallel regions
+    ScratchArena& scratch() {
+        return m_scratch[omp_get_active_level() > m_level ? static_cast<size_t>(omp_get_thread_num()) : 0];
+    }
+};
+
+} // namespace dl
+
+#endif // #define ARENA_HEADER
@@ -0,0 +1,97 @@
+#ifndef BATCH_HEADER
+#define BATCH_HEADER
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <algorithm>
+#include <omp.h>
+
+#include "genetic_optimizer.h"
+#include "scheduler.h"
+
+namespace dl
+{
+
+// Runs many independent optimizations over one shared WorkStealingScheduler. Every worker owns a
+// GeneticOptimizer that the jobs it runs reset() and reuse, so population buffers and pass
+// scratch stop being allocated once each worker ran its largest job. OpenMP regions inside a
+// job get threads_per_job threads: workers * threads_per_job threads share the machine instead
+// of every worker starting a team as large as the machine
+class BatchRunner
+{
+public:
+    // runs one job on the optimizer of the worker it landed on; the job registers its passes
+    // after optimizer.reset(...) and reports its own results
+    using Job = std::function<void(GeneticOptimizer& optimizer)>;
+private:
+    std::vector<std::unique_ptr<GeneticOptimizer>> m_optimizers;
+    size_t m_threads_per_job;
+    size_t m_max_pending;
+
+    std::mutex m_mutex;
+    std::condition_variable m_slot;
+    size_t m_pending = 0;
+
+    // declared last: its destructor joins the workers before the optimizers go away
+    WorkStealingScheduler m_scheduler;
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_slot.notify_one();
+    }
+public:
+    // max_pending: jobs queued or running at once, 0 for four per worker
+    explicit BatchRunner(size_t workers = std::thread::hardware_concurrency(), size_t threads_per_job = 1, size_t max_pending = 0) :
+        m_threads_per_job(std::max<size_t>(threads_per_job, 1)),
+        m_max_pending(max_pending ? max_pending : 4 * std::max<size_t>(workers, 1)),
+        m_scheduler(workers) {
+        for (size_t i = 0; i < m_scheduler.threads(); ++i)
+            m_optimizers.push_back(std::make_unique<GeneticOptimizer>(0, 0, 0));
+    }
+
+    size_t workers() const {
+        return m_scheduler.threads();
+    }
+
+    size_t threads_per_job() const {
+        return m_threads_per_job;
+    }
+
+    // Blocks while max_pending jobs are queued or running, so a stream of jobs is read at the
+    // pace it is solved. Call from outside the workers. A job that throws makes wait() rethrow
+    void submit(Job job) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_slot.wait(lock, [this] { return m_pending < m_max_pending; });
+            m_pending++;
+        }
+
+        m_scheduler.submit([this, job = std::move(job)] {
+            struct Release
+            {
+                BatchRunner* runner;
+                ~Release() { runner->release(); }
+            } release{this};
+
+            // the thread count is a per-thread setting, the worker keeps it for later jobs
+            omp_set_num_threads(static_cast<int>(m_threads_per_job));
+            job(*m_optimizers[m_scheduler.current_worker()]);
+        });
+    }
+
+    // blocks until every submitted job finished
+    void wait() {
+        m_scheduler.wait();
+    }
+};
+
+} // namespace dl
+
+#endif // #define BATCH_HEADER
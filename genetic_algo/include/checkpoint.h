@@ -0,0 +1,515 @@
+#ifndef CHECKPOINT_HEADER
+#define CHECKPOINT_HEADER
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <span>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pass.h"
+#include "fitness.h"
+
+namespace dl
+{
+
+// Binary snapshot of a GeneticOptimizer run, in native byte order:
+//   CheckpointHeader | pass configuration | pass states | genomes | fits | generations | dirty flags
+//   | velocities | best fits | best genomes (the last three only with swarm state)
+// Every section starts at a multiple of checkpoint_alignment, so a mapped file can be read in
+// place. Random state is not stored: the streams of a run are a pure function of its seed and
+// the generation (see RandomSource), so both restore every stream of every thread
+inline constexpr uint64_t checkpoint_magic = 0x54504b4341474c44ull; // "DLGACKPT"
+inline constexpr uint32_t checkpoint_version = 2;
+inline constexpr size_t checkpoint_alignment = 64;
+
+struct CheckpointHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t file_bytes;
+
+    uint64_t seed;
+    // generations completed
+    uint64_t generation;
+    uint64_t size;
+    uint64_t variables;
+    uint64_t bits;
+    uint64_t with_swarm_state;
+
+    uint64_t evaluations;
+    uint64_t skipped;
+    uint64_t cache_lookups;
+    uint64_t cache_hits;
+
+    // per pass: [name length][name, padded to 8 bytes][parameter count][parameters]
+    uint64_t passes;
+    uint64_t configuration_offset;
+    uint64_t configuration_bytes;
+
+    // per pass: [value count][values][word count][words]
+    uint64_t pass_states_offset;
+    uint64_t pass_states_bytes;
+
+    uint64_t genomes_offset;
+    uint64_t fits_offset;
+    uint64_t generations_offset;
+    uint64_t dirty_offset;
+    uint64_t velocities_offset;
+    uint64_t best_fits_offset;
+    uint64_t best_genomes_offset;
+};
+
+namespace detail
+{
+
+inline size_t align_checkpoint(size_t offset) {
+    return (offset + checkpoint_alignment - 1) / checkpoint_alignment * checkpoint_alignment;
+}
+
+inline size_t padded_name_bytes(size_t length) {
+    return (length + 7) / 8 * 8;
+}
+
+// appends [count][values] of 8-byte values
+template <typename T>
+void append_counted(std::vector<std::byte>& buffer, std::span<const T> values) {
+    static_assert(sizeof(T) == 8, "counted checkpoint values are 8 bytes wide");
+    const uint64_t count = values.size();
+    const size_t at = buffer.size();
+    buffer.resize(at + 8 + values.size_bytes());
+    std::memcpy(buffer.data() + at, &count, 8);
+    if (count)
+        std::memcpy(buffer.data() + at + 8, values.data(), values.size_bytes());
+}
+
+// reads what append_counted wrote, advancing at; throws past end
+template <typename T>
+std::vector<T> read_counted(const std::byte*& at, const std::byte* end) {
+    uint64_t count = 0;
+    if (end - at < 8)
+        throw std::runtime_error("corrupt checkpoint pass section");
+    std::memcpy(&count, at, 8);
+    at += 8;
+    if (static_cast<uint64_t>(end - at) / sizeof(T) < count)
+        throw std::runtime_error("corrupt checkpoint pass section");
+    std::vector<T> values(count);
+    if (count)
+        std::memcpy(values.data(), at, count * sizeof(T));
+    at += count * sizeof(T);
+    return values;
+}
+
+template <typename T>
+void append_section(std::vector<std::byte>& buffer, uint64_t& offset, std::span<const T> values) {
+    offset = align_checkpoint(buffer.size());
+    buffer.resize(offset + values.size_bytes());
+    if (!values.empty())
+        std::memcpy(buffer.data() + offset, values.data(), values.size_bytes());
+}
+
+} // namespace detail
+
+// Serializes the run state into buffer, reusing its capacity
+inline void write_checkpoint(std::vector<std::byte>& buffer, uint64_t seed, size_t generation, const EvaluationStatistics& statistics,
+    const Population& population, std::span<const std::unique_ptr<PopulationPass>> passes, std::span<const PassState> states) {
+    if (states.size() != passes.size())
+        throw std::runtime_error("checkpoint needs the state of every pass");
+
+    CheckpointHeader header{};
+    header.magic = checkpoint_magic;
+    header.version = checkpoint_version;
+    header.header_bytes = sizeof(CheckpointHeader);
+    header.seed = seed;
+    header.generation = generation;
+    header.size = population.size();
+    header.variables = population.layout().variables;
+    header.bits = population.layout().bits;
+    header.with_swarm_state = population.with_swarm_state();
+    header.evaluations = statistics.evaluations;
+    header.skipped = statistics.skipped;
+    header.cache_lookups = statistics.cache_lookups;
+    header.cache_hits = statistics.cache_hits;
+    header.passes = passes.size();
+
+    buffer.clear();
+    buffer.resize(detail::align_checkpoint(sizeof(CheckpointHeader)));
+
+    header.configuration_offset = buffer.size();
+    for (const auto& pass : passes) {
+        const std::string_view name = pass->name();
+        const std::vector<double> parameters = pass->configuration();
+        const uint64_t name_length = name.size(), count = parameters.size();
+
+        size_t at = buffer.size();
+        buffer.resize(at + 16 + detail::padded_name_bytes(name.size()) + parameters.size() * sizeof(double));
+        std::memcpy(buffer.data() + at, &name_length, 8);
+        std::memcpy(buffer.data() + at + 8, name.data(), name.size());
+        at += 8 + detail::padded_name_bytes(name.size());
+        std::memcpy(buffer.data() + at, &count, 8);
+        if (count)
+            std::memcpy(buffer.data() + at + 8, parameters.data(), parameters.size() * sizeof(double));
+    }
+    header.configuration_bytes = buffer.size() - header.configuration_offset;
+
+    buffer.resize(detail::align_checkpoint(buffer.size()));
+    header.pass_states_offset = buffer.size();
+    for (const PassState& state : states) {
+        detail::append_counted(buffer, std::span<const double>(state.values));
+        detail::append_counted(buffer, std::span<const uint64_t>(state.words));
+    }
+    header.pass_states_bytes = buffer.size() - header.pass_states_offset;
+
+    detail::append_section(buffer, header.genomes_offset, population.genomes());
+    detail::append_section(buffer, header.fits_offset, population.fits());
+    detail::append_section(buffer, header.generations_offset, population.generations());
+    detail::append_section(buffer, header.dirty_offset, population.dirty());
+    detail::append_section(buffer, header.velocities_offset, population.velocities());
+    detail::append_section(buffer, header.best_fits_offset, population.best_fits());
+    detail::append_section(buffer, header.best_genomes_offset, population.best_genomes());
+
+    header.file_bytes = buffer.size();
+    std::memcpy(buffer.data(), &header, sizeof(header));
+}
+
+// Writes the bytes to path + ".tmp", syncs them and renames the file over path, so path always
+// holds a complete checkpoint even if the process dies while writing
+inline void write_checkpoint_file(const std::string& path, std::span<const std::byte> bytes) {
+    const std::string temporary = path + ".tmp";
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("failed to create checkpoint " + temporary + ": " + std::strerror(errno));
+
+    size_t written = 0;
+    while (written < bytes.size()) {
+        const ssize_t result = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::runtime_error("failed to write checkpoint " + temporary + ": " + std::strerror(error));
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    // the descriptor is closed even if the sync fails, the first error is reported
+    const int sync_error = ::fsync(fd) != 0 ? errno : 0;
+    const int close_error = ::close(fd) != 0 ? errno : 0;
+    if (sync_error || close_error)
+        throw std::runtime_error("failed to sync checkpoint " + temporary + ": " + std::strerror(sync_error ? sync_error : close_error));
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("failed to replace checkpoint " + path + ": " + std::strerror(errno));
+}
+
+// Read-only memory mapping of a checkpoint file. The header and section bounds are validated
+// on open; restoring copies the sections straight from the page cache, no individual is
+// re-evaluated
+class Checkpoint
+{
+    void* m_memory = nullptr;
+    size_t m_bytes = 0;
+    CheckpointHeader m_header{};
+
+    template <typename T>
+    std::span<const T> section(uint64_t offset, size_t count) const {
+        return {reinterpret_cast<const T*>(static_cast<const std::byte*>(m_memory) + offset), count};
+    }
+
+    void validate() const {
+        const CheckpointHeader& h = m_header;
+        if (h.magic != checkpoint_magic)
+            throw std::runtime_error("not a checkpoint file");
+        if (h.version != checkpoint_version)
+            throw std::runtime_error("unsupported checkpoint version " + std::to_string(h.version));
+        if (h.header_bytes != sizeof(CheckpointHeader) || h.file_bytes != m_bytes)
+            throw std::runtime_error("truncated checkpoint");
+        if (h.variables == 0 || h.bits == 0 || h.bits > 64)
+            throw std::runtime_error("invalid checkpoint genome layout");
+        // the genome words must fit into the file before any section size is computed from them
+        if (h.variables > m_bytes / sizeof(Genome::GenomeType) || h.size > m_bytes / (h.variables * sizeof(Genome::GenomeType)))
+            throw std::runtime_error("corrupt checkpoint population size");
+
+        const size_t words = h.size * h.variables;
+        const size_t swarm = h.with_swarm_state ? 1 : 0;
+        const auto fits = [this](uint64_t offset, size_t bytes) {
+            return offset % checkpoint_alignment == 0 && offset <= m_bytes && bytes <= m_bytes - offset;
+        };
+        if (!fits(h.configuration_offset, h.configuration_bytes) ||
+            !fits(h.pass_states_offset, h.pass_states_bytes) ||
+            !fits(h.genomes_offset, words * sizeof(Genome::GenomeType)) ||
+            !fits(h.fits_offset, h.size * sizeof(double)) ||
+            !fits(h.generations_offset, h.size * sizeof(uint32_t)) ||
+            !fits(h.dirty_offset, h.size) ||
+            !fits(h.velocities_offset, swarm * words * sizeof(double)) ||
+            !fits(h.best_fits_offset, swarm * h.size * sizeof(double)) ||
+            !fits(h.best_genomes_offset, swarm * words * sizeof(Genome::GenomeType)))
+            throw std::runtime_error("corrupt checkpoint sections");
+    }
+public:
+    struct PassConfiguration
+    {
+        std::string_view name;
+        std::vector<double> parameters;
+    };
+
+    explicit Checkpoint(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("failed to open checkpoint " + path + ": " + std::strerror(errno));
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0) {
+            ::close(fd);
+            throw std::runtime_error("failed to stat checkpoint " + path + ": " + std::strerror(errno));
+        }
+        m_bytes = static_cast<size_t>(status.st_size);
+        if (m_bytes < sizeof(CheckpointHeader)) {
+            ::close(fd);
+            throw std::runtime_error("truncated checkpoint " + path);
+        }
+
+        m_memory = mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m_memory == MAP_FAILED) {
+            m_memory = nullptr;
+            throw std::runtime_error("failed to map checkpoint " + path + ": " + std::strerror(errno));
+        }
+        madvise(m_memory, m_bytes, MADV_SEQUENTIAL);
+
+        std::memcpy(&m_header, m_memory, sizeof(CheckpointHeader));
+        try {
+            validate();
+        } catch (...) {
+            munmap(m_memory, m_bytes);
+            throw;
+        }
+    }
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    ~Checkpoint() {
+        if (m_memory)
+            munmap(m_memory, m_bytes);
+    }
+
+    const CheckpointHeader& header() const {
+        return m_header;
+    }
+
+    uint64_t seed() const {
+        return m_header.seed;
+    }
+
+    size_t generation() const {
+        return m_header.generation;
+    }
+
+    size_t size() const {
+        return m_header.size;
+    }
+
+    GenomeLayout layout() const {
+        return GenomeLayout{m_header.variables, m_header.bits};
+    }
+
+    EvaluationStatistics statistics() const {
+        return EvaluationStatistics{m_header.evaluations, m_header.skipped, m_header.cache_lookups, m_header.cache_hits};
+    }
+
+    std::span<const Genome::GenomeType> genomes() const {
+        return section<Genome::GenomeType>(m_header.genomes_offset, m_header.size * m_header.variables);
+    }
+
+    std::span<const double> fits() const {
+        return section<double>(m_header.fits_offset, m_header.size);
+    }
+
+    std::vector<PassConfiguration> passes() const {
+        std::vector<PassConfiguration> passes;
+        const std::byte* at = static_cast<const std::byte*>(m_memory) + m_header.configuration_offset;
+        const std::byte* end = at + m_header.configuration_bytes;
+        for (uint64_t i = 0; i < m_header.passes; ++i) {
+            uint64_t name_length = 0;
+            if (end - at < 8)
+                throw std::runtime_error("corrupt checkpoint pass configuration");
+            std::memcpy(&name_length, at, 8);
+            if (name_length > static_cast<uint64_t>(end - at - 8) ||
+                static_cast<uint64_t>(end - at - 8) < detail::padded_name_bytes(name_length) + 8)
+                throw std::runtime_error("corrupt checkpoint pass configuration");
+            const std::string_view name(reinterpret_cast<const char*>(at + 8), name_length);
+            at += 8 + detail::padded_name_bytes(name_length);
+            passes.push_back(PassConfiguration{name, detail::read_counted<double>(at, end)});
+        }
+        return passes;
+    }
+
+    // what every pass carried across generations when the checkpoint was taken
+    std::vector<PassState> pass_states() const {
+        // every state takes at least its two counts
+        if (m_header.passes > m_header.pass_states_bytes / 16)
+            throw std::runtime_error("corrupt checkpoint pass section");
+        std::vector<PassState> states(m_header.passes);
+        const std::byte* at = static_cast<const std::byte*>(m_memory) + m_header.pass_states_offset;
+        const std::byte* end = at + m_header.pass_states_bytes;
+        for (PassState& state : states) {
+            state.values = detail::read_counted<double>(at, end);
+            state.words = detail::read_counted<uint64_t>(at, end);
+        }
+        return states;
+    }
+
+    // throws unless passes have the names and configurations of the checkpointed pipeline
+    void check_pipeline(std::span<const std::unique_ptr<PopulationPass>> passes) const {
+        const auto stored = this->passes();
+        if (stored.size() != passes.size())
+            throw std::runtime_error("checkpoint was taken with " + std::to_string(stored.size()) + " passes, pipeline has "
+                + std::to_string(passes.size()));
+        for (size_t i = 0; i < passes.size(); ++i) {
+            if (stored[i].name != passes[i]->name() || stored[i].parameters != passes[i]->configuration())
+                throw std::runtime_error("checkpoint pass " + std::to_string(i) + " (" + std::string(stored[i].name)
+                    + ") does not match the pipeline");
+        }
+    }
+
+    void restore(std::vector<PassState>& states) const {
+        states = pass_states();
+    }
+
+    // replaces population with the checkpointed individuals
+    void restore(Population& population) const {
+        const size_t size = m_header.size;
+        const size_t words = size * m_header.variables;
+        population = Population(size, layout(), m_header.with_swarm_state);
+
+        const auto copy = [](auto destination, auto source) {
+            if (!source.empty())
+                std::memcpy(destination.data(), source.data(), source.size_bytes());
+        };
+        copy(population.genomes(), genomes());
+        copy(population.fits(), fits());
+        copy(population.generations(), section<uint32_t>(m_header.generations_offset, size));
+        copy(population.dirty(), section<uint8_t>(m_header.dirty_offset, size));
+        if (m_header.with_swarm_state) {
+            copy(population.velocities(), section<double>(m_header.velocities_offset, words));
+            copy(population.best_fits(), section<double>(m_header.best_fits_offset, size));
+            copy(population.best_genomes(), section<Genome::GenomeType>(m_header.best_genomes_offset, words));
+        }
+    }
+};
+
+// Writes checkpoints on a background thread. submit() serializes the state into the pending
+// buffer, only blocking for that copy, while the writer thread owns the other buffer and does
+// the I/O. A snapshot submitted while the previous one is still pending replaces it, so a slow
+// disk never stalls the optimizer, it only skips intermediate checkpoints
+class CheckpointWriter
+{
+    std::string m_path;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::byte> m_pending;
+    std::vector<std::byte> m_writing;
+    bool m_has_pending = false;
+    bool m_busy = false;
+    bool m_stop = false;
+    size_t m_written = 0;
+    std::exception_ptr m_error;
+
+    std::thread m_thread;
+
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_condition.wait(lock, [this] { return m_has_pending || m_stop; });
+            if (!m_has_pending)
+                return;
+
+            m_pending.swap(m_writing);
+            m_has_pending = false;
+            m_busy = true;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                write_checkpoint_file(m_path, m_writing);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            m_busy = false;
+            if (error)
+                m_error = error;
+            else
+                m_written++;
+            m_condition.notify_all();
+        }
+    }
+public:
+    explicit CheckpointWriter(std::string path) :
+        m_path(std::move(path)),
+        m_thread(&CheckpointWriter::write_loop, this) {}
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // pending snapshots are written before the thread exits
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    const std::string& path() const {
+        return m_path;
+    }
+
+    // serialize(buffer) fills the pending buffer, reusing its capacity
+    void submit(const std::function<void(std::vector<std::byte>&)>& serialize) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            serialize(m_pending);
+            m_has_pending = true;
+        }
+        m_condition.notify_all();
+    }
+
+    // waits until every submitted snapshot is on disk, rethrows the first write error
+    void flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return (!m_has_pending && !m_busy) || m_error; });
+        if (m_error)
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+    // checkpoints completed so far
+    size_t written() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_written;
+    }
+};
+
+} // namespace dl
+
+#endif // #define CHECKPOINT_HEADER
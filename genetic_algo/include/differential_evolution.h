@@ -0,0 +1,298 @@
+#ifndef DIFFERENTIAL_EVOLUTION_HEADER
+#define DIFFERENTIAL_EVOLUTION_HEADER
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <numbers>
+#include <utility>
+#include <tuple>
+#include <limits>
+#include <initializer_list>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "rng.h"
+#include "pass.h"
+
+namespace dl
+{
+
+// Differential evolution as a GeneticOptimizer pass. Every variable of a genome is decoded to a
+// coordinate in [0, 1] (see GenomeLayout::to_unit); run() replaces every individual, the target,
+// by a trial built from the differences of other targets, and evaluated() keeps the better of
+// target and trial once the trial has its fit. Targets wait for their trials in the swarm state
+// of the population, so the pass must not share a pipeline with a swarm pass, and should be the
+// first pass: passes before it see targets, passes after it see trials. Keeping the better of
+// every pair makes elitism redundant.
+//
+// Mutation and crossover run as flat loops over the coordinates of the whole population, with the
+// donor rows of every individual gathered first and random numbers drawn from counters
+class DifferentialEvolutionPass : public PopulationPass {
+public:
+    enum DifferentialEvolutionStrategy {
+        // v = x_r1 + F (x_r2 - x_r3)
+        RAND_1_BIN,
+        // v = x_best + F (x_r1 - x_r2)
+        BEST_1_BIN,
+        // JADE: v = x_i + F_i (x_pbest - x_i) + F_i (x_r1 - x_r2), with F_i and CR_i drawn around
+        // means that follow the values of successful trials; without JADE's optional archive
+        JADE,
+        INVALID_STRATEGY,
+    };
+private:
+    DifferentialEvolutionStrategy m_strategy;
+    double m_scale;
+    double m_crossover_rate;
+    // JADE: share of the fittest individuals x_pbest is drawn from, and adaptation rate of the means
+    double m_greediness;
+    double m_adaptation_rate;
+
+    // JADE means, kept in the pass state of the run as {scale, crossover rate}
+    struct Adaptation
+    {
+        double scale = 0.5;
+        double crossover_rate = 0.5;
+    };
+
+    static Adaptation adaptation(const PassState* state) {
+        if (!state || state->values.size() != 2)
+            return Adaptation{};
+        return Adaptation{state->values[0], state->values[1]};
+    }
+
+    // F and CR of one individual, the first draws of its stream so that evaluated() can redraw them
+    std::pair<double, double> parameters(RandomEngine& engine, const Adaptation& means) const {
+        if (m_strategy != JADE)
+            return {m_scale, m_crossover_rate};
+
+        // CR ~ N(mean, 0.1) clipped to [0, 1], F ~ Cauchy(mean, 0.1) truncated to 1 and redrawn until positive
+        const double u1 = engine.uniform(), u2 = engine.uniform();
+        const double normal = std::sqrt(-2.0 * std::log(1.0 - u1)) * std::cos(2.0 * std::numbers::pi * u2);
+        const double crossover_rate = std::clamp(means.crossover_rate + 0.1 * normal, 0.0, 1.0);
+        double scale = 0;
+        while (scale <= 0)
+            scale = means.scale + 0.1 * std::tan(std::numbers::pi * (engine.uniform() - 0.5));
+        return {std::min(scale, 1.0), crossover_rate};
+    }
+
+    // index in [0, size) other than the excluded ones
+    static size_t pick(RandomEngine& engine, size_t size, std::initializer_list<size_t> excluded) {
+        while (true) {
+            const size_t index = engine.bounded(size);
+            if (std::find(excluded.begin(), excluded.end(), index) == excluded.end())
+                return index;
+        }
+    }
+public:
+    explicit DifferentialEvolutionPass(DifferentialEvolutionStrategy strategy = RAND_1_BIN, double scale = 0.5,
+        double crossover_rate = 0.9, double greediness = 0.05, double adaptation_rate = 0.1) :
+        m_strategy(strategy),
+        m_scale(scale),
+        m_crossover_rate(crossover_rate),
+        m_greediness(greediness),
+        m_adaptation_rate(adaptation_rate) {
+        if (m_strategy < RAND_1_BIN || m_strategy >= INVALID_STRATEGY)
+            throw std::runtime_error("unknown differential evolution strategy");
+    }
+
+    bool needs_swarm_state() const override {
+        return true;
+    }
+
+    // the one-to-one selection runs in evaluated()
+    bool selects_evaluated() const override {
+        return true;
+    }
+
+    const char* name() const override {
+        return "differential_evolution";
+    }
+
+    std::vector<double> configuration() const override {
+        return {static_cast<double>(m_strategy), m_scale, m_crossover_rate, m_greediness, m_adaptation_rate};
+    }
+
+    // JADE means of a run, from the state the optimizer keeps for the pass
+    static double scale_mean(const PassState& state) {
+        return adaptation(&state).scale;
+    }
+
+    static double crossover_rate_mean(const PassState& state) {
+        return adaptation(&state).crossover_rate;
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        const size_t size = population.size();
+        if (size == 0)
+            return;
+        if (size < 4)
+            throw std::runtime_error("differential evolution needs at least 4 individuals");
+
+        std::optional<GenerationArena> local_arena;
+        GenerationArena& arena = context.arena ? *context.arena : local_arena.emplace();
+        ScratchArena& scratch = arena.scratch();
+
+        population.enable_swarm_state();
+        const GenomeLayout& layout = population.layout();
+        const size_t dimensions = population.words();
+        const size_t coordinates = size * dimensions;
+        const auto genomes = population.genomes();
+        const auto fits = population.fits();
+        const auto dirty = population.dirty();
+        const auto targets = population.best_genomes();
+        const auto target_fits = population.best_fits();
+
+        // the current individuals become the targets
+        const auto x = scratch.allocate<double>(coordinates);
+        #pragma omp parallel for
+        for (size_t i = 0; i < size; ++i) {
+            target_fits[i] = dirty[i] ? Population::no_fit : fits[i];
+            for (size_t k = i * dimensions; k < (i + 1) * dimensions; ++k) {
+                targets[k] = genomes[k];
+                x[k] = layout.to_unit(genomes[k]);
+            }
+        }
+
+        std::span<const size_t> order;
+        if (m_strategy != RAND_1_BIN) {
+            const size_t fittest = m_strategy == BEST_1_BIN ? 1 :
+                std::clamp<size_t>(static_cast<size_t>(std::lround(m_greediness * size)), 1, size);
+            arena.ranking().rank(population, fittest, 0);
+            order = arena.ranking().order().first(fittest);
+        }
+
+        // donor rows and per coordinate F and CR; a CR above 1 forces the coordinate of the
+        // individual that always comes from the mutant
+        const auto base = scratch.allocate<double>(coordinates);
+        const auto plus = scratch.allocate<double>(coordinates);
+        const auto minus = scratch.allocate<double>(coordinates);
+        const auto fittest = m_strategy == JADE ? scratch.allocate<double>(coordinates) : base;
+        const auto scales = scratch.allocate<double>(coordinates);
+        const auto rates = scratch.allocate<double>(coordinates);
+
+        const Adaptation means = adaptation(context.state);
+        const RandomSource individuals_random = context.random.fork(0);
+        #pragma omp parallel for
+        for (size_t i = 0; i < size; ++i) {
+            RandomEngine engine = individuals_random.stream(i);
+            const auto [scale, crossover_rate] = parameters(engine, means);
+
+            size_t donors[4];
+            switch (m_strategy) {
+                case RAND_1_BIN:
+                    donors[0] = pick(engine, size, {i});
+                    donors[1] = pick(engine, size, {i, donors[0]});
+                    donors[2] = pick(engine, size, {i, donors[0], donors[1]});
+                    donors[3] = donors[0];
+                    break;
+                case BEST_1_BIN:
+                    donors[0] = order.front();
+                    donors[1] = pick(engine, size, {i, donors[0]});
+                    donors[2] = pick(engine, size, {i, donors[0], donors[1]});
+                    donors[3] = donors[0];
+                    break;
+                default:
+                    donors[0] = i;
+                    donors[1] = pick(engine, size, {i});
+                    donors[2] = pick(engine, size, {i, donors[1]});
+                    donors[3] = order[engine.bounded(order.size())];
+                    break;
+            }
+
+            const size_t row = i * dimensions;
+            std::copy_n(x.begin() + donors[0] * dimensions, dimensions, base.begin() + row);
+            std::copy_n(x.begin() + donors[1] * dimensions, dimensions, plus.begin() + row);
+            std::copy_n(x.begin() + donors[2] * dimensions, dimensions, minus.begin() + row);
+            if (m_strategy == JADE)
+                std::copy_n(x.begin() + donors[3] * dimensions, dimensions, fittest.begin() + row);
+            std::fill_n(scales.begin() + row, dimensions, scale);
+            std::fill_n(rates.begin() + row, dimensions, crossover_rate);
+            rates[row + engine.bounded(dimensions)] = 2.0;
+        }
+
+        const uint64_t crossover_key = context.random.fork(1).key();
+        const double greedy = m_strategy == JADE ? 1.0 : 0.0;
+        constexpr size_t block = 64;
+        const size_t blocks = (size + block - 1) / block;
+        #pragma omp parallel for
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t begin = b * block, end = std::min(begin + block, size);
+
+            // mutation and binomial crossover; coordinates leaving [0, 1] land halfway between
+            // the target and the violated bound
+            #pragma omp simd
+            for (size_t k = begin * dimensions; k < end * dimensions; ++k) {
+                const double mutant = base[k] + scales[k] * (plus[k] - minus[k]) + greedy * scales[k] * (fittest[k] - base[k]);
+                const double repaired = mutant < 0.0 ? 0.5 * x[k] : mutant > 1.0 ? 0.5 * (x[k] + 1.0) : mutant;
+                x[k] = uniform_at(crossover_key, k + 1) < rates[k] ? repaired : x[k];
+            }
+
+            for (size_t i = begin; i < end; ++i) {
+                bool changed = false;
+                for (size_t k = i * dimensions; k < (i + 1) * dimensions; ++k) {
+                    const Genome::GenomeType trial = layout.from_unit(x[k]);
+                    changed |= trial != genomes[k];
+                    genomes[k] = trial;
+                }
+                if (changed)
+                    population.mark_dirty(i);
+            }
+        }
+    }
+
+    // one-to-one selection: a trial worse than its target is replaced by the target; JADE moves
+    // its means towards the F and CR of the trials that were kept, without a pass state they
+    // stay at their initial values
+    void evaluated(Population& population, const PassContext& context) const override {
+        const size_t size = population.size();
+        const size_t dimensions = population.words();
+        const auto genomes = population.genomes();
+        const auto fits = population.fits();
+        const auto targets = population.best_genomes();
+        const auto target_fits = population.best_fits();
+        const RandomSource individuals_random = context.random.fork(0);
+        const Adaptation means = adaptation(context.state);
+
+        // F and CR of every kept trial, NaN for the others
+        std::optional<GenerationArena> local_arena;
+        GenerationArena& arena = context.arena ? *context.arena : local_arena.emplace();
+        const auto kept_scales = arena.scratch().allocate<double>(size);
+        const auto kept_rates = arena.scratch().allocate<double>(size);
+        #pragma omp parallel for
+        for (size_t i = 0; i < size; ++i) {
+            kept_scales[i] = std::numeric_limits<double>::quiet_NaN();
+            if (fits[i] < target_fits[i]) {
+                std::copy_n(targets.begin() + i * dimensions, dimensions, genomes.begin() + i * dimensions);
+                population.set_fit(i, target_fits[i]);
+            } else if (m_strategy == JADE) {
+                RandomEngine engine = individuals_random.stream(i);
+                std::tie(kept_scales[i], kept_rates[i]) = parameters(engine, means);
+            }
+        }
+
+        // accumulate serially: summation order must not depend on the thread count
+        size_t successes = 0;
+        double crossover_rates = 0, scales = 0, squared_scales = 0;
+        for (size_t i = 0; i < size; ++i) {
+            if (std::isnan(kept_scales[i]))
+                continue;
+            successes++;
+            crossover_rates += kept_rates[i];
+            scales += kept_scales[i];
+            squared_scales += kept_scales[i] * kept_scales[i];
+        }
+
+        // arithmetic mean of the CRs, Lehmer mean of the Fs
+        if (successes && context.state) {
+            const double c = m_adaptation_rate;
+            context.state->values = {(1 - c) * means.scale + c * squared_scales / scales,
+                (1 - c) * means.crossover_rate + c * crossover_rates / successes};
+        }
+    }
+};
+
+} // namespace dl
+
+#endif // #define DIFFERENTIAL_EVOLUTION_HEADER
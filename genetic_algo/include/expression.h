@@ -0,0 +1,434 @@
+#ifndef EXPRESSION_HEADER
+#define EXPRESSION_HEADER
+
+#include <string>
+#include <vector>
+#include <span>
+#include <map>
+#include <tuple>
+#include <bit>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+
+namespace dl
+{
+
+// Objective given as text, e.g. "x*x*sin(x*x) + 1/(x+0.001)", parsed once into register
+// bytecode and run over batches of points.
+//
+// Grammar: numbers, the variables named at construction, the constants pi and e, + - * /,
+// ^ (right associative, binds tighter than unary minus), parentheses, sin cos tan exp log sqrt
+// abs tanh of one argument and pow min max of two. Constant subexpressions are folded and
+// repeated subexpressions computed once. Every instruction runs over a block of points, so the
+// interpreter dispatches once per block instead of once per point and each instruction is a
+// plain loop the compiler vectorizes.
+//
+// operator() has the BatchFitnessFunction signature: row i of x holds the variables of point
+// i, in the order they were named. It is const and may be called from several threads at once
+class Expression
+{
+public:
+    enum Opcode : uint8_t
+    {
+        CONSTANT,
+        VARIABLE,
+        NEG,
+        SIN,
+        COS,
+        TAN,
+        EXP,
+        LOG,
+        SQRT,
+        ABS,
+        TANH,
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        POW,
+        MIN,
+        MAX
+    };
+
+    // points evaluated by one pass over the bytecode
+    static constexpr size_t block = 128;
+private:
+    // parser output in SSA form, operands are earlier nodes
+    struct Node
+    {
+        Opcode op;
+        // operands, the variable index of a VARIABLE
+        size_t a = 0;
+        size_t b = 0;
+        // value of a CONSTANT
+        double value = 0;
+    };
+
+    // dst = op(a, b) over one block; a is the variable index of a VARIABLE
+    struct Instruction
+    {
+        Opcode op;
+        uint32_t dst;
+        uint32_t a;
+        uint32_t b;
+    };
+
+    std::string m_text;
+    std::vector<std::string> m_variables;
+    // registers [0, m_constants.size()) hold the constants
+    std::vector<double> m_constants;
+    std::vector<Instruction> m_code;
+    size_t m_registers = 0;
+    size_t m_result = 0;
+
+    static bool is_binary(Opcode op) {
+        return op >= ADD;
+    }
+
+    static double apply(Opcode op, double a, double b) {
+        switch (op) {
+        case NEG: return -a;
+        case SIN: return std::sin(a);
+        case COS: return std::cos(a);
+        case TAN: return std::tan(a);
+        case EXP: return std::exp(a);
+        case LOG: return std::log(a);
+        case SQRT: return std::sqrt(a);
+        case ABS: return std::abs(a);
+        case TANH: return std::tanh(a);
+        case ADD: return a + b;
+        case SUB: return a - b;
+        case MUL: return a * b;
+        case DIV: return a / b;
+        case POW: return std::pow(a, b);
+        case MIN: return std::min(a, b);
+        case MAX: return std::max(a, b);
+        default: return 0;
+        }
+    }
+
+    template <typename Operation>
+    static void unary(double* dst, const double* a, size_t count, Operation operation) {
+        #pragma omp simd
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = operation(a[i]);
+    }
+
+    template <typename Operation>
+    static void binary(double* dst, const double* a, const double* b, size_t count, Operation operation) {
+        #pragma omp simd
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = operation(a[i], b[i]);
+    }
+
+    // recursive descent over the text, emitting folded and deduplicated nodes
+    class Parser
+    {
+        const std::string& m_text;
+        const std::vector<std::string>& m_variables;
+        std::vector<Node>& m_nodes;
+        std::map<std::tuple<Opcode, size_t, size_t, uint64_t>, size_t> m_known;
+        size_t m_position = 0;
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::runtime_error("expression: " + message + " at position " + std::to_string(m_position) + " of \"" + m_text + "\"");
+        }
+
+        void skip_spaces() {
+            while (m_position < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_position])))
+                m_position++;
+        }
+
+        bool accept(char c) {
+            skip_spaces();
+            if (m_position < m_text.size() && m_text[m_position] == c) {
+                m_position++;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c) {
+            if (!accept(c))
+                fail(std::string("expected '") + c + "'");
+        }
+
+        size_t add(const Node& node) {
+            const auto key = std::make_tuple(node.op, node.a, node.b, std::bit_cast<uint64_t>(node.value));
+            const auto known = m_known.find(key);
+            if (known != m_known.end())
+                return known->second;
+            m_nodes.push_back(node);
+            m_known.emplace(key, m_nodes.size() - 1);
+            return m_nodes.size() - 1;
+        }
+
+        size_t constant(double value) {
+            return add(Node{CONSTANT, 0, 0, value});
+        }
+
+        size_t emit(Opcode op, size_t a, size_t b = 0) {
+            if (!is_binary(op))
+                b = a;
+            if (m_nodes[a].op == CONSTANT && m_nodes[b].op == CONSTANT)
+                return constant(apply(op, m_nodes[a].value, m_nodes[b].value));
+            if (op == POW && m_nodes[b].op == CONSTANT && m_nodes[b].value == 2.0)
+                return emit(MUL, a, a);
+            // one node for both operand orders
+            if ((op == ADD || op == MUL || op == MIN || op == MAX) && b < a)
+                std::swap(a, b);
+            return add(Node{op, a, b});
+        }
+
+        size_t sum() {
+            size_t left = product();
+            while (true) {
+                if (accept('+'))
+                    left = emit(ADD, left, product());
+                else if (accept('-'))
+                    left = emit(SUB, left, product());
+                else
+                    return left;
+            }
+        }
+
+        size_t product() {
+            size_t left = signed_power();
+            while (true) {
+                if (accept('*'))
+                    left = emit(MUL, left, signed_power());
+                else if (accept('/'))
+                    left = emit(DIV, left, signed_power());
+                else
+                    return left;
+            }
+        }
+
+        size_t signed_power() {
+            if (accept('-'))
+                return emit(NEG, signed_power());
+            if (accept('+'))
+                return signed_power();
+            const size_t base = primary();
+            if (accept('^'))
+                return emit(POW, base, signed_power());
+            return base;
+        }
+
+        size_t call(const std::string& name) {
+            static const std::map<std::string, Opcode> functions = {
+                {"sin", SIN}, {"cos", COS}, {"tan", TAN}, {"exp", EXP}, {"log", LOG}, {"sqrt", SQRT}, {"abs", ABS},
+                {"tanh", TANH}, {"pow", POW}, {"min", MIN}, {"max", MAX}};
+            const auto function = functions.find(name);
+            if (function == functions.end())
+                fail("unknown function " + name);
+
+            const size_t a = sum();
+            if (!is_binary(function->second)) {
+                expect(')');
+                return emit(function->second, a);
+            }
+            expect(',');
+            const size_t b = sum();
+            expect(')');
+            return emit(function->second, a, b);
+        }
+
+        size_t primary() {
+            skip_spaces();
+            if (m_position == m_text.size())
+                fail("unexpected end");
+
+            const char c = m_text[m_position];
+            if (accept('(')) {
+                const size_t inner = sum();
+                expect(')');
+                return inner;
+            }
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                char* end = nullptr;
+                const double value = std::strtod(m_text.c_str() + m_position, &end);
+                if (end == m_text.c_str() + m_position)
+                    fail("invalid number");
+                m_position = end - m_text.c_str();
+                return constant(value);
+            }
+            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                const size_t begin = m_position;
+                while (m_position < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_position])) || m_text[m_position] == '_'))
+                    m_position++;
+                const std::string name = m_text.substr(begin, m_position - begin);
+
+                if (accept('('))
+                    return call(name);
+                const auto variable = std::find(m_variables.begin(), m_variables.end(), name);
+                if (variable != m_variables.end())
+                    return add(Node{VARIABLE, static_cast<size_t>(variable - m_variables.begin()), 0});
+                if (name == "pi")
+                    return constant(3.141592653589793);
+                if (name == "e")
+                    return constant(2.718281828459045);
+                m_position = begin;
+                fail("unknown variable " + name);
+            }
+            fail(std::string("unexpected '") + c + "'");
+        }
+    public:
+        Parser(const std::string& text, const std::vector<std::string>& variables, std::vector<Node>& nodes) :
+            m_text(text),
+            m_variables(variables),
+            m_nodes(nodes) {}
+
+        // returns the node of the whole text
+        size_t parse() {
+            const size_t root = sum();
+            skip_spaces();
+            if (m_position != m_text.size())
+                fail(std::string("unexpected '") + m_text[m_position] + "'");
+            return root;
+        }
+    };
+
+    // assigns registers to the nodes the root depends on; a register is reused as soon as the
+    // last instruction reading it was emitted
+    void compile(const std::vector<Node>& nodes, size_t root) {
+        std::vector<bool> live(nodes.size(), false);
+        live[root] = true;
+        for (size_t i = root + 1; i-- > 0;) {
+            if (live[i] && nodes[i].op != CONSTANT && nodes[i].op != VARIABLE)
+                live[nodes[i].a] = live[nodes[i].b] = true;
+        }
+
+        std::vector<size_t> last_use(nodes.size(), 0);
+        for (size_t i = 0; i <= root; ++i) {
+            if (live[i] && nodes[i].op != CONSTANT && nodes[i].op != VARIABLE)
+                last_use[nodes[i].a] = last_use[nodes[i].b] = i;
+        }
+        last_use[root] = nodes.size();
+
+        std::vector<uint32_t> registers(nodes.size(), 0);
+        for (size_t i = 0; i <= root; ++i) {
+            if (live[i] && nodes[i].op == CONSTANT) {
+                registers[i] = static_cast<uint32_t>(m_constants.size());
+                m_constants.push_back(nodes[i].value);
+            }
+        }
+
+        std::vector<uint32_t> released;
+        m_registers = m_constants.size();
+        for (size_t i = 0; i <= root; ++i) {
+            const Node& node = nodes[i];
+            if (!live[i] || node.op == CONSTANT)
+                continue;
+
+            Instruction instruction{node.op, 0, static_cast<uint32_t>(node.a), static_cast<uint32_t>(node.b)};
+            if (node.op != VARIABLE) {
+                instruction.a = registers[node.a];
+                instruction.b = registers[node.b];
+                if (nodes[node.a].op != CONSTANT && last_use[node.a] == i)
+                    released.push_back(registers[node.a]);
+                if (node.b != node.a && nodes[node.b].op != CONSTANT && last_use[node.b] == i)
+                    released.push_back(registers[node.b]);
+            }
+            if (released.empty()) {
+                instruction.dst = static_cast<uint32_t>(m_registers++);
+            } else {
+                instruction.dst = released.back();
+                released.pop_back();
+            }
+            registers[i] = instruction.dst;
+            m_code.push_back(instruction);
+        }
+        m_result = registers[root];
+    }
+public:
+    // variables: names of the columns of a row of x
+    explicit Expression(std::string text, std::vector<std::string> variables = {"x"}) :
+        m_text(std::move(text)),
+        m_variables(std::move(variables)) {
+        std::vector<Node> nodes;
+        const size_t root = Parser(m_text, m_variables, nodes).parse();
+        compile(nodes, root);
+    }
+
+    const std::string& text() const {
+        return m_text;
+    }
+
+    const std::vector<std::string>& variables() const {
+        return m_variables;
+    }
+
+    // bytecode instructions run per block, after folding and deduplication
+    size_t instructions() const {
+        return m_code.size();
+    }
+
+    // registers of one block, constants included
+    size_t registers() const {
+        return m_registers;
+    }
+
+    // values[i] = f(x[i * variables], ..., x[i * variables + variables - 1])
+    void operator()(std::span<const double> x, std::span<double> values) const {
+        // per-thread registers, evaluation does not allocate once they reached their size
+        thread_local std::vector<double> t_registers;
+        t_registers.resize(m_registers * block);
+        double* registers = t_registers.data();
+        for (size_t c = 0; c < m_constants.size(); ++c)
+            std::fill_n(registers + c * block, block, m_constants[c]);
+
+        const size_t variables = m_variables.size();
+        const size_t rows = values.size();
+        for (size_t begin = 0; begin < rows; begin += block) {
+            const size_t count = std::min(block, rows - begin);
+            for (const Instruction& instruction : m_code) {
+                double* dst = registers + instruction.dst * block;
+                if (instruction.op == VARIABLE) {
+                    const double* in = x.data() + begin * variables + instruction.a;
+                    for (size_t i = 0; i < count; ++i)
+                        dst[i] = in[i * variables];
+                    continue;
+                }
+
+                const double* a = registers + instruction.a * block;
+                const double* b = registers + instruction.b * block;
+                switch (instruction.op) {
+                case NEG: unary(dst, a, count, [](double v) { return -v; }); break;
+                case SIN: unary(dst, a, count, [](double v) { return std::sin(v); }); break;
+                case COS: unary(dst, a, count, [](double v) { return std::cos(v); }); break;
+                case TAN: unary(dst, a, count, [](double v) { return std::tan(v); }); break;
+                case EXP: unary(dst, a, count, [](double v) { return std::exp(v); }); break;
+                case LOG: unary(dst, a, count, [](double v) { return std::log(v); }); break;
+                case SQRT: unary(dst, a, count, [](double v) { return std::sqrt(v); }); break;
+                case ABS: unary(dst, a, count, [](double v) { return std::abs(v); }); break;
+                case TANH: unary(dst, a, count, [](double v) { return std::tanh(v); }); break;
+                case ADD: binary(dst, a, b, count, [](double u, double v) { return u + v; }); break;
+                case SUB: binary(dst, a, b, count, [](double u, double v) { return u - v; }); break;
+                case MUL: binary(dst, a, b, count, [](double u, double v) { return u * v; }); break;
+                case DIV: binary(dst, a, b, count, [](double u, double v) { return u / v; }); break;
+                case POW: binary(dst, a, b, count, [](double u, double v) { return std::pow(u, v); }); break;
+                case MIN: binary(dst, a, b, count, [](double u, double v) { return std::min(u, v); }); break;
+                case MAX: binary(dst, a, b, count, [](double u, double v) { return std::max(u, v); }); break;
+                default: break;
+                }
+            }
+            std::copy_n(registers + m_result * block, count, values.begin() + begin);
+        }
+    }
+
+    // value at one point
+    double evaluate(std::span<const double> x) const {
+        double value = 0;
+        (*this)(x, std::span<double>(&value, 1));
+        return value;
+    }
+};
+
+} // namespace dl
+
+#endif // #define EXPRESSION_HEADER
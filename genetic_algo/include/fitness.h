@@ -0,0 +1,325 @@
+#ifndef FITNESS_HEADER
+#define FITNESS_HEADER
+
+#include <functional>
+#include <span>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <memory>
+
+#include "population.h"
+#include "fitness_cache.h"
+
+namespace dl
+{
+
+// Objective of a multi-variable genome, takes one transformed value per variable
+using MultiFitnessFunction = std::function<double(std::span<const double> x)>;
+
+// Batch objective: writes fits[i] = f(x[i * variables], ..., x[i * variables + variables - 1])
+// for a chunk of transformed genomes. Called once per chunk instead of once per individual,
+// possibly from several threads at once
+using BatchFitnessFunction = std::function<void(std::span<const double> x, std::span<double> fits)>;
+
+// Decodes rows of encoded words into rows of transformed variables
+using BatchTransformer = std::function<void(std::span<const Genome::GenomeType> encoded, std::span<double> x)>;
+
+// Maps decoded genomes linearly onto [start, end]. Also usable as a scalar GenomeTranformer
+struct LinearTransformer
+{
+    double start;
+    double end;
+
+    double scale() const {
+        return (end - start) / static_cast<double>(Genome::getDistributionMaximumValue() - Genome::getDistributionMinimumValue());
+    }
+
+    double operator()(Genome::GenomeType g) const {
+        return static_cast<double>(g) * scale() + start;
+    }
+};
+
+// Fused Gray decode and linear transform over arrays. Branch-free and written so the compiler
+// can vectorize it
+inline void decode_transform(std::span<const Genome::GenomeType> encoded, std::span<double> x, const LinearTransformer& transformer) {
+    const double scale = transformer.scale();
+    const double start = transformer.start;
+    const size_t size = std::min(encoded.size(), x.size());
+    const Genome::GenomeType* in = encoded.data();
+    double* out = x.data();
+
+    #pragma omp simd
+    for (size_t i = 0; i < size; ++i)
+        out[i] = static_cast<double>(gray_decode(in[i])) * scale + start;
+}
+
+// Maps every variable of a MultiGenome<Variables, Bits> linearly onto its own [start, end]
+template <size_t Variables, size_t Bits = 64>
+struct BoxTransformer
+{
+    using GenomeT = MultiGenome<Variables, Bits>;
+
+    std::array<double, Variables> start;
+    std::array<double, Variables> end;
+
+    // same interval for every variable
+    BoxTransformer(double interval_start, double interval_end) {
+        start.fill(interval_start);
+        end.fill(interval_end);
+    }
+
+    BoxTransformer(const std::array<double, Variables>& interval_starts, const std::array<double, Variables>& interval_ends) :
+        start(interval_starts),
+        end(interval_ends) {}
+
+    static constexpr GenomeLayout layout() {
+        return GenomeT::layout();
+    }
+
+    double scale(size_t variable) const {
+        return (end[variable] - start[variable]) / static_cast<double>(GenomeT::getDistributionMaximumValue());
+    }
+
+    std::array<double, Variables> operator()(const GenomeT& genome) const {
+        std::array<double, Variables> x;
+        (*this)(genome.getEncodedGenome(), x);
+        return x;
+    }
+
+    // batch form over rows of encoded words, the compile-time row width lets the inner loop
+    // unroll and vectorize
+    void operator()(std::span<const Genome::GenomeType> encoded, std::span<double> x) const {
+        std::array<double, Variables> scales;
+        for (size_t v = 0; v < Variables; ++v)
+            scales[v] = scale(v);
+
+        const size_t rows = std::min(encoded.size(), x.size()) / Variables;
+        for (size_t row = 0; row < rows; ++row) {
+            const Genome::GenomeType* in = encoded.data() + row * Variables;
+            double* out = x.data() + row * Variables;
+
+            #pragma omp simd
+            for (size_t v = 0; v < Variables; ++v)
+                out[v] = static_cast<double>(gray_decode(in[v])) * scales[v] + start[v];
+        }
+    }
+};
+
+struct EvaluationStatistics
+{
+    // objective evaluations actually performed
+    size_t evaluations = 0;
+    // individuals whose genome did not change since their last evaluation
+    size_t skipped = 0;
+    size_t cache_lookups = 0;
+    size_t cache_hits = 0;
+
+    double cache_hit_rate() const {
+        return cache_lookups ? static_cast<double>(cache_hits) / cache_lookups : 0.0;
+    }
+
+    EvaluationStatistics& operator+=(const EvaluationStatistics& other) {
+        evaluations += other.evaluations;
+        skipped += other.skipped;
+        cache_lookups += other.cache_lookups;
+        cache_hits += other.cache_hits;
+        return *this;
+    }
+};
+
+// Evaluates fits of a population, either through the scalar std::function pair (one fitness
+// and one transformer call per individual, single-variable genomes) or through a batch
+// transformer over chunks of the population followed by a batch or per-individual objective.
+// Only dirty individuals are evaluated; with a cache attached, genomes seen before (e.g.
+// crossover of identical parents) reuse their cached fit
+class FitnessEvaluator
+{
+    GenomeLayout m_layout;
+
+    FitnessFunction m_fitness_function;
+    GenomeTranformer m_transformer;
+
+    BatchTransformer m_batch_transformer;
+    BatchFitnessFunction m_batch_fitness_function;
+    MultiFitnessFunction m_multi_fitness_function;
+    size_t m_chunk_size = 1024;
+
+    std::shared_ptr<FitnessCache> m_cache;
+    mutable EvaluationStatistics m_statistics;
+
+    // buffers reused between generations
+    mutable std::vector<size_t> m_pending;
+    mutable std::vector<uint8_t> m_hits;
+    mutable std::vector<Genome::GenomeType> m_encoded;
+    mutable std::vector<double> m_x;
+    mutable std::vector<double> m_fits;
+
+    // drops pending individuals whose fit is found in the cache
+    void apply_cache(Population& population) const {
+        const size_t pending = m_pending.size();
+        m_hits.resize(pending);
+
+        size_t hits = 0;
+        #pragma omp parallel for reduction(+:hits)
+        for (size_t j = 0; j < pending; ++j) {
+            double fit = 0;
+            m_hits[j] = m_cache->lookup(FitnessCache::key(population.genome(m_pending[j])), fit);
+            if (m_hits[j]) {
+                population.set_fit(m_pending[j], fit);
+                hits++;
+            }
+        }
+
+        size_t misses = 0;
+        for (size_t j = 0; j < pending; ++j) {
+            if (!m_hits[j])
+                m_pending[misses++] = m_pending[j];
+        }
+        m_pending.resize(misses);
+
+        m_statistics.cache_lookups += pending;
+        m_statistics.cache_hits += hits;
+    }
+
+    void evaluate_scalar(Population& population) const {
+        const size_t pending = m_pending.size();
+        const auto fits = population.fits();
+
+        #pragma omp parallel for
+        for (size_t j = 0; j < pending; ++j) {
+            const size_t idx = m_pending[j];
+            population.update_fit(idx, m_fitness_function, m_transformer);
+            if (m_cache)
+                m_cache->insert(FitnessCache::key(population.genome(idx)), fits[idx]);
+        }
+    }
+
+    void evaluate_batched(Population& population) const {
+        const size_t pending = m_pending.size();
+        const size_t words = m_layout.words();
+        const size_t variables = m_layout.variables;
+        m_encoded.resize(pending * words);
+        m_x.resize(pending * variables);
+        m_fits.resize(pending);
+
+        const size_t chunks = (pending + m_chunk_size - 1) / m_chunk_size;
+
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            const size_t begin = chunk * m_chunk_size;
+            const size_t count = std::min(m_chunk_size, pending - begin);
+            for (size_t j = begin; j < begin + count; ++j) {
+                const auto genome = population.genome(m_pending[j]);
+                std::copy(genome.begin(), genome.end(), m_encoded.begin() + j * words);
+            }
+
+            const std::span<const Genome::GenomeType> encoded(m_encoded.data() + begin * words, count * words);
+            const std::span<double> x(m_x.data() + begin * variables, count * variables);
+            const std::span<double> fits(m_fits.data() + begin, count);
+            m_batch_transformer(encoded, x);
+            if (m_batch_fitness_function) {
+                m_batch_fitness_function(x, fits);
+            } else {
+                for (size_t row = 0; row < count; ++row)
+                    fits[row] = m_multi_fitness_function(x.subspan(row * variables, variables));
+            }
+
+            for (size_t j = begin; j < begin + count; ++j) {
+                population.set_fit(m_pending[j], m_fits[j]);
+                if (m_cache)
+                    m_cache->insert(FitnessCache::key(population.genome(m_pending[j])), m_fits[j]);
+            }
+        }
+    }
+public:
+    FitnessEvaluator(FitnessFunction fitness_function, GenomeTranformer transformer) :
+        m_fitness_function(std::move(fitness_function)),
+        m_transformer(std::move(transformer)) {}
+
+    FitnessEvaluator(BatchFitnessFunction batch_fitness_function, LinearTransformer transformer, size_t chunk_size = 1024) :
+        m_transformer(transformer),
+        m_batch_transformer([transformer](std::span<const Genome::GenomeType> encoded, std::span<double> x) {
+            decode_transform(encoded, x, transformer);
+        }),
+        m_batch_fitness_function(std::move(batch_fitness_function)),
+        m_chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+    template <size_t Variables, size_t Bits>
+    FitnessEvaluator(MultiFitnessFunction fitness_function, const BoxTransformer<Variables, Bits>& transformer, size_t chunk_size = 1024) :
+        m_layout(transformer.layout()),
+        m_batch_transformer(transformer),
+        m_multi_fitness_function(std::move(fitness_function)),
+        m_chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+    template <size_t Variables, size_t Bits>
+    FitnessEvaluator(BatchFitnessFunction batch_fitness_function, const BoxTransformer<Variables, Bits>& transformer, size_t chunk_size = 1024) :
+        m_layout(transformer.layout()),
+        m_batch_transformer(transformer),
+        m_batch_fitness_function(std::move(batch_fitness_function)),
+        m_chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+    const GenomeLayout& layout() const {
+        return m_layout;
+    }
+
+    bool is_batched() const {
+        return static_cast<bool>(m_batch_transformer);
+    }
+
+    // the cache may be shared between evaluators of the same objective
+    void set_cache(std::shared_ptr<FitnessCache> cache) {
+        m_cache = std::move(cache);
+    }
+
+    const EvaluationStatistics& statistics() const {
+        return m_statistics;
+    }
+
+    // resumed runs continue counting from the statistics of their checkpoint
+    void set_statistics(const EvaluationStatistics& statistics) {
+        m_statistics = statistics;
+    }
+
+    // fit of a single genome, safe to call from several threads at once; neither the cache
+    // nor the statistics are involved
+    double evaluate_genome(std::span<const Genome::GenomeType> encoded_genome) const {
+        if (!is_batched())
+            return m_fitness_function(m_transformer(Genome::fromEncodedGenome(encoded_genome[0]).getDecodedGenome()));
+
+        // per-thread buffer, steady-state workers evaluate without allocating
+        thread_local std::vector<double> t_x;
+        t_x.resize(m_layout.variables);
+        const std::span<double> x = t_x;
+        m_batch_transformer(encoded_genome, x);
+        if (!m_batch_fitness_function)
+            return m_multi_fitness_function(x);
+
+        double fit = 0;
+        m_batch_fitness_function(x, std::span<double>(&fit, 1));
+        return fit;
+    }
+
+    void evaluate(Population& population) const {
+        const auto dirty = population.dirty();
+        m_pending.clear();
+        for (size_t i = 0; i < population.size(); ++i) {
+            if (dirty[i])
+                m_pending.push_back(i);
+        }
+        m_statistics.skipped += population.size() - m_pending.size();
+
+        if (m_cache)
+            apply_cache(population);
+        m_statistics.evaluations += m_pending.size();
+
+        if (is_batched())
+            evaluate_batched(population);
+        else
+            evaluate_scalar(population);
+    }
+};
+
+} // namespace dl
+
+#endif // #define FITNESS_HEADER
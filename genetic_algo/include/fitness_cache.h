@@ -0,0 +1,96 @@
+#ifndef FITNESS_CACHE_HEADER
+#define FITNESS_CACHE_HEADER
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <bit>
+#include <span>
+
+#include "rng.h"
+#include "genome.h"
+
+namespace dl
+{
+
+// Bounded genome -> fit cache shared by all evaluation threads. Direct-mapped: every genome has
+// a single slot and a newer entry simply evicts the older one, so memory never grows past the
+// requested capacity. Slots are guarded by a per-slot sequence counter (seqlock), lookups never
+// block and a racing insert only ever causes a miss, never a wrong fit. Single-word genomes are
+// keyed by the word itself, multi-word genomes by a 64-bit fingerprint of their words
+class FitnessCache
+{
+    using GenomeType = Genome::GenomeType;
+
+    struct Slot
+    {
+        // odd while a writer owns the slot, 0 while the slot was never written
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<GenomeType> genome{0};
+        std::atomic<double> fit{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+
+    Slot& slot(GenomeType genome) const {
+        return m_slots[mix64(genome) & m_mask];
+    }
+public:
+    // capacity is rounded up to a power of two
+    explicit FitnessCache(size_t capacity) :
+        m_slots(new Slot[std::bit_ceil(std::max<size_t>(capacity, 1))]),
+        m_mask(std::bit_ceil(std::max<size_t>(capacity, 1)) - 1) {}
+
+    size_t capacity() const {
+        return m_mask + 1;
+    }
+
+    static GenomeType key(std::span<const GenomeType> encoded_genome) {
+        if (encoded_genome.size() == 1)
+            return encoded_genome[0];
+
+        GenomeType fingerprint = golden_gamma;
+        for (const GenomeType word : encoded_genome)
+            fingerprint = mix64(fingerprint ^ word) + golden_gamma;
+        return fingerprint;
+    }
+
+    bool lookup(GenomeType genome, double& fit) const {
+        const Slot& entry = slot(genome);
+        const uint64_t sequence = entry.sequence.load(std::memory_order_acquire);
+        if (sequence == 0 || (sequence & 1))
+            return false;
+
+        const GenomeType cached_genome = entry.genome.load(std::memory_order_relaxed);
+        const double cached_fit = entry.fit.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != sequence || cached_genome != genome)
+            return false;
+
+        fit = cached_fit;
+        return true;
+    }
+
+    // best effort: gives up if another thread is writing the same slot
+    void insert(GenomeType genome, double fit) {
+        Slot& entry = slot(genome);
+        uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1) || !entry.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+            return;
+
+        std::atomic_thread_fence(std::memory_order_release);
+        entry.genome.store(genome, std::memory_order_relaxed);
+        entry.fit.store(fit, std::memory_order_relaxed);
+        entry.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void clear() {
+        for (size_t i = 0; i < capacity(); ++i)
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace dl
+
+#endif // #define FITNESS_CACHE_HEADER
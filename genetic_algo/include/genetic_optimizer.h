@@ -3,104 +3,402 @@
 
 #include <vector>
 #include <algorithm>
-#include <iostream>
 #include <array>
 #include <memory>
 #include <chrono>
 
 #include "rng.h"
 #include "pass.h"
+#include "fitness.h"
+#include "telemetry.h"
+#include "termination.h"
+#include "checkpoint.h"
 
 namespace dl
 {
 
 using Passes = std::vector<std::unique_ptr<PopulationPass>>;
 
-class GeneticOptimizer
+// Typed optimize overloads shared by the optimizers. Derived implements
+// std::span<const Genome::GenomeType> optimize(FitnessEvaluator) returning the encoded best genome
+template <typename Derived>
+class OptimizerFrontend
+{
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+public:
+    Genome optimize(FitnessFunction fitness_function, GenomeTranformer transformer) {
+        return Genome::fromEncodedGenome(derived().optimize(FitnessEvaluator(std::move(fitness_function), std::move(transformer)))[0]);
+    }
+
+    // batched evaluation: genomes are decoded and transformed by a vectorized kernel and
+    // the fitness function is called once per chunk of the population
+    Genome optimize(BatchFitnessFunction fitness_function, LinearTransformer transformer) {
+        return Genome::fromEncodedGenome(derived().optimize(FitnessEvaluator(std::move(fitness_function), transformer))[0]);
+    }
+
+    // multi-variable genomes, the genome shape is taken from the transformer
+    template <size_t Variables, size_t Bits>
+    MultiGenome<Variables, Bits> optimize(MultiFitnessFunction fitness_function, const BoxTransformer<Variables, Bits>& transformer) {
+        return MultiGenome<Variables, Bits>::fromEncodedGenome(derived().optimize(FitnessEvaluator(std::move(fitness_function), transformer)));
+    }
+
+    template <size_t Variables, size_t Bits>
+    MultiGenome<Variables, Bits> optimize(BatchFitnessFunction fitness_function, const BoxTransformer<Variables, Bits>& transformer) {
+        return MultiGenome<Variables, Bits>::fromEncodedGenome(derived().optimize(FitnessEvaluator(std::move(fitness_function), transformer)));
+    }
+};
+
+class GeneticOptimizer : public OptimizerFrontend<GeneticOptimizer>
 {
     Passes m_passes;
 
     // hyperparameters
     size_t m_population_size;
     size_t m_max_generations;
+    uint64_t m_seed;
+
+    std::shared_ptr<FitnessCache> m_cache;
+    EvaluationStatistics m_statistics;
+    std::shared_ptr<Telemetry> m_telemetry = std::make_shared<Telemetry>();
+    std::vector<std::unique_ptr<StopCondition>> m_stop_conditions;
+    std::shared_ptr<AnytimeBest> m_anytime_best = std::make_shared<AnytimeBest>();
+    std::unique_ptr<CheckpointWriter> m_checkpoints;
+    size_t m_checkpoint_interval = 0;
 
-    // utility
-    // void update_fits(Population& population, FitnessFunction fitness_function, GenomeTranformer transformer) {
-    //     #pragma omp for
-    //     for (size_t i = 0; i < population.size(); ++i) {
-    //         population[i].update_fit(fitness_function, transformer);
-    //     }
-    // }
+    // state of the run in progress
+    Population m_population;
+    size_t m_generation = 0;
+    RandomSource m_generations_random;
+    std::chrono::steady_clock::time_point m_started;
+    // name of the stop condition that ended the run, null while it goes on
+    const char* m_stop_reason = nullptr;
+    // fittest (and for drivers least fit) individuals of the current population
+    FitRanking m_ranking;
+    size_t m_ranked_best = 1;
+    size_t m_ranked_worst = 0;
+    // second population buffer and per-thread scratch of the passes
+    GenerationArena m_arena;
+    // what every pass carries across generations, one per pass
+    std::vector<PassState> m_pass_states;
+
+    // encoded words of the best individual of the last optimize call
+    std::vector<Genome::GenomeType> m_best_genome;
+
+    PassContext pass_context(size_t generation, const RandomSource& generation_random, size_t pass, const FitnessEvaluator& evaluator) {
+        return PassContext{generation, generation_random.fork(pass), &m_arena, &evaluator, &m_pass_states[pass]};
+    }
+
+    void update_population(Population& population, size_t generation, const RandomSource& random, const FitnessEvaluator& evaluator) {
+        const RandomSource generation_random = random.fork(generation);
+        const bool traced = m_telemetry->enabled();
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            m_arena.prepare();
+            const PassContext context = pass_context(generation, generation_random, i, evaluator);
+            if (!traced) {
+                m_passes[i]->run(population, context);
+                continue;
+            }
+
+            const uint64_t start = m_telemetry->now();
+            const uint64_t allocations_before = allocations();
+            const size_t evaluations_before = evaluator.statistics().evaluations;
+            m_passes[i]->run(population, context);
+            m_telemetry->record(TelemetryEvent{TelemetryEvent::PASS, 0, m_passes[i]->name(), generation, start, m_telemetry->now() - start,
+                evaluator.statistics().evaluations - evaluations_before, allocations() - allocations_before, 0, 0, 0});
+        }
 
-    void update_population(Population& population, size_t generation) {
         for (size_t i = 0; i < m_passes.size(); ++i) {
-            m_passes[i]->run(population, generation);
+            m_arena.prepare();
+            m_passes[i]->complete(population, pass_context(generation, generation_random, i, evaluator));
         }
     }
 
-    void dump_population(const Population& population) const {
-        #ifdef NDEBUG
-        std::cout << "Population dump:" << std::endl;
-        for (const auto& offspring : population)
-            std::cout << "\t" << "genome:" << offspring.genome.getEncodedGenome() << "; fit: " << offspring.fit << std::endl;
-        #else
-        (void) population;
-        #endif
+    // the passes see the random streams of update_population again
+    void population_evaluated(Population& population, size_t generation, const RandomSource& random, const FitnessEvaluator& evaluator) {
+        const RandomSource generation_random = random.fork(generation);
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            m_arena.prepare();
+            m_passes[i]->evaluated(population, pass_context(generation, generation_random, i, evaluator));
+        }
+    }
+
+    void evaluate_population(const FitnessEvaluator& evaluator, const char* name) {
+        if (!m_telemetry->enabled()) {
+            evaluator.evaluate(m_population);
+            return;
+        }
+
+        const uint64_t start = m_telemetry->now();
+        const uint64_t allocations_before = allocations();
+        const size_t evaluations_before = evaluator.statistics().evaluations;
+        evaluator.evaluate(m_population);
+        m_telemetry->record(TelemetryEvent{TelemetryEvent::EVALUATION, 0, name, m_generation, start, m_telemetry->now() - start,
+            evaluator.statistics().evaluations - evaluations_before, allocations() - allocations_before, 0, 0, 0});
+    }
+
+    // publishes the best individual and asks the stop conditions, after every generation
+    void check_progress(const FitnessEvaluator& evaluator) {
+        m_anytime_best->publish(m_population.genome(order().front()), best_fit(), m_generation);
+
+        const OptimizationProgress progress{m_generation, evaluator.statistics().evaluations, best_fit(),
+            std::chrono::steady_clock::now() - m_started, m_population};
+        for (const auto& condition : m_stop_conditions) {
+            if (condition->should_stop(progress)) {
+                m_stop_reason = condition->name();
+                return;
+            }
+        }
+    }
+
+    // state shared by start() and resume()
+    void begin_run(FitnessEvaluator& evaluator, uint64_t seed) {
+        if (m_cache) {
+            m_cache->clear();
+            evaluator.set_cache(m_cache);
+        }
+
+        m_generation = 0u;
+        m_stop_reason = nullptr;
+        m_started = std::chrono::steady_clock::now();
+        m_anytime_best->reset();
+        for (const auto& condition : m_stop_conditions)
+            condition->reset();
+        m_generations_random = RandomSource(seed).fork(1);
+        m_pass_states.resize(m_passes.size());
+        for (auto& state : m_pass_states)
+            state.clear();
+    }
+
+    bool needs_swarm_state() const {
+        return std::any_of(m_passes.begin(), m_passes.end(), [](const auto& pass) { return pass->needs_swarm_state(); });
     }
 
 public:
-    GeneticOptimizer(size_t population_size, size_t max_generations) :
+    using OptimizerFrontend<GeneticOptimizer>::optimize;
+
+    // the same seed gives bit-identical results regardless of the number of threads
+    GeneticOptimizer(size_t population_size, size_t max_generations, uint64_t seed = random_seed()) :
         m_population_size(population_size),
-        m_max_generations(max_generations)
+        m_max_generations(max_generations),
+        m_seed(seed)
     {}
 
+    // prepares the optimizer for an unrelated run: drops the passes, stop conditions and
+    // checkpoints, keeps the population and pass buffers, the cache and the telemetry
+    void reset(size_t population_size, size_t max_generations, uint64_t seed) {
+        m_population_size = population_size;
+        m_max_generations = max_generations;
+        m_seed = seed;
+        m_passes.clear();
+        m_stop_conditions.clear();
+        m_checkpoints = nullptr;
+        m_checkpoint_interval = 0;
+    }
+
+    uint64_t seed() const {
+        return m_seed;
+    }
+
+    size_t max_generations() const {
+        return m_max_generations;
+    }
+
     void register_pass(std::unique_ptr<PopulationPass> pass) {
         m_passes.push_back(std::move(pass));
     }
 
-    Genome optimize(FitnessFunction fitness_function, GenomeTranformer transformer)
-    {
-        size_t generation = 0u;
+    // memoizes fits of up to capacity genomes across generations, 0 disables the cache
+    void enable_fitness_cache(size_t capacity) {
+        m_cache = capacity ? std::make_shared<FitnessCache>(capacity) : nullptr;
+    }
+
+    // evaluation counters of the last optimize call
+    const EvaluationStatistics& statistics() const {
+        return m_statistics;
+    }
 
-        // initial population
-        Population population(m_population_size);
+    // per pass timings and population statistics, disabled until telemetry().set_enabled(true)
+    Telemetry& telemetry() {
+        return *m_telemetry;
+    }
+
+    // e.g. to collect the events of several optimizers in one trace
+    void set_telemetry(std::shared_ptr<Telemetry> telemetry) {
+        m_telemetry = std::move(telemetry);
+    }
+
+    // the run ends after max_generations or as soon as any of the stop conditions is met
+    void add_stop_condition(std::unique_ptr<StopCondition> condition) {
+        m_stop_conditions.push_back(std::move(condition));
+    }
+
+    bool has_stop_conditions() const {
+        return !m_stop_conditions.empty();
+    }
+
+    // why the last run ended: "max_generations" or the name of a stop condition
+    const char* stop_reason() const {
+        if (m_stop_reason)
+            return m_stop_reason;
+        return m_generation > m_max_generations ? "max_generations" : "running";
+    }
+
+    // best individual found so far; safe to call from another thread while optimize runs
+    AnytimeBest::Snapshot current_best() const {
+        return m_anytime_best->snapshot();
+    }
+
+    // writes a checkpoint to path every interval generations on a background thread (see
+    // CheckpointWriter); interval 0 disables checkpoints
+    void enable_checkpoints(std::string path, size_t interval) {
+        m_checkpoints = interval ? std::make_unique<CheckpointWriter>(std::move(path)) : nullptr;
+        m_checkpoint_interval = interval;
+    }
+
+    // synchronous checkpoint of the run in progress, e.g. on a signal between two steps
+    void save_checkpoint(const std::string& path, const FitnessEvaluator& evaluator) const {
+        std::vector<std::byte> buffer;
+        write_checkpoint(buffer, m_seed, m_generation, evaluator.statistics(), m_population, m_passes, m_pass_states);
+        write_checkpoint_file(path, buffer);
+    }
+
+    // Step-wise interface, used by drivers that interleave several optimizers (e.g. islands).
+    // start() creates and evaluates the initial population, every step() runs one generation
+    // of the pass pipeline and evaluates its result; the evaluator must outlive the run
+    void start(FitnessEvaluator& evaluator) {
+        begin_run(evaluator, m_seed);
+
+        const RandomSource initial_random = RandomSource(m_seed).fork(0);
+        const GenomeLayout layout = evaluator.layout();
+        m_population.reset(m_population_size, layout, needs_swarm_state());
         #pragma omp parallel for
-        for (size_t i = 0; i < population.size(); ++i) {
-            population[i].update_fit(fitness_function, transformer);
+        for (size_t i = 0; i < m_population.size(); ++i) {
+            RandomEngine engine = initial_random.stream(i);
+            for (auto& word : m_population.genome(i))
+                word = Genome(engine() & layout.mask()).getEncodedGenome();
+            m_population.assign(i, m_population.genome(i), 0);
         }
-        dump_population(population);
-
-        while (true)
-        {
-            #ifdef NDEBUG
-            std::cout << "Generation #" << generation << std::endl;
-            #endif
-
-            update_population(population, generation);
-            #pragma omp parallel for
-            for (size_t i = 0; i < population.size(); ++i) {
-                population[i].update_fit(fitness_function, transformer);
-            }
-            dump_population(population);
+        evaluate_population(evaluator, "initial_evaluation");
+        refresh_order();
+        check_progress(evaluator);
+    }
 
-            std::sort(population.rbegin(), population.rend());
+    // Continues a checkpointed run instead of start(): the optimizer must have the pipeline of
+    // the checkpointed one, the seed is taken from the checkpoint. Steps then produce exactly
+    // the generations the original run would have; stop conditions and elapsed time start over
+    void resume(FitnessEvaluator& evaluator, const Checkpoint& checkpoint) {
+        if (checkpoint.layout() != evaluator.layout())
+            throw std::runtime_error("checkpoint genome layout does not match the evaluator");
+        checkpoint.check_pipeline(m_passes);
 
-            #ifdef NDEBUG
-            double current_best_result = population.begin()->fit;
-            std::cout << "Current generation best fit value: " << current_best_result << std::endl;
-            #endif
+        m_seed = checkpoint.seed();
+        begin_run(evaluator, m_seed);
+        checkpoint.restore(m_population);
+        checkpoint.restore(m_pass_states);
+        if (needs_swarm_state())
+            m_population.enable_swarm_state();
+        m_generation = checkpoint.generation();
+        evaluator.set_statistics(checkpoint.statistics());
 
-            if (generation >= m_max_generations) {
-                #ifdef NDEBUG
-                std::cout << "Generation limit exceeded!" << std::endl;
-                #endif
-                break;
-            }
+        // checkpoints are taken between steps, every individual already has its fit
+        refresh_order();
+        check_progress(evaluator);
+    }
+
+    void step(const FitnessEvaluator& evaluator) {
+        const bool traced = m_telemetry->enabled();
+        const uint64_t start = traced ? m_telemetry->now() : 0;
+        const uint64_t allocations_before = traced ? allocations() : 0;
+        const size_t evaluations_before = traced ? evaluator.statistics().evaluations : 0;
 
-            generation++;
+        update_population(m_population, m_generation, m_generations_random, evaluator);
+        evaluate_population(evaluator, "evaluation");
+        population_evaluated(m_population, m_generation, m_generations_random, evaluator);
+        refresh_order();
+
+        if (traced) {
+            // the summary itself is not part of the generation
+            const uint64_t duration = m_telemetry->now() - start;
+            const uint64_t generation_allocations = allocations() - allocations_before;
+            const PopulationSummary summary = summarize(m_population);
+            m_telemetry->record(TelemetryEvent{TelemetryEvent::GENERATION, 0, "generation", m_generation, start, duration,
+                evaluator.statistics().evaluations - evaluations_before, generation_allocations,
+                summary.best, summary.mean, summary.diversity});
         }
 
-        return population.begin()->genome;
+        m_generation++;
+        check_progress(evaluator);
+
+        if (m_checkpoints && m_generation % m_checkpoint_interval == 0) {
+            m_checkpoints->submit([this, &evaluator](std::vector<std::byte>& buffer) {
+                write_checkpoint(buffer, m_seed, m_generation, evaluator.statistics(), m_population, m_passes, m_pass_states);
+            });
+        }
+    }
+
+    bool finished() const {
+        return m_stop_reason || m_generation > m_max_generations;
+    }
+
+    // records the best individual and the evaluation counters of the run
+    std::span<const Genome::GenomeType> finish(const FitnessEvaluator& evaluator) {
+        m_statistics = evaluator.statistics();
+        if (m_checkpoints)
+            m_checkpoints->flush();
+
+        const auto best_genome = m_population.genome(order().front());
+        m_best_genome.assign(best_genome.begin(), best_genome.end());
+        return m_best_genome;
+    }
+
+    size_t generation() const {
+        return m_generation;
+    }
+
+    // state the pass registered at position `pass` carries across generations of the run
+    const PassState& pass_state(size_t pass) const {
+        return m_pass_states.at(pass);
+    }
+
+    // drivers may modify the population between steps, then must call refresh_order()
+    Population& population() {
+        return m_population;
+    }
+
+    const Population& population() const {
+        return m_population;
+    }
+
+    // Permutation of the current population, ranked by descending fit at its extremes only
+    // (see FitRanking): the first ranked_best entries are the fittest individuals, the last
+    // ranked_worst ones the least fit, the worst last
+    std::span<const size_t> order() const {
+        return m_ranking.order();
+    }
+
+    // drivers reading further into order() than the best individual raise the ranked counts
+    void set_ranking(size_t ranked_best, size_t ranked_worst) {
+        m_ranked_best = std::max<size_t>(ranked_best, 1);
+        m_ranked_worst = ranked_worst;
+    }
+
+    void refresh_order() {
+        m_ranking.rank(m_population, m_ranked_best, m_ranked_worst);
+    }
+
+    double best_fit() const {
+        return m_population.fits()[order().front()];
+    }
+
+    // returns the encoded words of the best individual, valid until the next call
+    std::span<const Genome::GenomeType> optimize(FitnessEvaluator evaluator)
+    {
+        start(evaluator);
+        while (!finished())
+            step(evaluator);
+        return finish(evaluator);
     }
 };
 
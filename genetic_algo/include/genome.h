@@ -2,63 +2,159 @@
 #define GENOME_HEADER
 
 #include <bitset>
+#include <cmath>
+#include <limits>
+#include <array>
+#include <span>
+#include <algorithm>
 
 #include "rng.h"
 #include "gray_code.h"
+#include "mutation.h"
 
 namespace dl
 {
 
+// Shape of a genome: every variable occupies the low `bits` bits of its own 64-bit word, so
+// crossover, mutation and Gray coding always work on whole words
+struct GenomeLayout
+{
+    size_t variables = 1;
+    size_t bits = 64;
+
+    constexpr size_t words() const {
+        return variables;
+    }
+
+    constexpr size_t total_bits() const {
+        return variables * bits;
+    }
+
+    // valid bits of every word
+    constexpr uint64_t mask() const {
+        return bits >= 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+    }
+
+    // Gray-encoded word as a coordinate in [0, 1] and back, the search space of the
+    // continuous-space passes
+    double to_unit(uint64_t encoded) const {
+        return static_cast<double>(gray_decode(encoded)) / static_cast<double>(mask());
+    }
+
+    // rounds to the nearest level, levels at or above 2^64 of 64-bit variables map to the mask
+    uint64_t from_unit(double x) const {
+        const double levels = static_cast<double>(mask());
+        const double level = std::round(x * levels);
+        return gray_encode(level >= levels ? mask() : static_cast<uint64_t>(level));
+    }
+
+    bool operator==(const GenomeLayout&) const = default;
+};
+
 // Genome class holds genome as encoded value using Gray Code
 class Genome
 {
 public:
     using GenomeType = uint64_t;
 private:
-    GrayEncoder<GenomeType, GenomeType> m_encoder{};
-    GenomeType m_encoded_value;
+    using Encoder = GrayCode<GenomeType>;
 
-    inline static std::uniform_int_distribution<GenomeType> m_distribution{};
+    GenomeType m_encoded_value = 0;
 public:
-    // be default, we generate random genome
-    Genome() {
-        m_encoded_value = m_encoder.encode(m_distribution(random_engine));
+    constexpr Genome() = default;
+
+    constexpr Genome(GenomeType value) : m_encoded_value(Encoder::encode(value)) {}
+
+    static constexpr Genome fromEncodedGenome(GenomeType encoded_value) {
+        Genome genome;
+        genome.m_encoded_value = encoded_value;
+        return genome;
     }
 
-    Genome(GenomeType value) : m_encoded_value(m_encoder.encode(value)) {}
+    // uniformly distributed genome drawn from the given stream
+    static Genome random(RandomEngine& engine) {
+        return Genome(static_cast<GenomeType>(engine()));
+    }
 
-    GenomeType getEncodedGenome() const {
+    constexpr GenomeType getEncodedGenome() const {
         return m_encoded_value;
     }
 
-    GenomeType getDecodedGenome() const {
-        return m_encoder.decode(m_encoded_value);
+    constexpr GenomeType getDecodedGenome() const {
+        return Encoder::decode(m_encoded_value);
     }
 
-    static GenomeType getDistributionMaximumValue() {
-        return m_distribution.b();
+    static constexpr GenomeType getDistributionMaximumValue() {
+        return std::numeric_limits<GenomeType>::max();
     }
 
-    static GenomeType getDistributionMinimumValue() {
-        return m_distribution.a();
+    static constexpr GenomeType getDistributionMinimumValue() {
+        return std::numeric_limits<GenomeType>::min();
     }
 
-    static size_t getGenomeSize() {
+    static constexpr size_t getGenomeSize() {
         return sizeof(GenomeType) * 8;
     }
 
-    void mutate(double mutation_probability) {
-        std::uniform_real_distribution distribution;
-        std::bitset<sizeof(GenomeType) * 8> bits(m_encoded_value);
+    void mutate(double mutation_probability, RandomEngine& engine) {
+        BernoulliMaskGenerator(mutation_probability).apply(std::span<GenomeType>(&m_encoded_value, 1), getGenomeSize(), engine);
+    }
+};
+
+// Compile-time sized genome of Variables variables with Bits bits of resolution each, one
+// Gray-coded word per variable (see GenomeLayout)
+template <size_t Variables, size_t Bits = 64>
+class MultiGenome
+{
+    static_assert(Variables > 0, "genome needs at least one variable");
+    static_assert(Bits > 0 && Bits <= 64, "variables are limited to 64 bits");
+public:
+    using GenomeType = Genome::GenomeType;
+    using Words = std::array<GenomeType, Variables>;
+private:
+    using Encoder = GrayCode<GenomeType>;
+
+    Words m_encoded{};
+public:
+    MultiGenome() = default;
+
+    // from decoded values, bits above Bits are dropped
+    explicit MultiGenome(const Words& values) {
+        for (size_t i = 0; i < Variables; ++i)
+            m_encoded[i] = Encoder::encode(values[i] & layout().mask());
+    }
+
+    static MultiGenome fromEncodedGenome(std::span<const GenomeType> words) {
+        MultiGenome genome;
+        std::copy_n(words.begin(), Variables, genome.m_encoded.begin());
+        return genome;
+    }
 
-        for (size_t i = 0; i < sizeof(GenomeType) * 8; ++i) {
-            const auto current_probability = distribution(random_engine);
-            if (current_probability < mutation_probability) {
-                bits.flip(i);
-            }
-        }
+    static constexpr GenomeLayout layout() {
+        return GenomeLayout{Variables, Bits};
+    }
+
+    static constexpr size_t getGenomeSize() {
+        return Variables * Bits;
+    }
+
+    static constexpr GenomeType getDistributionMaximumValue() {
+        return Bits >= 64 ? std::numeric_limits<GenomeType>::max() : (GenomeType{1} << Bits) - 1;
+    }
+
+    const Words& getEncodedGenome() const {
+        return m_encoded;
+    }
+
+    Words getDecodedGenome() const {
+        Words decoded;
+        for (size_t i = 0; i < Variables; ++i)
+            decoded[i] = Encoder::decode(m_encoded[i]);
+        return decoded;
+    }
 
-        m_encoded_value = bits.to_ullong();
+    GenomeType getDecodedVariable(size_t idx) const {
+        return Encoder::decode(m_encoded[idx]);
     }
 };
 
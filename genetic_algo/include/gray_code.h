@@ -1,8 +1,67 @@
+#ifndef GRAY_CODE_HEADER
+#define GRAY_CODE_HEADER
+
 #include <bitset>
+#include <span>
+#include <type_traits>
+#include <algorithm>
 
 namespace dl
 {
 
+template <typename T>
+constexpr T gray_encode(T value)
+{
+    static_assert(std::is_unsigned_v<T>, "Gray code is defined on unsigned integers");
+    return value ^ (value >> 1);
+}
+
+// Inverse Gray code is the prefix XOR of all higher bits. Computed with shift doubling:
+// log2(bits) shift-xor steps (6 for 64 bits) instead of one dependent step per bit
+template <typename T>
+constexpr T gray_decode(T code)
+{
+    static_assert(std::is_unsigned_v<T>, "Gray code is defined on unsigned integers");
+    for (unsigned shift = 1; shift < sizeof(T) * 8; shift <<= 1)
+        code ^= code >> shift;
+    return code;
+}
+
+// Batch versions over arrays: straight-line loops the compiler vectorizes. in and out may alias
+template <typename T>
+void gray_encode(std::span<const T> values, std::span<T> codes)
+{
+    const size_t size = std::min(values.size(), codes.size());
+    #pragma omp simd
+    for (size_t i = 0; i < size; ++i)
+        codes[i] = gray_encode(values[i]);
+}
+
+template <typename T>
+void gray_decode(std::span<const T> codes, std::span<T> values)
+{
+    const size_t size = std::min(values.size(), codes.size());
+    #pragma omp simd
+    for (size_t i = 0; i < size; ++i)
+        values[i] = gray_decode(codes[i]);
+}
+
+// Non-virtual, constexpr Gray coder, used where the encoder is fixed at compile time
+template <typename T>
+struct GrayCode
+{
+    using FromType = T;
+    using ToType = T;
+
+    static constexpr T encode(T from) {
+        return gray_encode(from);
+    }
+
+    static constexpr T decode(T to) {
+        return gray_decode(to);
+    }
+};
+
 template<typename From, typename To>
 struct Encoder
 {
@@ -23,12 +82,10 @@ struct GrayEncoder : Encoder<IntegerType, CodeType>
 
     IntegerType decode(const CodeType& to) const override
     {
-        IntegerType from = 0;
-        CodeType coded = to;
-        for (; coded; coded >>= 1)
-            from ^= coded;
-        return from;
+        return static_cast<IntegerType>(gray_decode(to));
     }
 };
 
-} // namespace ga
+} // namespace dl
+
+#endif // #define GRAY_CODE_HEADER
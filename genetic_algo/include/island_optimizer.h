@@ -0,0 +1,246 @@
+#ifndef ISLAND_OPTIMIZER_HEADER
+#define ISLAND_OPTIMIZER_HEADER
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <limits>
+#include <stdexcept>
+#include <omp.h>
+
+#include "genetic_optimizer.h"
+#include "migration.h"
+
+namespace dl
+{
+
+// registers the passes of one island, called once per island since every optimizer owns its
+// passes. Synchronous migration needs all islands to run the same number of generations, so
+// IslandOptimizer rejects stop conditions on islands migrating synchronously
+using PipelineFactory = std::function<void(GeneticOptimizer& island)>;
+
+// One island of a run: its index in the topology, its optimizer and its own evaluator
+struct Island
+{
+    size_t index;
+    GeneticOptimizer* optimizer;
+    FitnessEvaluator* evaluator;
+};
+
+// sends the best policy.migrants individuals of the island to every target island
+inline void send_migrants(const Island& island, size_t islands, uint64_t epoch, const MigrationPolicy& policy, MigrationTransport& transport) {
+    const Population& population = island.optimizer->population();
+    const auto order = island.optimizer->order();
+    std::vector<uint64_t> record(migrant_record_words(population.layout()));
+
+    for (const size_t target : migration_targets(island.index, islands, policy.topology)) {
+        for (size_t j = 0; j < policy.migrants; ++j) {
+            const size_t idx = order[std::min(j, order.size() - 1)];
+            encode_migrant(record, epoch, population.fits()[idx], population.genome(idx));
+            if (policy.synchronous) {
+                while (!transport.send(island.index, target, record))
+                    std::this_thread::yield();
+            } else if (!transport.send(island.index, target, record)) {
+                // the target lags behind, asynchronous migration drops the migrant
+                break;
+            }
+        }
+    }
+}
+
+// replaces the worst individuals of the island with the migrants of its source islands
+inline void receive_migrants(const Island& island, size_t islands, const MigrationPolicy& policy, MigrationTransport& transport) {
+    Population& population = island.optimizer->population();
+    const size_t record_words = migrant_record_words(population.layout());
+
+    std::vector<uint64_t> records;
+    std::vector<uint64_t> record(record_words);
+    for (const size_t source : migration_sources(island.index, islands, policy.topology)) {
+        for (size_t j = 0; j < policy.migrants; ++j) {
+            if (policy.synchronous) {
+                // channels are FIFO and every source sends the same number of migrants per
+                // epoch, so these are the migrants of this epoch
+                while (!transport.receive(source, island.index, record))
+                    std::this_thread::yield();
+            } else if (!transport.receive(source, island.index, record)) {
+                break;
+            }
+            records.insert(records.end(), record.begin(), record.end());
+        }
+    }
+
+    // immigrants keep their fit, so they are not re-evaluated
+    const auto order = island.optimizer->order();
+    const size_t immigrants = std::min(records.size() / record_words, population.size());
+    for (size_t j = 0; j < immigrants; ++j) {
+        const Migrant migrant = decode_migrant(std::span<const uint64_t>(records).subspan(j * record_words, record_words));
+        const size_t idx = order[order.size() - 1 - j];
+        population.assign(idx, migrant.genome, population.generations()[idx]);
+        population.set_fit(idx, migrant.fit);
+    }
+    if (immigrants)
+        island.optimizer->refresh_order();
+}
+
+// Runs the given islands of a run of islands in lockstep, epoch by epoch, migrating every
+// policy.interval generations. All sends of a caller precede its receives, so callers owning
+// any subset of the islands never deadlock each other
+inline void evolve_islands(std::span<const Island> owned, size_t islands, const MigrationPolicy& policy, MigrationTransport& transport) {
+    for (const Island& island : owned)
+        island.optimizer->start(*island.evaluator);
+
+    const bool migrate = policy.interval > 0 && islands > 1;
+    for (uint64_t epoch = 1; ; ++epoch) {
+        const size_t boundary = migrate ? epoch * policy.interval : std::numeric_limits<size_t>::max();
+        bool running = false;
+        for (const Island& island : owned) {
+            while (!island.optimizer->finished() && island.optimizer->generation() < boundary)
+                island.optimizer->step(*island.evaluator);
+            running |= !island.optimizer->finished();
+        }
+        // every island has the same generation limit, so all of them stop at the same epoch
+        if (!running)
+            break;
+
+        for (const Island& island : owned)
+            send_migrants(island, islands, epoch, policy, transport);
+        for (const Island& island : owned)
+            receive_migrants(island, islands, policy, transport);
+    }
+}
+
+// Island model: the population is split into independent sub-populations, each evolved by its
+// own GeneticOptimizer on its own thread, and every policy.interval generations the best
+// individuals of every island migrate to its neighbours, replacing their worst individuals.
+// Islands only communicate through lock-free mailboxes, one per directed edge of the topology.
+// With synchronous migration a run is reproducible from its seed
+class IslandOptimizer : public OptimizerFrontend<IslandOptimizer>
+{
+    size_t m_islands;
+    size_t m_island_population_size;
+    size_t m_max_generations;
+    uint64_t m_seed;
+    MigrationPolicy m_policy;
+    PipelineFactory m_pipeline;
+    size_t m_fitness_cache_capacity = 0;
+    std::shared_ptr<Telemetry> m_telemetry;
+
+    std::vector<std::unique_ptr<GeneticOptimizer>> m_optimizers;
+
+    EvaluationStatistics m_statistics;
+    size_t m_best_island = 0;
+    std::vector<Genome::GenomeType> m_best_genome;
+public:
+    using OptimizerFrontend<IslandOptimizer>::optimize;
+
+    IslandOptimizer(size_t islands, size_t island_population_size, size_t max_generations, PipelineFactory pipeline,
+        MigrationPolicy policy = {}, uint64_t seed = random_seed()) :
+        m_islands(std::max<size_t>(islands, 1)),
+        m_island_population_size(island_population_size),
+        m_max_generations(max_generations),
+        m_seed(seed),
+        m_policy(policy),
+        m_pipeline(std::move(pipeline))
+    {
+        m_policy.migrants = std::min(m_policy.migrants, m_island_population_size);
+    }
+
+    uint64_t seed() const {
+        return m_seed;
+    }
+
+    size_t islands() const {
+        return m_islands;
+    }
+
+    const MigrationPolicy& policy() const {
+        return m_policy;
+    }
+
+    // every island gets its own cache of the given capacity, 0 disables the caches
+    void enable_fitness_cache(size_t capacity) {
+        m_fitness_cache_capacity = capacity;
+    }
+
+    // every island records into this telemetry, each on its own thread ring
+    void set_telemetry(std::shared_ptr<Telemetry> telemetry) {
+        m_telemetry = std::move(telemetry);
+    }
+
+    // whether the islands wait for each other's migrants every epoch
+    bool lockstep() const {
+        return m_policy.synchronous && m_policy.interval > 0 && m_islands > 1;
+    }
+
+    // island optimizer with its seed and pipeline, as created for every run; throws if the
+    // pipeline cannot run in this model
+    std::unique_ptr<GeneticOptimizer> create_island(size_t island) const {
+        auto optimizer = std::make_unique<GeneticOptimizer>(m_island_population_size, m_max_generations, RandomSource(m_seed).fork(island).key());
+        optimizer->enable_fitness_cache(m_fitness_cache_capacity);
+        if (m_telemetry)
+            optimizer->set_telemetry(m_telemetry);
+        m_pipeline(*optimizer);
+        // an island stopping early would leave the others waiting for its migrants forever
+        if (lockstep() && optimizer->has_stop_conditions())
+            throw std::runtime_error("stop conditions need asynchronous migration, synchronous islands run in lockstep");
+        // emigrants are the best, immigrants replace the worst of every source's migrants
+        optimizer->set_ranking(m_policy.migrants, m_policy.migrants * migration_sources(island, m_islands, m_policy.topology).size());
+        return optimizer;
+    }
+
+    // a producer may run at most one epoch ahead of a synchronous consumer
+    size_t channel_capacity() const {
+        return 2 * std::max<size_t>(m_policy.migrants, 1);
+    }
+
+    // evaluation counters of the last optimize call, summed over the islands
+    const EvaluationStatistics& statistics() const {
+        return m_statistics;
+    }
+
+    // island that found the result of the last optimize call
+    size_t best_island() const {
+        return m_best_island;
+    }
+
+    // returns the encoded words of the best individual over all islands, valid until the next call
+    std::span<const Genome::GenomeType> optimize(FitnessEvaluator evaluator)
+    {
+        m_optimizers.clear();
+        for (size_t island = 0; island < m_islands; ++island)
+            m_optimizers.push_back(create_island(island));
+        std::vector<FitnessEvaluator> evaluators(m_islands, evaluator);
+        MailboxTransport transport(m_islands, m_policy.topology, channel_capacity(), migrant_record_words(evaluator.layout()));
+
+        // one thread per island; nested passes then run serially inside their island. Should the
+        // runtime grant fewer threads, every thread advances several islands in lockstep
+        #pragma omp parallel num_threads(m_islands)
+        {
+            std::vector<Island> owned;
+            for (size_t island = omp_get_thread_num(); island < m_islands; island += omp_get_num_threads())
+                owned.push_back(Island{island, m_optimizers[island].get(), &evaluators[island]});
+            evolve_islands(owned, m_islands, m_policy, transport);
+        }
+
+        m_statistics = EvaluationStatistics{};
+        m_best_island = 0;
+        for (size_t island = 0; island < m_islands; ++island) {
+            m_optimizers[island]->finish(evaluators[island]);
+            m_statistics += m_optimizers[island]->statistics();
+
+            // ties go to the lowest island, so the result does not depend on thread timing
+            if (m_optimizers[island]->best_fit() > m_optimizers[m_best_island]->best_fit())
+                m_best_island = island;
+        }
+
+        const GeneticOptimizer& best = *m_optimizers[m_best_island];
+        const auto best_genome = best.population().genome(best.order().front());
+        m_best_genome.assign(best_genome.begin(), best_genome.end());
+        return m_best_genome;
+    }
+};
+
+} // namespace dl
+
+#endif // #define ISLAND_OPTIMIZER_HEADER
@@ -0,0 +1,157 @@
+#ifndef LOCAL_SEARCH_HEADER
+#define LOCAL_SEARCH_HEADER
+
+#include <vector>
+#include <span>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+
+#include "rng.h"
+#include "pass.h"
+#include "fitness_cache.h"
+
+namespace dl
+{
+
+// Memetic refinement: a bounded hill-climb on the fittest individuals of every generation. A
+// move flips one bit of one Gray-coded variable; the low bits are the small steps around the
+// current value that crossover and bit-flip mutation rarely make near an optimum, the high bits
+// steps of every size up to the whole interval.
+//
+// Every round proposes `neighbours` moves for every climbing individual, evaluates all of them
+// in one batch through the evaluator of the run and moves every climber to its best improving
+// neighbour. A climber without one stops, and is not climbed again in later generations while
+// it stays among the fittest: the pass state of the run remembers the last max_optima of them,
+// and checkpoints keep them. The climb ends when every climber stopped or the generation's
+// `budget` of evaluations is spent, the last round proposing only what is left of it. Register
+// it first, where the population is evaluated; needs a GeneticOptimizer, whose statistics
+// count the evaluations
+class LocalSearchPass : public PopulationPass {
+    static constexpr size_t max_optima = 256;
+
+    size_t m_elites;
+    size_t m_neighbours;
+    size_t m_budget;
+
+    // the state holds the genome keys of the stopped climbers in its words, and the slot the
+    // next one replaces once there are max_optima of them as its only value
+    static bool is_optimum(const PassState& state, std::span<const Genome::GenomeType> genome) {
+        return std::find(state.words.begin(), state.words.end(), FitnessCache::key(genome)) != state.words.end();
+    }
+
+    static void add_optimum(PassState& state, std::span<const Genome::GenomeType> genome) {
+        if (state.words.size() < max_optima) {
+            state.words.push_back(FitnessCache::key(genome));
+            return;
+        }
+        if (state.values.empty())
+            state.values.push_back(0);
+        const size_t slot = static_cast<size_t>(state.values[0]);
+        state.words[slot] = FitnessCache::key(genome);
+        state.values[0] = static_cast<double>((slot + 1) % max_optima);
+    }
+public:
+    static constexpr bool needs_evaluator = true;
+
+    explicit LocalSearchPass(size_t elites = 1, size_t neighbours = 8, size_t budget = 64) :
+        m_elites(elites),
+        m_neighbours(neighbours),
+        m_budget(budget) {
+        if (m_neighbours == 0)
+            throw std::runtime_error("local search needs at least one neighbour per round");
+    }
+
+    bool evaluates() const override {
+        return needs_evaluator;
+    }
+
+    const char* name() const override {
+        return "local_search";
+    }
+
+    std::vector<double> configuration() const override {
+        return {static_cast<double>(m_elites), static_cast<double>(m_neighbours), static_cast<double>(m_budget)};
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        if (!context.evaluator)
+            throw std::runtime_error("local search needs the evaluator of the run");
+
+        std::optional<PassState> local_state;
+        PassState& optima = context.state ? *context.state : local_state.emplace();
+        std::optional<GenerationArena> local_arena;
+        GenerationArena& arena = context.arena ? *context.arena : local_arena.emplace();
+        ScratchArena& scratch = arena.scratch();
+
+        // climbers, the evaluated ones among the fittest that did not stop before
+        FitRanking& ranking = arena.ranking();
+        ranking.rank(population, m_elites, 0);
+        const auto fittest = ranking.order().first(std::min(m_elites, population.size()));
+        const auto climbers = scratch.allocate<size_t>(fittest.size());
+        size_t active = 0;
+        for (const size_t idx : fittest) {
+            if (!population.is_dirty(idx) && !is_optimum(optima, population.genome(idx)))
+                climbers[active++] = idx;
+        }
+
+        const GenomeLayout& layout = population.layout();
+        const size_t words = population.words();
+        const auto improved = scratch.allocate<uint8_t>(climbers.size());
+        Population& neighbours = arena.spare();
+        size_t remaining = m_budget;
+        for (size_t round = 0; active && remaining; ++round) {
+            // proposal p belongs to climber p % active
+            const size_t proposals = std::min(active * m_neighbours, remaining);
+            remaining -= proposals;
+            neighbours.reset(proposals, layout, false);
+
+            const RandomSource round_random = context.random.fork(round);
+            #pragma omp parallel for
+            for (size_t p = 0; p < proposals; ++p) {
+                RandomEngine engine = round_random.stream(p);
+                const auto genome = neighbours.genome(p);
+                const auto origin = population.genome(climbers[p % active]);
+                std::copy(origin.begin(), origin.end(), genome.begin());
+                const size_t bit = engine.bounded(words * layout.bits);
+                genome[bit / layout.bits] ^= uint64_t{1} << (bit % layout.bits);
+            }
+            context.evaluator->evaluate(neighbours);
+
+            const auto fits = neighbours.fits();
+            #pragma omp parallel for
+            for (size_t c = 0; c < active; ++c) {
+                const size_t idx = climbers[c];
+                size_t best = proposals;
+                double best_fit = population.fits()[idx];
+                for (size_t p = c; p < proposals; p += active) {
+                    if (fits[p] > best_fit) {
+                        best = p;
+                        best_fit = fits[p];
+                    }
+                }
+
+                improved[c] = best < proposals;
+                if (improved[c]) {
+                    const auto genome = neighbours.genome(best);
+                    std::copy(genome.begin(), genome.end(), population.genome(idx).begin());
+                    population.set_fit(idx, best_fit);
+                }
+            }
+
+            // a climber the last round of the budget proposed nothing for is no optimum
+            size_t climbing = 0;
+            for (size_t c = 0; c < active; ++c) {
+                if (improved[c])
+                    climbers[climbing++] = climbers[c];
+                else if (c < proposals)
+                    add_optimum(optima, population.genome(climbers[c]));
+            }
+            active = climbing;
+        }
+    }
+};
+
+} // namespace dl
+
+#endif // #define LOCAL_SEARCH_HEADER
@@ -0,0 +1,238 @@
+#ifndef MIGRATION_HEADER
+#define MIGRATION_HEADER
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <span>
+#include <bit>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "genome.h"
+
+namespace dl
+{
+
+enum class MigrationTopology {
+    // island i sends to island i + 1
+    RING,
+    // every island sends to every other one
+    FULLY_CONNECTED,
+};
+
+struct MigrationPolicy
+{
+    // generations between two migrations, 0 disables migration
+    size_t interval = 10;
+    // best individuals sent to every target island
+    size_t migrants = 2;
+    MigrationTopology topology = MigrationTopology::RING;
+    // synchronous migration waits for the immigrants of the same epoch, which keeps runs
+    // reproducible; asynchronous migration takes whatever already arrived and never waits
+    bool synchronous = true;
+};
+
+// islands that island sends its migrants to
+inline std::vector<size_t> migration_targets(size_t island, size_t islands, MigrationTopology topology) {
+    std::vector<size_t> targets;
+    if (islands < 2)
+        return targets;
+
+    if (topology == MigrationTopology::RING) {
+        targets.push_back((island + 1) % islands);
+    } else {
+        for (size_t target = 0; target < islands; ++target) {
+            if (target != island)
+                targets.push_back(target);
+        }
+    }
+    return targets;
+}
+
+// islands that island receives migrants from
+inline std::vector<size_t> migration_sources(size_t island, size_t islands, MigrationTopology topology) {
+    std::vector<size_t> sources;
+    if (islands < 2)
+        return sources;
+
+    if (topology == MigrationTopology::RING) {
+        sources.push_back((island + islands - 1) % islands);
+    } else {
+        for (size_t source = 0; source < islands; ++source) {
+            if (source != island)
+                sources.push_back(source);
+        }
+    }
+    return sources;
+}
+
+// Serialized individual exchanged between islands: [epoch][fit bits][encoded words...].
+// Plain 64-bit words only, so a record can be copied through any transport (threads, shared
+// memory, sockets) as is
+struct Migrant
+{
+    uint64_t epoch;
+    double fit;
+    std::span<const Genome::GenomeType> genome;
+};
+
+inline size_t migrant_record_words(const GenomeLayout& layout) {
+    return 2 + layout.words();
+}
+
+inline void encode_migrant(std::span<uint64_t> record, uint64_t epoch, double fit, std::span<const Genome::GenomeType> genome) {
+    record[0] = epoch;
+    record[1] = std::bit_cast<uint64_t>(fit);
+    std::copy(genome.begin(), genome.end(), record.begin() + 2);
+}
+
+inline Migrant decode_migrant(std::span<const uint64_t> record) {
+    return Migrant{record[0], std::bit_cast<double>(record[1]), record.subspan(2)};
+}
+
+// Lock-free single-producer single-consumer queue of fixed-size records living in a memory
+// block owned by the caller. The block holds nothing but atomics and plain words, so it may
+// be placed in memory shared between processes
+class MigrantRing
+{
+    struct Header
+    {
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        uint64_t capacity;
+        uint64_t record_words;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    Header* m_header = nullptr;
+    uint64_t* m_records = nullptr;
+
+    explicit MigrantRing(void* memory) :
+        m_header(static_cast<Header*>(memory)),
+        m_records(reinterpret_cast<uint64_t*>(static_cast<std::byte*>(memory) + sizeof(Header))) {}
+public:
+    static constexpr size_t alignment = alignof(Header);
+
+    // size of the memory block holding capacity records
+    static size_t bytes(size_t capacity, size_t record_words) {
+        return sizeof(Header) + capacity * record_words * sizeof(uint64_t);
+    }
+
+    MigrantRing() = default;
+
+    // initializes an empty ring in memory, which must be at least bytes(capacity, record_words)
+    // long and aligned to alignment
+    MigrantRing(void* memory, size_t capacity, size_t record_words) :
+        MigrantRing(memory) {
+        new (m_header) Header{};
+        m_header->capacity = std::max<size_t>(capacity, 1);
+        m_header->record_words = record_words;
+    }
+
+    // uses a ring already initialized in memory, e.g. by another process
+    static MigrantRing attach(void* memory) {
+        return MigrantRing(memory);
+    }
+
+    size_t capacity() const {
+        return m_header->capacity;
+    }
+
+    size_t record_words() const {
+        return m_header->record_words;
+    }
+
+    // records currently queued, exact only when called by the producer or the consumer
+    size_t size() const {
+        return m_header->tail.load(std::memory_order_acquire) - m_header->head.load(std::memory_order_acquire);
+    }
+
+    // producer side, returns false if the ring is full
+    bool push(std::span<const uint64_t> record) {
+        const uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+        if (tail - m_header->head.load(std::memory_order_acquire) == m_header->capacity)
+            return false;
+
+        std::copy_n(record.begin(), m_header->record_words, m_records + (tail % m_header->capacity) * m_header->record_words);
+        m_header->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, returns false if the ring is empty
+    bool pop(std::span<uint64_t> record) {
+        const uint64_t head = m_header->head.load(std::memory_order_relaxed);
+        if (head == m_header->tail.load(std::memory_order_acquire))
+            return false;
+
+        const uint64_t* slot = m_records + (head % m_header->capacity) * m_header->record_words;
+        std::copy_n(slot, m_header->record_words, record.begin());
+        m_header->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Moves migrant records between islands. send and receive never block, the caller decides
+// whether to retry or give up. Every directed edge of the topology is a separate FIFO channel
+class MigrationTransport
+{
+public:
+    virtual bool send(size_t source, size_t target, std::span<const uint64_t> record) = 0;
+    virtual bool receive(size_t source, size_t target, std::span<uint64_t> record) = 0;
+
+    virtual ~MigrationTransport() {}
+};
+
+// MigrantRing owning its memory, the mailbox of one directed edge between two islands
+class MigrantMailbox
+{
+    struct AlignedDelete
+    {
+        void operator()(std::byte* memory) const {
+            ::operator delete[](memory, std::align_val_t(MigrantRing::alignment));
+        }
+    };
+
+    std::unique_ptr<std::byte[], AlignedDelete> m_memory;
+    MigrantRing m_ring;
+public:
+    MigrantMailbox(size_t capacity, size_t record_words) :
+        m_memory(static_cast<std::byte*>(::operator new[](MigrantRing::bytes(capacity, record_words), std::align_val_t(MigrantRing::alignment)))),
+        m_ring(m_memory.get(), capacity, record_words) {}
+
+    MigrantRing& ring() {
+        return m_ring;
+    }
+};
+
+// Transport between threads of one process, one heap allocated mailbox per edge
+class MailboxTransport : public MigrationTransport
+{
+    size_t m_islands;
+    // mailbox of the edge source -> target at source * islands + target, null if there is no edge
+    std::vector<std::unique_ptr<MigrantMailbox>> m_mailboxes;
+public:
+    MailboxTransport(size_t islands, MigrationTopology topology, size_t capacity, size_t record_words) :
+        m_islands(islands),
+        m_mailboxes(islands * islands) {
+        for (size_t source = 0; source < islands; ++source) {
+            for (const size_t target : migration_targets(source, islands, topology))
+                m_mailboxes[source * islands + target] = std::make_unique<MigrantMailbox>(capacity, record_words);
+        }
+    }
+
+    bool send(size_t source, size_t target, std::span<const uint64_t> record) override {
+        return m_mailboxes[source * m_islands + target]->ring().push(record);
+    }
+
+    bool receive(size_t source, size_t target, std::span<uint64_t> record) override {
+        return m_mailboxes[source * m_islands + target]->ring().pop(record);
+    }
+};
+
+} // namespace dl
+
+#endif // #define MIGRATION_HEADER
@@ -0,0 +1,589 @@
+#ifndef MULTI_OBJECTIVE_HEADER
+#define MULTI_OBJECTIVE_HEADER
+
+#include <vector>
+#include <span>
+#include <memory>
+#include <limits>
+#include <map>
+#include <iterator>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <omp.h>
+
+#include "rng.h"
+#include "pass.h"
+#include "fitness.h"
+
+namespace dl
+{
+
+// Batch objective of a multi-objective problem: writes objectives[i * count + j] = f_j(row i of
+// x) for a chunk of transformed genomes, where count is the number of objectives. Every
+// objective is maximized. Possibly called from several threads at once
+using MultiObjectiveFunction = std::function<void(std::span<const double> x, std::span<double> objectives)>;
+
+// std::sort in parallel: every thread sorts a chunk, then the chunks are merged pairwise. The
+// result equals std::sort's for a strict total order
+template <typename T, typename Compare>
+void parallel_sort(std::span<T> values, Compare compare) {
+    const size_t size = values.size();
+    const size_t threads = static_cast<size_t>(std::max(omp_get_max_threads(), 1));
+    if (size < 4096 || threads == 1) {
+        std::sort(values.begin(), values.end(), compare);
+        return;
+    }
+
+    size_t chunks = 1;
+    while (chunks < threads)
+        chunks *= 2;
+    const auto at = [&values, size, chunks](size_t chunk) {
+        return values.begin() + size * std::min(chunk, chunks) / chunks;
+    };
+
+    #pragma omp parallel for
+    for (size_t chunk = 0; chunk < chunks; ++chunk)
+        std::sort(at(chunk), at(chunk + 1), compare);
+    for (size_t width = 1; width < chunks; width *= 2) {
+        #pragma omp parallel for
+        for (size_t chunk = 0; chunk < chunks; chunk += 2 * width)
+            std::inplace_merge(at(chunk), at(chunk + width), at(chunk + 2 * width), compare);
+    }
+}
+
+// Non-dominated sorting and crowding distances of NSGA-II over rows of objective values, every
+// objective maximized. rank() puts every point into a front (0: dominated by no point, k:
+// dominated by points of fronts below k only), gives it the crowding distance within its front
+// and orders all points by front, then by descending crowding distance.
+//
+// The points are sorted lexicographically first, so a point can only be dominated by points
+// sorted before it. With two objectives every front is then a staircase whose last point
+// dominates whatever any of its points dominates, and a sweep places each point by a binary
+// search over the last points of the fronts: O(N log N), as in Jensen's algorithm. With three,
+// every front keeps the staircase of its maxima over the last two objectives in an ordered map,
+// and the binary search over the fronts asks each staircase in O(log N): O(N log^2 N). With more,
+// the Efficient Non-dominated Sort (ENS-BS) searches the fronts binarily, checking the members of
+// a front from the most recently added one: O(M N log N) comparisons when the fronts are many and
+// small, O(M N^2) at worst, which uniformly random points approach. The sorts run in parallel;
+// crowding distances take one parallel sort per objective and a parallel pass over it
+class ParetoRanking
+{
+    size_t m_objectives = 0;
+    std::vector<uint32_t> m_fronts;
+    std::vector<double> m_crowding;
+    std::vector<size_t> m_order;
+    // front f holds positions [m_front_begin[f], m_front_begin[f + 1]) of m_order
+    std::vector<size_t> m_front_begin;
+    std::vector<size_t> m_sorted;
+    // two objectives: last point of every front; three: the staircase of every front, second
+    // objective to third, the third decreasing; more: the members of every front
+    std::vector<size_t> m_last;
+    std::vector<std::map<double, double>> m_staircases;
+    std::vector<std::vector<size_t>> m_members;
+
+    bool equal(std::span<const double> objectives, size_t q, size_t p) const {
+        return std::equal(objectives.begin() + q * m_objectives, objectives.begin() + (q + 1) * m_objectives,
+            objectives.begin() + p * m_objectives);
+    }
+
+    // q sorted before p
+    bool dominates(std::span<const double> objectives, size_t q, size_t p) const {
+        bool better = false;
+        for (size_t j = 0; j < m_objectives; ++j) {
+            const double qj = objectives[q * m_objectives + j], pj = objectives[p * m_objectives + j];
+            if (qj < pj)
+                return false;
+            better |= qj > pj;
+        }
+        return better;
+    }
+
+    size_t sort_two(std::span<const double> objectives) {
+        m_last.clear();
+        for (const size_t p : m_sorted) {
+            // the first objective of every earlier point is at least as large, so the fronts whose
+            // last point has a second one at least as large dominate p, unless it equals p
+            const double y = objectives[2 * p + 1];
+            size_t front = std::partition_point(m_last.begin(), m_last.end(), [&objectives, y](size_t q) {
+                return objectives[2 * q + 1] >= y;
+            }) - m_last.begin();
+            if (front > 0 && !dominates(objectives, m_last[front - 1], p))
+                front--;
+
+            if (front == m_last.size())
+                m_last.push_back(p);
+            else
+                m_last[front] = p;
+            m_fronts[p] = static_cast<uint32_t>(front);
+        }
+        return m_last.size();
+    }
+
+    size_t sort_three(std::span<const double> objectives) {
+        for (auto& staircase : m_staircases)
+            staircase.clear();
+
+        // an earlier point that is at least as large in the last two objectives dominates p unless
+        // it equals p, and equal points are adjacent: such a p joins the front of its twin
+        size_t fronts = 0;
+        for (size_t i = 0; i < m_sorted.size(); ++i) {
+            const size_t p = m_sorted[i];
+            if (i > 0 && equal(objectives, m_sorted[i - 1], p)) {
+                m_fronts[p] = m_fronts[m_sorted[i - 1]];
+                continue;
+            }
+
+            const double y = objectives[3 * p + 1], z = objectives[3 * p + 2];
+            size_t low = 0, high = fronts;
+            while (low < high) {
+                const size_t middle = (low + high) / 2;
+                const auto& staircase = m_staircases[middle];
+                const auto step = staircase.lower_bound(y);
+                if (step != staircase.end() && step->second >= z)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            if (low == fronts && ++fronts > m_staircases.size())
+                m_staircases.emplace_back();
+            // p replaces the steps it covers, those right below it
+            auto& staircase = m_staircases[low];
+            const auto end = staircase.upper_bound(y);
+            auto begin = end;
+            while (begin != staircase.begin() && std::prev(begin)->second <= z)
+                --begin;
+            staircase.erase(begin, end);
+            staircase.emplace(y, z);
+            m_fronts[p] = static_cast<uint32_t>(low);
+        }
+        return fronts;
+    }
+
+    size_t sort_many(std::span<const double> objectives) {
+        for (auto& members : m_members)
+            members.clear();
+
+        // a point dominated by front k is dominated by every front below k
+        size_t fronts = 0;
+        for (const size_t p : m_sorted) {
+            size_t low = 0, high = fronts;
+            while (low < high) {
+                const size_t middle = (low + high) / 2;
+                const auto& members = m_members[middle];
+                const bool dominated = std::any_of(members.rbegin(), members.rend(), [&](size_t q) {
+                    return dominates(objectives, q, p);
+                });
+                if (dominated)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            if (low == fronts && ++fronts > m_members.size())
+                m_members.emplace_back();
+            m_members[low].push_back(p);
+            m_fronts[p] = static_cast<uint32_t>(low);
+        }
+        return fronts;
+    }
+
+    void compute_crowding(std::span<const double> objectives) {
+        const size_t size = m_fronts.size();
+        std::fill(m_crowding.begin(), m_crowding.end(), 0.0);
+        for (size_t j = 0; j < m_objectives; ++j) {
+            const auto value = [&objectives, this, j](size_t i) {
+                return objectives[i * m_objectives + j];
+            };
+            std::iota(m_sorted.begin(), m_sorted.end(), size_t{0});
+            parallel_sort(std::span<size_t>(m_sorted), [this, &value](size_t lhs, size_t rhs) {
+                if (m_fronts[lhs] != m_fronts[rhs])
+                    return m_fronts[lhs] < m_fronts[rhs];
+                if (value(lhs) != value(rhs))
+                    return value(lhs) > value(rhs);
+                return lhs < rhs;
+            });
+
+            // the extremes of every front are kept, the others weighted by the normalized gap
+            // between their neighbours
+            #pragma omp parallel for
+            for (size_t i = 0; i < size; ++i) {
+                const size_t p = m_sorted[i];
+                const size_t begin = m_front_begin[m_fronts[p]], end = m_front_begin[m_fronts[p] + 1];
+                if (i == begin || i + 1 == end) {
+                    m_crowding[p] = std::numeric_limits<double>::infinity();
+                    continue;
+                }
+                const double range = value(m_sorted[begin]) - value(m_sorted[end - 1]);
+                if (range > 0)
+                    m_crowding[p] += (value(m_sorted[i - 1]) - value(m_sorted[i + 1])) / range;
+            }
+        }
+    }
+public:
+    // rows of `count` objective values, one per point
+    void rank(std::span<const double> objectives, size_t count) {
+        if (count == 0)
+            throw std::runtime_error("pareto ranking needs at least one objective");
+        m_objectives = count;
+        const size_t size = objectives.size() / count;
+        m_fronts.resize(size);
+        m_crowding.resize(size);
+        m_order.resize(size);
+        m_sorted.resize(size);
+
+        std::iota(m_sorted.begin(), m_sorted.end(), size_t{0});
+        parallel_sort(std::span<size_t>(m_sorted), [&objectives, count](size_t lhs, size_t rhs) {
+            for (size_t j = 0; j < count; ++j) {
+                const double l = objectives[lhs * count + j], r = objectives[rhs * count + j];
+                if (l != r)
+                    return l > r;
+            }
+            return lhs < rhs;
+        });
+        const size_t fronts = count == 2 ? sort_two(objectives) : count == 3 ? sort_three(objectives) : sort_many(objectives);
+
+        m_front_begin.assign(fronts + 1, 0);
+        for (const uint32_t front : m_fronts)
+            m_front_begin[front + 1]++;
+        std::partial_sum(m_front_begin.begin(), m_front_begin.end(), m_front_begin.begin());
+
+        compute_crowding(objectives);
+        std::iota(m_order.begin(), m_order.end(), size_t{0});
+        parallel_sort(std::span<size_t>(m_order), [this](size_t lhs, size_t rhs) {
+            if (m_fronts[lhs] != m_fronts[rhs])
+                return m_fronts[lhs] < m_fronts[rhs];
+            if (m_crowding[lhs] != m_crowding[rhs])
+                return m_crowding[lhs] > m_crowding[rhs];
+            return lhs < rhs;
+        });
+    }
+
+    std::span<const uint32_t> fronts() const {
+        return m_fronts;
+    }
+
+    std::span<const double> crowding() const {
+        return m_crowding;
+    }
+
+    // points by front, then by descending crowding distance, ties by index
+    std::span<const size_t> order() const {
+        return m_order;
+    }
+
+    size_t front_count() const {
+        return m_front_begin.empty() ? 0 : m_front_begin.size() - 1;
+    }
+
+    // points of front f, by descending crowding distance
+    std::span<const size_t> front(size_t f) const {
+        return std::span<const size_t>(m_order).subspan(m_front_begin[f], m_front_begin[f + 1] - m_front_begin[f]);
+    }
+
+    // scalar fit ordering points like the crowded comparison of NSGA-II: lower fronts first,
+    // then larger crowding distances; lets the tournaments of SelectionPass pick parents
+    double fit(size_t i) const {
+        const double crowding = m_crowding[i];
+        const double spread = crowding == std::numeric_limits<double>::infinity() ? 1.0 : crowding / (1.0 + crowding);
+        return -static_cast<double>(m_fronts[i]) + 0.5 * spread;
+    }
+};
+
+// Non-dominated individuals of a run, without duplicates, by descending first objective
+struct ParetoFront
+{
+    GenomeLayout layout;
+    size_t objectives = 0;
+    std::vector<Genome::GenomeType> genomes;
+    std::vector<double> values;
+
+    size_t size() const {
+        return objectives ? values.size() / objectives : 0;
+    }
+
+    std::span<const Genome::GenomeType> genome(size_t i) const {
+        return std::span<const Genome::GenomeType>(genomes).subspan(i * layout.words(), layout.words());
+    }
+
+    std::span<const double> objective_values(size_t i) const {
+        return std::span<const double>(values).subspan(i * objectives, objectives);
+    }
+};
+
+// NSGA-II: every generation the registered passes breed offspring from a copy of the parents,
+// the offspring the passes changed are evaluated, and the best population_size individuals of
+// parents and changed offspring by front and crowding distance become the next parents. The passes see the NSGA-II
+// order as the fits of the individuals (see ParetoRanking::fit), so tournament selection is the
+// crowded tournament of NSGA-II. Without registered passes, the pipeline is binary tournament
+// selection of half the population, one-point crossover and mutation of one bit per genome on
+// average.
+//
+// Evaluation, variation, sorting and crowding distances run in parallel, with the random streams
+// of GeneticOptimizer: the same seed gives the same front for any thread count
+class MultiObjectiveOptimizer
+{
+    size_t m_population_size;
+    size_t m_max_generations;
+    size_t m_objectives;
+    uint64_t m_seed;
+    size_t m_chunk_size;
+
+    std::vector<std::unique_ptr<PopulationPass>> m_passes;
+    bool m_default_pipeline = false;
+
+    MultiObjectiveFunction m_function;
+    GenomeLayout m_layout;
+    BatchTransformer m_transformer;
+
+    // parents and their objective values, one row per individual
+    Population m_population;
+    std::vector<double> m_values;
+    std::vector<uint32_t> m_fronts;
+    Population m_offspring;
+    // parents followed by the offspring the passes changed
+    Population m_union;
+    std::vector<double> m_union_values;
+    ParetoRanking m_ranking;
+    GenerationArena m_arena;
+    std::vector<PassState> m_pass_states;
+
+    RandomSource m_generations_random;
+    size_t m_generation = 0;
+    size_t m_evaluations = 0;
+    ParetoFront m_front;
+
+    // one row of values per genome
+    void evaluate(std::span<const Genome::GenomeType> genomes, std::span<double> values) {
+        const size_t words = m_layout.words();
+        const size_t size = genomes.size() / words;
+        const size_t variables = m_layout.variables;
+
+        const size_t chunks = (size + m_chunk_size - 1) / m_chunk_size;
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            const size_t begin = chunk * m_chunk_size;
+            const size_t count = std::min(m_chunk_size, size - begin);
+            thread_local std::vector<double> t_x;
+            t_x.resize(count * variables);
+            m_transformer(genomes.subspan(begin * words, count * words), t_x);
+            m_function(t_x, values.subspan(begin * m_objectives, count * m_objectives));
+        }
+        m_evaluations += size;
+    }
+
+    void register_default_pipeline() {
+        m_passes.clear();
+        m_passes.push_back(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+        m_passes.push_back(std::make_unique<CrossoverPass>());
+        m_passes.push_back(std::make_unique<MutationPass>(1.0 / m_layout.total_bits()));
+        m_default_pipeline = true;
+    }
+
+    // ranks the points of ranked and keeps the first population_size of them as parents
+    void select(const Population& ranked, std::span<const double> values) {
+        m_ranking.rank(values, m_objectives);
+        const auto survivors = m_ranking.order().first(std::min(m_population_size, ranked.size()));
+
+        Population& selected = m_arena.spare();
+        selected.gather(ranked, survivors);
+        m_values.resize(survivors.size() * m_objectives);
+        m_fronts.resize(survivors.size());
+        #pragma omp parallel for
+        for (size_t i = 0; i < survivors.size(); ++i) {
+            std::copy_n(values.begin() + survivors[i] * m_objectives, m_objectives, m_values.begin() + i * m_objectives);
+            m_fronts[i] = m_ranking.fronts()[survivors[i]];
+            selected.set_fit(i, m_ranking.fit(survivors[i]));
+        }
+        m_population.swap(selected);
+    }
+
+    void start() {
+        if (m_passes.empty() || m_default_pipeline)
+            register_default_pipeline();
+
+        m_generation = 0;
+        m_evaluations = 0;
+        m_generations_random = RandomSource(m_seed).fork(1);
+        m_pass_states.resize(m_passes.size());
+        for (auto& state : m_pass_states)
+            state.clear();
+
+        const RandomSource initial_random = RandomSource(m_seed).fork(0);
+        m_union.reset(m_population_size, m_layout, false);
+        #pragma omp parallel for
+        for (size_t i = 0; i < m_union.size(); ++i) {
+            RandomEngine engine = initial_random.stream(i);
+            for (auto& word : m_union.genome(i))
+                word = Genome(engine() & m_layout.mask()).getEncodedGenome();
+            m_union.assign(i, m_union.genome(i), 0);
+        }
+        m_union_values.resize(m_union.size() * m_objectives);
+        evaluate(m_union.genomes(), m_union_values);
+        select(m_union, m_union_values);
+    }
+public:
+    MultiObjectiveOptimizer(size_t population_size, size_t max_generations, size_t objectives, uint64_t seed = random_seed(),
+        size_t chunk_size = 1024) :
+        m_population_size(population_size),
+        m_max_generations(max_generations),
+        m_objectives(objectives),
+        m_seed(seed),
+        m_chunk_size(std::max<size_t>(chunk_size, 1)) {
+        if (m_objectives == 0)
+            throw std::runtime_error("multi-objective optimization needs at least one objective");
+    }
+
+    // breeding pipeline, replaces the default one. Offspring are evaluated and ranked in one go,
+    // so passes needing swarm state, an evaluator or the evaluated() hook are rejected
+    void register_pass(std::unique_ptr<PopulationPass> pass) {
+        if (pass->needs_swarm_state() || pass->evaluates() || pass->selects_evaluated())
+            throw std::runtime_error(std::string("the ") + pass->name() + " pass is not supported by multi-objective optimization");
+        if (m_default_pipeline) {
+            m_passes.clear();
+            m_default_pipeline = false;
+        }
+        m_passes.push_back(std::move(pass));
+    }
+
+    // start() creates and evaluates the initial population, every step() breeds and evaluates
+    // one generation of offspring and selects the next parents
+    template <size_t Variables, size_t Bits>
+    void start(MultiObjectiveFunction function, const BoxTransformer<Variables, Bits>& transformer) {
+        m_function = std::move(function);
+        m_layout = transformer.layout();
+        m_transformer = transformer;
+        start();
+    }
+
+    void start(MultiObjectiveFunction function, LinearTransformer transformer) {
+        m_function = std::move(function);
+        m_layout = GenomeLayout{};
+        m_transformer = [transformer](std::span<const Genome::GenomeType> encoded, std::span<double> x) {
+            decode_transform(encoded, x, transformer);
+        };
+        start();
+    }
+
+    void step() {
+        const RandomSource generation_random = m_generations_random.fork(m_generation);
+        m_offspring = m_population;
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            m_arena.prepare();
+            m_passes[i]->run(m_offspring, PassContext{m_generation, generation_random.fork(i), &m_arena, nullptr, &m_pass_states[i]});
+        }
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            m_arena.prepare();
+            m_passes[i]->complete(m_offspring, PassContext{m_generation, generation_random.fork(i), &m_arena, nullptr, &m_pass_states[i]});
+        }
+
+        // offspring the passes left unchanged are clones of parents: they are neither evaluated
+        // again nor ranked next to their originals
+        const size_t words = m_layout.words();
+        const size_t parents = m_population.size();
+        const auto dirty = m_offspring.dirty();
+        const size_t changed = static_cast<size_t>(std::count_if(dirty.begin(), dirty.end(), [](uint8_t flag) { return flag != 0; }));
+        m_union.reset(parents + changed, m_layout, false);
+        std::copy(m_population.genomes().begin(), m_population.genomes().end(), m_union.genomes().begin());
+        auto next = m_union.genomes().begin() + parents * words;
+        for (size_t i = 0; i < m_offspring.size(); ++i) {
+            if (dirty[i])
+                next = std::copy(m_offspring.genome(i).begin(), m_offspring.genome(i).end(), next);
+        }
+
+        m_union_values.resize(m_union.size() * m_objectives);
+        std::copy(m_values.begin(), m_values.end(), m_union_values.begin());
+        evaluate(m_union.genomes().subspan(parents * words), std::span<double>(m_union_values).subspan(parents * m_objectives));
+        select(m_union, m_union_values);
+        m_generation++;
+    }
+
+    bool finished() const {
+        return m_generation > m_max_generations;
+    }
+
+    // non-dominated individuals of the current parents, valid until the next step
+    const ParetoFront& front() {
+        std::vector<size_t> members;
+        for (size_t i = 0; i < m_population.size(); ++i) {
+            if (m_fronts[i] == 0)
+                members.push_back(i);
+        }
+        const auto value = [this](size_t i) {
+            return std::span<const double>(m_values).subspan(i * m_objectives, m_objectives);
+        };
+        const auto genome = [this](size_t i) {
+            return m_population.genome(i);
+        };
+        std::sort(members.begin(), members.end(), [&](size_t lhs, size_t rhs) {
+            const auto l = value(lhs), r = value(rhs);
+            for (size_t j = 0; j < m_objectives; ++j) {
+                if (l[j] != r[j])
+                    return l[j] > r[j];
+            }
+            return std::lexicographical_compare(genome(lhs).begin(), genome(lhs).end(), genome(rhs).begin(), genome(rhs).end());
+        });
+        members.erase(std::unique(members.begin(), members.end(), [&](size_t lhs, size_t rhs) {
+            return std::equal(genome(lhs).begin(), genome(lhs).end(), genome(rhs).begin());
+        }), members.end());
+
+        m_front.layout = m_layout;
+        m_front.objectives = m_objectives;
+        m_front.genomes.clear();
+        m_front.values.clear();
+        for (const size_t i : members) {
+            m_front.genomes.insert(m_front.genomes.end(), genome(i).begin(), genome(i).end());
+            m_front.values.insert(m_front.values.end(), value(i).begin(), value(i).end());
+        }
+        return m_front;
+    }
+
+    template <size_t Variables, size_t Bits>
+    const ParetoFront& optimize(MultiObjectiveFunction function, const BoxTransformer<Variables, Bits>& transformer) {
+        start(std::move(function), transformer);
+        while (!finished())
+            step();
+        return front();
+    }
+
+    const ParetoFront& optimize(MultiObjectiveFunction function, LinearTransformer transformer) {
+        start(std::move(function), transformer);
+        while (!finished())
+            step();
+        return front();
+    }
+
+    size_t objectives() const {
+        return m_objectives;
+    }
+
+    size_t generation() const {
+        return m_generation;
+    }
+
+    // objective evaluations of the current run
+    size_t evaluations() const {
+        return m_evaluations;
+    }
+
+    const Population& population() const {
+        return m_population;
+    }
+
+    // objective values of the parents, one row per individual
+    std::span<const double> objective_values() const {
+        return m_values;
+    }
+
+    // front of every parent within parents and offspring of the last generation
+    std::span<const uint32_t> fronts() const {
+        return m_fronts;
+    }
+};
+
+} // namespace dl
+
+#endif // #define MULTI_OBJECTIVE_HEADER
@@ -0,0 +1,103 @@
+#ifndef MUTATION_HEADER
+#define MUTATION_HEADER
+
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#include "rng.h"
+
+namespace dl
+{
+
+// Flips every bit of a genome independently with a fixed probability p, without drawing one
+// random number per bit:
+//  - low p: jumps straight from one flipped bit to the next with geometrically distributed gaps,
+//    so the cost is proportional to the number of flips (one draw for an untouched genome);
+//  - high p: builds each word from the binary expansion of p, combining one random word per
+//    digit (r | m for a one, r & m for a zero), 16 draws per word instead of 64
+class BernoulliMaskGenerator
+{
+    using WordType = uint64_t;
+
+    // digits of p used by the bit-sliced path, p is truncated to a multiple of 2^-precision
+    static constexpr unsigned precision = 16;
+    // below this p the expected gap is long enough for the geometric path to win
+    static constexpr double geometric_threshold = 1.0 / 16;
+
+    enum Mode {
+        NEVER,
+        GEOMETRIC,
+        BIT_SLICED,
+        ALWAYS,
+    } m_mode;
+    double m_log_complement = 0; // log(1 - p)
+    uint32_t m_fixed_point = 0;  // p * 2^precision
+
+    WordType bit_sliced_word(RandomEngine& engine) const {
+        WordType mask = 0;
+        for (unsigned digit = 0; digit < precision; ++digit) {
+            const WordType random = engine();
+            mask = (m_fixed_point >> digit) & 1 ? (random | mask) : (random & mask);
+        }
+        return mask;
+    }
+
+    // number of untouched bits before the next flip
+    size_t geometric_gap(RandomEngine& engine) const {
+        const double gap = std::floor(std::log1p(-engine.uniform()) / m_log_complement);
+        return gap < static_cast<double>(SIZE_MAX / 2) ? static_cast<size_t>(gap) : SIZE_MAX / 2;
+    }
+public:
+    explicit BernoulliMaskGenerator(double probability) {
+        if (!(probability > 0)) {
+            m_mode = NEVER;
+        } else if (probability >= 1) {
+            m_mode = ALWAYS;
+        } else if (probability < geometric_threshold) {
+            m_mode = GEOMETRIC;
+            m_log_complement = std::log1p(-probability);
+        } else {
+            m_mode = BIT_SLICED;
+            m_fixed_point = static_cast<uint32_t>(std::ldexp(probability, precision));
+        }
+    }
+
+    // XORs flips into the low `bits` bits of every word, returns whether anything flipped
+    bool apply(std::span<WordType> words, size_t bits, RandomEngine& engine) const {
+        const WordType valid = bits >= 64 ? ~WordType{0} : (WordType{1} << bits) - 1;
+        switch (m_mode) {
+            case NEVER:
+                return false;
+            case ALWAYS:
+                for (auto& word : words)
+                    word ^= valid;
+                return !words.empty() && valid;
+            case GEOMETRIC:
+            {
+                const size_t total_bits = words.size() * bits;
+                bool changed = false;
+                for (size_t position = geometric_gap(engine); position < total_bits; position += 1 + geometric_gap(engine)) {
+                    words[position / bits] ^= WordType{1} << (position % bits);
+                    changed = true;
+                }
+                return changed;
+            }
+            case BIT_SLICED:
+            {
+                WordType changed = 0;
+                for (auto& word : words) {
+                    const WordType flips = bit_sliced_word(engine) & valid;
+                    word ^= flips;
+                    changed |= flips;
+                }
+                return changed;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace dl
+
+#endif // #define MUTATION_HEADER
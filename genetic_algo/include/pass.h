@@ -1,179 +1,457 @@
+#ifndef PASS_HEADER
+#define PASS_HEADER
+
 #include <vector>
-#include <unordered_map>
+#include <algorithm>
 #include <stdexcept>
 #include <tuple>
-#include <set>
+#include <optional>
 
-#include "offspring.h"
+#include "population.h"
+#include "arena.h"
+#include "fitness.h"
 
 namespace dl
 {
 
-using Population = std::vector<Offspring>;
+// State a pass carries from one generation to the next, e.g. adapted parameters. The
+// optimizer running the pass owns it, so a pass object stays stateless and may serve several
+// runs; start() clears it, checkpoints store it and resume() restores it
+struct PassState
+{
+    std::vector<double> values;
+    std::vector<uint64_t> words;
+
+    bool empty() const {
+        return values.empty() && words.empty();
+    }
+
+    void clear() {
+        values.clear();
+        words.clear();
+    }
+
+    bool operator==(const PassState&) const = default;
+};
+
+// State handed by the optimizer to a pass for one generation
+struct PassContext
+{
+    size_t generation;
+    // root of this pass' random streams, unique per (run seed, generation, pass)
+    RandomSource random;
+    // memory lent by the optimizer, passes run on their own fall back to a temporary one
+    GenerationArena* arena = nullptr;
+    // evaluator of the run, for passes that evaluate individuals of their own; counted in the
+    // run's statistics. Null outside of GeneticOptimizer
+    const FitnessEvaluator* evaluator = nullptr;
+    // state of this pass in the run, passes run on their own without one start from scratch
+    PassState* state = nullptr;
+};
 
 class PopulationPass {
 public:
-    virtual void run(Population& population, size_t generation) const = 0;
+    // passes evaluating individuals of their own through PassContext::evaluator set it, so
+    // optimizers without an evaluator can reject them at compile time
+    static constexpr bool needs_evaluator = false;
+
+    virtual void run(Population& population, const PassContext& context) const = 0;
+
+    // passes reading velocities or personal bests make the optimizer allocate swarm state
+    virtual bool needs_swarm_state() const {
+        return false;
+    }
+
+    // needs_evaluator of a pass held through a PopulationPass pointer
+    virtual bool evaluates() const {
+        return needs_evaluator;
+    }
+
+    // passes whose output is only decided in evaluated(), e.g. by choosing between individuals
+    virtual bool selects_evaluated() const {
+        return false;
+    }
+
+    // static string naming the pass in telemetry
+    virtual const char* name() const {
+        return "pass";
+    }
+
+    // called once every pass of the generation ran, in registration order, before the
+    // population is evaluated; lets a pass finish what its run() started
+    virtual void complete(Population&, const PassContext&) const {}
+
+    // called once the population the generation produced was evaluated, in registration
+    // order, before it is ranked; lets a pass choose between evaluated individuals
+    virtual void evaluated(Population&, const PassContext&) const {}
+
+    // parameters shaping the output of the pass; checkpoints store them so that a run cannot
+    // be resumed by a different pipeline
+    virtual std::vector<double> configuration() const {
+        return {};
+    }
+
     virtual ~PopulationPass() {}
 };
 
 class SelectionPass : public PopulationPass {
+public:
     enum SelectionStrategy {
         ROULETTE_WHEEL_SELECTION,
         RANK_SELECTION,
         TOURNAMENT_SELECTION,
         INVALID_SELECTION,
-    } m_selection_strategy;
+    };
+private:
+    SelectionStrategy m_selection_strategy;
     float m_rate;
-    
-    template <typename It>
-    size_t roulette_wheel_selection(It begin, It end) const {
-        std::uniform_real_distribution distribution{};
-        size_t population_size = std::distance(begin, end);
-        size_t winner_idx = 0;
-        double population_fitness = 0.0;
-
-        for (auto it = begin; it != end; ++it)
-            population_fitness += it->second.fit;
-        
-        std::vector<double> probabilities;
-        
-        probabilities.reserve(population_size);
-        for (auto it = begin; it != end; ++it)
-            probabilities.push_back(it->second.fit / population_fitness);
-
-        // accumulate probabilities
+    size_t m_tournament_size;
+    double m_rank_pressure;
+
+    // prefix sums of the selection weights; order maps a position in cumulative to a
+    // population index
+    struct CumulativeTable
+    {
+        std::span<double> cumulative;
+        std::span<size_t> order;
+    };
+
+    // builds the table once per generation in scratch memory
+    CumulativeTable build_cumulative(const Population& population, ScratchArena& scratch) const {
+        const size_t population_size = population.size();
+        const auto fits = population.fits();
+        const CumulativeTable table{scratch.allocate<double>(population_size), scratch.allocate<size_t>(population_size)};
+        const auto cumulative = table.cumulative;
+        const auto order = table.order;
+        for (size_t i = 0; i < population_size; ++i)
+            order[i] = i;
+
+        if (m_selection_strategy == ROULETTE_WHEEL_SELECTION) {
+            // fits may be negative, so weights are taken relative to the worst one
+            const double min_fit = *std::min_element(fits.begin(), fits.end());
+            for (size_t i = 0; i < population_size; ++i)
+                cumulative[i] = fits[i] - min_fit;
+        } else {
+            // linear ranking: worst gets 2 - pressure, best gets pressure
+            std::sort(order.begin(), order.end(), [fits](size_t lhs, size_t rhs) {
+                return fits[lhs] < fits[rhs];
+            });
+            const double step = population_size > 1 ? 2.0 * (m_rank_pressure - 1.0) / (population_size - 1) : 0.0;
+            for (size_t i = 0; i < population_size; ++i)
+                cumulative[i] = 2.0 - m_rank_pressure + step * i;
+        }
+
+        // accumulate serially: summation order must not depend on the thread count
         for (size_t i = 1; i < population_size; ++i)
-            probabilities[i] += probabilities[i - 1];
-        
-        double roulette_probability = distribution(random_engine);
-        for (size_t i = 0; i < probabilities.size(); ++i) {
-            if (probabilities[i] > roulette_probability) {
-                winner_idx = i;
-                break;
-            }
+            cumulative[i] += cumulative[i - 1];
+
+        // degenerate weights (e.g. all fits equal) fall back to uniform selection
+        if (!(cumulative.back() > 0.0)) {
+            for (size_t i = 0; i < population_size; ++i)
+                cumulative[i] = static_cast<double>(i + 1);
+        }
+        return table;
+    }
+
+    // O(log n) draw from the prefix sums
+    static size_t cumulative_selection(const CumulativeTable& table, RandomEngine& engine) {
+        const double target = engine.uniform() * table.cumulative.back();
+        size_t position = std::upper_bound(table.cumulative.begin(), table.cumulative.end(), target) - table.cumulative.begin();
+        return table.order[std::min(position, table.cumulative.size() - 1)];
+    }
+
+    size_t tournament_selection(std::span<const double> fits, RandomEngine& engine) const {
+        size_t winner_idx = engine.bounded(fits.size());
+        for (size_t i = 1; i < m_tournament_size; ++i) {
+            const size_t contender_idx = engine.bounded(fits.size());
+            if (fits[contender_idx] > fits[winner_idx])
+                winner_idx = contender_idx;
         }
 
-        auto it = begin;
-        std::advance(it, winner_idx);
-        return it->first;
+        return winner_idx;
     }
 public:
-    SelectionPass(SelectionStrategy selection_strategy = ROULETTE_WHEEL_SELECTION, float rate = 0.5) :
+    SelectionPass(SelectionStrategy selection_strategy = ROULETTE_WHEEL_SELECTION, float rate = 0.5,
+        size_t tournament_size = 2, double rank_pressure = 1.5) :
         m_selection_strategy(selection_strategy),
-        m_rate(rate) {}
+        m_rate(rate),
+        m_tournament_size(std::max<size_t>(tournament_size, 1)),
+        m_rank_pressure(std::clamp(rank_pressure, 1.0, 2.0)) {}
 
-    void run(Population& population, size_t generation) const override {
-        (void) generation;
+    const char* name() const override {
+        return "selection";
+    }
 
-        size_t new_population_size = static_cast<size_t>(population.size() * m_rate);
-        std::unordered_map<size_t, Offspring> population_hashmap;
+    std::vector<double> configuration() const override {
+        return {static_cast<double>(m_selection_strategy), m_rate, static_cast<double>(m_tournament_size), m_rank_pressure};
+    }
 
-        std::sort(population.rbegin(), population.rend());
-        for (size_t i = 0; i < population.size(); ++i)
-            population_hashmap[i] = population[i];
-        
-        Population new_population;
-        new_population.reserve(new_population_size);
-
-        std::set<size_t> unique_winners;
-        while (unique_winners.size() < new_population_size) {
-            std::vector<size_t> new_population_idxs(new_population_size);
-
-            #pragma omp parallel for
-            for (size_t i = 0; i < new_population_size; ++i) {
-                size_t winner_idx = 0;
-                switch (m_selection_strategy) {
-                    case ROULETTE_WHEEL_SELECTION:
-                    {
-                        winner_idx = roulette_wheel_selection(population_hashmap.begin(), population_hashmap.end());
-                        break;
-                    }
-                    default:
-                        throw std::runtime_error("unknown selection strategy");
-                }
-                
-                new_population_idxs[i] = winner_idx;
-            }
+    // Per-individual form, draws one parent. Tournaments are O(tournament size); roulette and
+    // rank selection rebuild their table from the current fits in scratch, O(n) and O(n log n)
+    size_t select(const Population& population, RandomEngine& engine, ScratchArena& scratch) const {
+        switch (m_selection_strategy) {
+            case ROULETTE_WHEEL_SELECTION:
+            case RANK_SELECTION:
+                return cumulative_selection(build_cumulative(population, scratch), engine);
+            case TOURNAMENT_SELECTION:
+                return tournament_selection(population.fits(), engine);
+            default:
+                throw std::runtime_error("unknown selection strategy");
+        }
+    }
+
+    size_t select(const Population& population, RandomEngine& engine) const {
+        ScratchArena scratch;
+        return select(population, engine, scratch);
+    }
 
-            unique_winners.insert(new_population_idxs.begin(), new_population_idxs.end());
-            for (const auto& winner_idx : unique_winners)
-                population_hashmap.erase(winner_idx);
+    // survivors are drawn with replacement, every draw is independent and O(log n) at most
+    void run(Population& population, const PassContext& context) const override {
+        const size_t new_population_size = static_cast<size_t>(population.size() * m_rate);
+        if (population.empty() || new_population_size == 0) {
+            population.clear();
+            return;
         }
 
-        for (const auto& winner_idx : unique_winners)
-            new_population.push_back(population[winner_idx]);
-        
-        new_population.resize(new_population_size);
-        population = std::move(new_population);
+        std::optional<GenerationArena> local_arena;
+        GenerationArena& arena = context.arena ? *context.arena : local_arena.emplace();
+        ScratchArena& scratch = arena.scratch();
+
+        CumulativeTable table;
+        switch (m_selection_strategy) {
+            case ROULETTE_WHEEL_SELECTION:
+            case RANK_SELECTION:
+                table = build_cumulative(population, scratch);
+                break;
+            case TOURNAMENT_SELECTION:
+                break;
+            default:
+                throw std::runtime_error("unknown selection strategy");
+        }
+
+        const auto fits = population.fits();
+        const auto winners = scratch.allocate<size_t>(new_population_size);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < new_population_size; ++i) {
+            RandomEngine engine = context.random.stream(i);
+            winners[i] = m_selection_strategy == TOURNAMENT_SELECTION ?
+                tournament_selection(fits, engine) : cumulative_selection(table, engine);
+        }
+
+        Population& selected = arena.spare();
+        selected.gather(population, winners);
+        population.swap(selected);
+    }
+};
+
+// Keeps the best individuals of the generation unchanged: run() sets the top elites aside and
+// complete() writes them over the last slots of the final population, after every other pass
+// is done. Their fit is kept, so they are neither mutated nor re-evaluated. Register it first;
+// needs the arena of an optimizer
+class ElitismPass : public PopulationPass {
+    size_t m_elites;
+public:
+    explicit ElitismPass(size_t elites = 1) :
+        m_elites(elites) {}
+
+    const char* name() const override {
+        return "elitism";
+    }
+
+    std::vector<double> configuration() const override {
+        return {static_cast<double>(m_elites)};
+    }
+
+    size_t elites() const {
+        return m_elites;
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        if (!context.arena)
+            throw std::runtime_error("elitism pass needs the arena of an optimizer");
+
+        // fits are those of the last evaluation, the top is found without sorting everyone
+        FitRanking& ranking = context.arena->ranking();
+        ranking.rank(population, m_elites, 0);
+        Population& elites = context.arena->elites();
+        elites.gather(population, ranking.order().first(std::min(m_elites, population.size())));
+    }
+
+    void complete(Population& population, const PassContext& context) const override {
+        if (!context.arena)
+            throw std::runtime_error("elitism pass needs the arena of an optimizer");
+
+        const Population& elites = context.arena->elites();
+        const size_t size = population.size();
+        const size_t count = std::min(elites.size(), size);
+        for (size_t j = 0; j < count; ++j)
+            population.copy(size - count + j, elites, j);
     }
 };
 
 class CrossoverPass : public PopulationPass {
+public:
+    // every strategy combines each word of the parents with a single mask
     enum CrossoverStrategy {
+        // bits at or above a random point of the whole genome come from the first parent
         ONE_POINT_CROSSOVER,
-        INVLAID_CROSSOVER,
-    } m_crossover_strategy;
+        // bits between two random points come from the second parent
+        TWO_POINT_CROSSOVER,
+        // every bit from a random parent
+        UNIFORM_CROSSOVER,
+        // every variable (word) whole from a random parent, keeps the values of the parents
+        VARIABLE_CROSSOVER,
+        INVALID_CROSSOVER,
+    };
+private:
+    using GenomeType = Genome::GenomeType;
+
+    CrossoverStrategy m_crossover_strategy;
     size_t m_birth_rate;
 
-    Offspring one_point_crossover(const Offspring& lhs, const Offspring& rhs, size_t generation) const {
-        using GenomeType = Genome::GenomeType;
-        const size_t genome_size = Genome::getGenomeSize();
-
-        std::uniform_int_distribution<size_t> distribution(0, genome_size);
-        size_t point_idx = distribution(random_engine);
-
-        const GenomeType lhs_genome = lhs.genome.getEncodedGenome();
-        const GenomeType rhs_genome = rhs.genome.getEncodedGenome();
+    // bits [from, to) of the whole genome that fall into the given word
+    static GenomeType range_mask(size_t word, size_t from, size_t to, const GenomeLayout& layout) {
+        const size_t word_begin = word * layout.bits;
+        const size_t local_from = std::clamp(from, word_begin, word_begin + layout.bits) - word_begin;
+        const size_t local_to = std::clamp(to, word_begin, word_begin + layout.bits) - word_begin;
+        const GenomeType below_to = local_to >= 64 ? ~GenomeType{0} : (GenomeType{1} << local_to) - 1;
+        const GenomeType below_from = local_from >= 64 ? ~GenomeType{0} : (GenomeType{1} << local_from) - 1;
+        return below_to & ~below_from;
+    }
 
-        const GenomeType mask1 = (static_cast<GenomeType>(-1) >> point_idx) << point_idx;
-        const GenomeType mask2 = static_cast<GenomeType>(-1) ^ mask1;
-        const GenomeType child_genome = (lhs_genome & mask1) ^ (rhs_genome & mask2); 
-        
-        return Offspring{child_genome, generation}; // we update fit later
+    // child = lhs where mask is set, rhs elsewhere
+    static GenomeType combine(GenomeType lhs, GenomeType rhs, GenomeType mask, const GenomeLayout& layout) {
+        return ((lhs & mask) | (rhs & ~mask)) & layout.mask();
     }
 public:
     CrossoverPass(CrossoverStrategy crossover_strategy = ONE_POINT_CROSSOVER, size_t birth_rate = 2) :
         m_crossover_strategy(crossover_strategy),
-        m_birth_rate(birth_rate) {}
-
-    void run(Population& population, size_t generation) const override {
-        const size_t initial_population_size = population.size();
-        population.reserve(m_birth_rate * initial_population_size);
-
-        for (size_t i = 0; i < (m_birth_rate - 1) * initial_population_size; ++i) {
-            size_t first_parent, second_parent;
-            std::uniform_int_distribution<size_t> distribution(0, initial_population_size);
-            do {
-                first_parent = distribution(random_engine);
-                second_parent = distribution(random_engine);
-            } while (first_parent == second_parent);
-
-            Offspring child{};
-            switch (m_crossover_strategy) {
-                case ONE_POINT_CROSSOVER:
-                    child = one_point_crossover(population[first_parent], population[second_parent], generation);
-                    break;
-                default:
-                    throw std::runtime_error("unknown crossover strategy");
-            }
+        m_birth_rate(std::max<size_t>(birth_rate, 1)) {}
 
-            population.push_back(child);
+    const char* name() const override {
+        return "crossover";
+    }
+
+    std::vector<double> configuration() const override {
+        return {static_cast<double>(m_crossover_strategy), static_cast<double>(m_birth_rate)};
+    }
+
+    // per-individual form, child may alias either parent
+    void crossover(std::span<const GenomeType> lhs_genome, std::span<const GenomeType> rhs_genome,
+        std::span<GenomeType> child_genome, const GenomeLayout& layout, RandomEngine& engine) const {
+        const size_t words = layout.words();
+        switch (m_crossover_strategy) {
+            case ONE_POINT_CROSSOVER: {
+                const size_t point = engine.bounded(layout.total_bits() + 1);
+                for (size_t word = 0; word < words; ++word)
+                    child_genome[word] = combine(lhs_genome[word], rhs_genome[word], range_mask(word, point, layout.total_bits(), layout), layout);
+                break;
+            }
+            case TWO_POINT_CROSSOVER: {
+                size_t first = engine.bounded(layout.total_bits() + 1);
+                size_t second = engine.bounded(layout.total_bits() + 1);
+                if (first > second)
+                    std::swap(first, second);
+                for (size_t word = 0; word < words; ++word)
+                    child_genome[word] = combine(lhs_genome[word], rhs_genome[word], ~range_mask(word, first, second, layout), layout);
+                break;
+            }
+            case UNIFORM_CROSSOVER:
+                for (size_t word = 0; word < words; ++word)
+                    child_genome[word] = combine(lhs_genome[word], rhs_genome[word], engine(), layout);
+                break;
+            case VARIABLE_CROSSOVER: {
+                // one draw decides 64 variables
+                GenomeType choices = 0;
+                for (size_t word = 0; word < words; ++word) {
+                    if (word % 64 == 0)
+                        choices = engine();
+                    const GenomeType mask = (choices >> (word % 64)) & 1 ? ~GenomeType{0} : 0;
+                    child_genome[word] = combine(lhs_genome[word], rhs_genome[word], mask, layout);
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("unknown crossover strategy");
         }
     }
+
+    // Per-individual form, which StaticGeneticOptimizer fuses with the adjacent passes:
+    // begin() appends (birth rate - 1) child slots per individual, individual() fills a child
+    // slot and leaves the parents alone. Every child slot draws its parents and masks from its
+    // own stream, so slots are filled in parallel and the result does not depend on the thread count
+    void begin(Population& population, const PassContext&) const {
+        if (m_crossover_strategy >= INVALID_CROSSOVER)
+            throw std::runtime_error("unknown crossover strategy");
+        population.resize(population.size() * m_birth_rate);
+    }
+
+    void individual(Population& population, size_t idx, const PassContext& context) const {
+        const size_t parents = population.size() / m_birth_rate;
+        if (idx < parents)
+            return;
+
+        RandomEngine engine = context.random.stream(idx - parents);
+        // two distinct parents without rejection: the second is offset from the first
+        const size_t first_parent = engine.bounded(parents);
+        const size_t second_parent = parents > 1 ? (first_parent + 1 + engine.bounded(parents - 1)) % parents : first_parent;
+
+        // the child slot is written in place, we update fit later
+        population.assign(idx, population.genome(first_parent), context.generation);
+        crossover(population.genome(first_parent), population.genome(second_parent), population.genome(idx), population.layout(), engine);
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        begin(population, context);
+        const size_t parents = population.size() / m_birth_rate;
+
+        #pragma omp parallel for
+        for (size_t idx = parents; idx < population.size(); ++idx)
+            individual(population, idx, context);
+    }
 };
 
 class MutationPass : public PopulationPass {
     double m_mutation_probability;
+    BernoulliMaskGenerator m_generator;
 public:
     MutationPass(double mutation_probability) :
-        m_mutation_probability(mutation_probability) {}
+        m_mutation_probability(mutation_probability),
+        m_generator(mutation_probability) {}
 
-    void run(Population& population, size_t generation) const override {
-        for (auto it = population.begin(); it != population.end(); ++it) {
-            if (it->generation == generation)
-                it->genome.mutate(m_mutation_probability);
-        }
+    const char* name() const override {
+        return "mutation";
+    }
+
+    std::vector<double> configuration() const override {
+        return {m_mutation_probability};
+    }
+
+    double mutation_probability() const {
+        return m_mutation_probability;
+    }
+
+    // per-individual form, returns true if any bit flipped
+    bool mutate(std::span<Genome::GenomeType> genome, size_t bits, RandomEngine& engine) const {
+        return m_generator.apply(genome, bits, engine);
+    }
+
+    // per-individual form (see CrossoverPass::begin): mutates the individuals born in this generation
+    void begin(Population&, const PassContext&) const {}
+
+    void individual(Population& population, size_t idx, const PassContext& context) const {
+        if (population.generations()[idx] != context.generation)
+            return;
+        RandomEngine engine = context.random.stream(idx);
+        if (mutate(population.genome(idx), population.layout().bits, engine))
+            population.mark_dirty(idx);
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        #pragma omp parallel for
+        for (size_t i = 0; i < population.size(); ++i)
+            individual(population, i, context);
     }
 };
 
@@ -183,20 +461,59 @@ public:
     ParticleSwarmOptimizationPass(double c1, double c2) :
         m_c1(c1), m_c2(c2) {}
 
-    void run(Population& population, size_t generation) const override {
-        (void) generation;
+    bool needs_swarm_state() const override {
+        return true;
+    }
+
+    const char* name() const override {
+        return "particle_swarm";
+    }
+
+    std::vector<double> configuration() const override {
+        return {m_c1, m_c2};
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        using GenomeType = Genome::GenomeType;
 
-        Genome best_popoulation_genome;
-        double best_population_fit = 0;
+        population.enable_swarm_state();
+        const size_t words = population.words();
+        const GenomeType mask = population.layout().mask();
+        const auto genomes = population.genomes();
+        const auto velocities = population.velocities();
+        const auto best_fits = population.best_fits();
+        const auto best_genomes = population.best_genomes();
+
+        // every variable moves independently as a scalar, towards personal and population best
+        size_t best_population_idx = population.size();
+        double best_population_fit = Population::no_fit;
         for (size_t i = 0; i < population.size(); ++i) {
-            if (population[i].best_fit > best_population_fit) {
-                best_population_fit = population[i].best_fit;
-                best_popoulation_genome = population[i].best_genome;
+            if (best_fits[i] > best_population_fit) {
+                best_population_fit = best_fits[i];
+                best_population_idx = i;
             }
         }
 
-        for (auto& offspring : population) {
-            offspring.update_velocity(m_c1, m_c2, best_popoulation_genome);
+        for (size_t i = 0; i < population.size(); ++i) {
+            RandomEngine engine = context.random.stream(i);
+            const double r1 = engine.uniform();
+            const double r2 = engine.uniform();
+            bool changed = false;
+
+            for (size_t word = 0; word < words; ++word) {
+                const size_t k = i * words + word;
+                const GenomeType g = genomes[k];
+                const GenomeType best_popoulation_genome = best_population_idx < population.size() ?
+                    best_genomes[best_population_idx * words + word] : 0;
+
+                velocities[k] += m_c1 * r1 * (best_genomes[k] - g) + m_c2 * r2 * (best_popoulation_genome - g);
+                const GenomeType moved = static_cast<GenomeType>(g + velocities[k]) & mask;
+                genomes[k] = Genome(moved).getEncodedGenome();
+                changed |= genomes[k] != g;
+            }
+
+            if (changed)
+                population.mark_dirty(i);
         }
     }
 };
@@ -230,4 +547,5 @@ public:
 //     }
 // };
 
-} // namespace dl
\ No newline at end of file
+} // namespace dl
+#endif // #define PASS_HEADER
@@ -0,0 +1,432 @@
+#ifndef POPULATION_HEADER
+#define POPULATION_HEADER
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <omp.h>
+
+#include "offspring.h"
+
+namespace dl
+{
+
+// Structure-of-arrays storage of a population: every attribute of the individuals lives in its
+// own contiguous array, passes address individuals by index. Genomes are stored as
+// layout.words() consecutive words per individual. Particle swarm state (per-variable velocity
+// and personal best) is only allocated when requested, since most pipelines never touch it
+class PopulationStore
+{
+public:
+    using GenomeType = Genome::GenomeType;
+
+    // personal best fit of an individual that was never evaluated, below any real fit
+    static constexpr double no_fit = -std::numeric_limits<double>::infinity();
+private:
+    GenomeLayout m_layout;
+    size_t m_size = 0;
+
+    std::vector<GenomeType> m_genomes; // encoded values
+    std::vector<double> m_fits;
+    std::vector<uint32_t> m_generations;
+    // set when the genome changed since its fit was computed
+    std::vector<uint8_t> m_dirty;
+
+    bool m_with_swarm_state = false;
+    std::vector<double> m_velocities;
+    std::vector<double> m_best_fits;
+    std::vector<GenomeType> m_best_genomes;
+public:
+    explicit PopulationStore(size_t size = 0, GenomeLayout layout = {}, bool with_swarm_state = false) :
+        m_layout(layout),
+        m_with_swarm_state(with_swarm_state) {
+        resize(size);
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    const GenomeLayout& layout() const {
+        return m_layout;
+    }
+
+    size_t words() const {
+        return m_layout.words();
+    }
+
+    // drops the individuals if the layout changes
+    void set_layout(GenomeLayout layout) {
+        if (layout == m_layout)
+            return;
+        clear();
+        m_layout = layout;
+    }
+
+    bool with_swarm_state() const {
+        return m_with_swarm_state;
+    }
+
+    void enable_swarm_state() {
+        if (m_with_swarm_state)
+            return;
+        m_with_swarm_state = true;
+        resize(size());
+        std::copy(m_genomes.begin(), m_genomes.end(), m_best_genomes.begin());
+        for (size_t i = 0; i < size(); ++i)
+            m_best_fits[i] = m_dirty[i] ? no_fit : m_fits[i];
+    }
+
+    // shrinking keeps the capacity, so a store that reached its steady-state size stops allocating
+    void resize(size_t size) {
+        m_size = size;
+        m_genomes.resize(size * words());
+        m_fits.resize(size);
+        m_generations.resize(size);
+        m_dirty.resize(size, 1);
+        if (m_with_swarm_state) {
+            m_velocities.resize(size * words());
+            m_best_fits.resize(size, no_fit);
+            m_best_genomes.resize(size * words());
+        }
+    }
+
+    void reserve(size_t capacity) {
+        m_genomes.reserve(capacity * words());
+        m_fits.reserve(capacity);
+        m_generations.reserve(capacity);
+        m_dirty.reserve(capacity);
+        if (m_with_swarm_state) {
+            m_velocities.reserve(capacity * words());
+            m_best_fits.reserve(capacity);
+            m_best_genomes.reserve(capacity * words());
+        }
+    }
+
+    void clear() {
+        resize(0);
+    }
+
+    // reinitializes the store for another run; the buffers keep the capacity they grew, so
+    // runs reusing a store stop allocating once it held the largest of them
+    void reset(size_t size, GenomeLayout layout, bool with_swarm_state) {
+        clear();
+        m_velocities.clear();
+        m_best_fits.clear();
+        m_best_genomes.clear();
+        m_layout = layout;
+        m_with_swarm_state = with_swarm_state;
+        resize(size);
+    }
+
+    void swap(PopulationStore& other) {
+        std::swap(m_layout, other.m_layout);
+        std::swap(m_size, other.m_size);
+        m_genomes.swap(other.m_genomes);
+        m_fits.swap(other.m_fits);
+        m_generations.swap(other.m_generations);
+        m_dirty.swap(other.m_dirty);
+        std::swap(m_with_swarm_state, other.m_with_swarm_state);
+        m_velocities.swap(other.m_velocities);
+        m_best_fits.swap(other.m_best_fits);
+        m_best_genomes.swap(other.m_best_genomes);
+    }
+
+    // all genomes, words() entries per individual
+    std::span<GenomeType> genomes() { return m_genomes; }
+    std::span<const GenomeType> genomes() const { return m_genomes; }
+    std::span<double> fits() { return m_fits; }
+    std::span<const double> fits() const { return m_fits; }
+    std::span<uint32_t> generations() { return m_generations; }
+    std::span<const uint32_t> generations() const { return m_generations; }
+    std::span<uint8_t> dirty() { return m_dirty; }
+    std::span<const uint8_t> dirty() const { return m_dirty; }
+
+    std::span<GenomeType> genome(size_t idx) {
+        return {m_genomes.data() + idx * words(), words()};
+    }
+
+    std::span<const GenomeType> genome(size_t idx) const {
+        return {m_genomes.data() + idx * words(), words()};
+    }
+
+    // empty unless the store was created with swarm state; velocities have one entry per variable
+    std::span<double> velocities() { return m_velocities; }
+    std::span<const double> velocities() const { return m_velocities; }
+    std::span<double> best_fits() { return m_best_fits; }
+    std::span<const double> best_fits() const { return m_best_fits; }
+    std::span<GenomeType> best_genomes() { return m_best_genomes; }
+    std::span<const GenomeType> best_genomes() const { return m_best_genomes; }
+
+    bool is_dirty(size_t idx) const {
+        return m_dirty[idx];
+    }
+
+    // passes that modify genomes in place must mark them, so that only they get re-evaluated
+    void mark_dirty(size_t idx) {
+        m_dirty[idx] = 1;
+    }
+
+    void mark_all_dirty() {
+        std::fill(m_dirty.begin(), m_dirty.end(), 1);
+    }
+
+    // (re)initializes the slot as a fresh individual of the given generation
+    void assign(size_t idx, std::span<const GenomeType> encoded_genome, size_t generation) {
+        if (encoded_genome.data() != genome(idx).data())
+            std::copy_n(encoded_genome.begin(), words(), genome(idx).begin());
+        m_fits[idx] = 0;
+        m_generations[idx] = static_cast<uint32_t>(generation);
+        m_dirty[idx] = 1;
+        if (m_with_swarm_state) {
+            std::fill_n(m_velocities.begin() + idx * words(), words(), 0.0);
+            m_best_fits[idx] = no_fit;
+            std::copy_n(encoded_genome.begin(), words(), m_best_genomes.begin() + idx * words());
+        }
+    }
+
+    // single-word layouts only
+    void assign(size_t idx, GenomeType encoded_genome, size_t generation) {
+        assign(idx, std::span<const GenomeType>(&encoded_genome, 1), generation);
+    }
+
+    void set_fit(size_t idx, double fit) {
+        m_fits[idx] = fit;
+        m_dirty[idx] = 0;
+        if (m_with_swarm_state && fit > m_best_fits[idx]) {
+            m_best_fits[idx] = fit;
+            std::copy_n(m_genomes.begin() + idx * words(), words(), m_best_genomes.begin() + idx * words());
+        }
+    }
+
+    // single-word layouts only
+    void update_fit(size_t idx, const FitnessFunction& fitness_function, const GenomeTranformer& transformer) {
+        set_fit(idx, fitness_function(transformer(Genome::fromEncodedGenome(m_genomes[idx * words()]).getDecodedGenome())));
+    }
+
+    // copies individual from_idx of another store (or this one) with the same layout into slot idx
+    void copy(size_t idx, const PopulationStore& from, size_t from_idx) {
+        const size_t stride = words();
+        std::copy_n(from.m_genomes.begin() + from_idx * stride, stride, m_genomes.begin() + idx * stride);
+        m_fits[idx] = from.m_fits[from_idx];
+        m_generations[idx] = from.m_generations[from_idx];
+        m_dirty[idx] = from.m_dirty[from_idx];
+        if (m_with_swarm_state) {
+            if (from.m_with_swarm_state) {
+                std::copy_n(from.m_velocities.begin() + from_idx * stride, stride, m_velocities.begin() + idx * stride);
+                m_best_fits[idx] = from.m_best_fits[from_idx];
+                std::copy_n(from.m_best_genomes.begin() + from_idx * stride, stride, m_best_genomes.begin() + idx * stride);
+            } else {
+                std::fill_n(m_velocities.begin() + idx * stride, stride, 0.0);
+                m_best_fits[idx] = no_fit;
+                std::copy_n(from.m_genomes.begin() + from_idx * stride, stride, m_best_genomes.begin() + idx * stride);
+            }
+        }
+    }
+
+    // this[i] = from[indices[i]] for every i; this and from must be different stores
+    void gather(const PopulationStore& from, std::span<const size_t> indices) {
+        set_layout(from.m_layout);
+        if (from.m_with_swarm_state)
+            enable_swarm_state();
+        resize(indices.size());
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < indices.size(); ++i)
+            copy(i, from, indices[i]);
+    }
+
+    // Offspring snapshots hold the first word of the genome only
+    Offspring get(size_t idx) const {
+        Offspring offspring(Genome::fromEncodedGenome(genome(idx)[0]), m_generations[idx]);
+        offspring.fit = m_fits[idx];
+        if (m_with_swarm_state) {
+            offspring.velocity = m_velocities[idx * words()];
+            offspring.best_fit = m_best_fits[idx];
+            offspring.best_genome = Genome::fromEncodedGenome(m_best_genomes[idx * words()]);
+        }
+        return offspring;
+    }
+
+    void set(size_t idx, const Offspring& offspring) {
+        genome(idx)[0] = offspring.genome.getEncodedGenome();
+        m_fits[idx] = offspring.fit;
+        m_generations[idx] = static_cast<uint32_t>(offspring.generation);
+        m_dirty[idx] = 1;
+        if (m_with_swarm_state) {
+            m_velocities[idx * words()] = offspring.velocity;
+            m_best_fits[idx] = offspring.best_fit;
+            m_best_genomes[idx * words()] = offspring.best_genome.getEncodedGenome();
+        }
+    }
+
+    void push_back(const Offspring& offspring) {
+        resize(size() + 1);
+        set(size() - 1, offspring);
+    }
+};
+
+using Population = PopulationStore;
+
+// Fills order with the permutation sorting the population by descending fit. Only indices are
+// moved around, the individuals themselves stay in place
+inline void sort_by_fit(const PopulationStore& population, std::vector<size_t>& order) {
+    const auto fits = population.fits();
+    order.resize(fits.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    // ties are broken by index, so the permutation is fully determined by the fits
+    std::sort(order.begin(), order.end(), [fits](size_t lhs, size_t rhs) {
+        return fits[lhs] > fits[rhs] || (fits[lhs] == fits[rhs] && lhs < rhs);
+    });
+}
+
+// Partial version of sort_by_fit for when only the extremes of the population matter (the best
+// individual, elites, migrants and the individuals they replace). rank(best, worst) fills order
+// with a permutation whose first best entries are the fittest individuals in descending order
+// and whose last worst entries are the least fit ones, the worst last; the entries between
+// keep index order. The ranked entries equal those of the full sort. Every thread keeps bounded
+// heaps of its chunk's best and worst candidates, which are merged afterwards:
+// O(n log k / threads + threads k log k) instead of O(n log n)
+class FitRanking
+{
+    std::vector<size_t> m_order;
+    std::vector<size_t> m_candidates;
+    // per thread: best candidates, worst candidates, unranked individuals
+    std::vector<size_t> m_counts;
+    size_t m_best = 0;
+    size_t m_worst = 0;
+public:
+    void rank(const PopulationStore& population, size_t best, size_t worst) {
+        const auto fits = population.fits();
+        const size_t size = fits.size();
+        best = std::min(best, size);
+        worst = std::min(worst, size - best);
+        m_best = best;
+        m_worst = worst;
+
+        // small populations or large ranks: the full sort is as cheap
+        if (size < 1024 || 4 * (best + worst) >= size) {
+            sort_by_fit(population, m_order);
+            return;
+        }
+
+        // strict total order, ties broken by index
+        const auto better = [fits](size_t lhs, size_t rhs) {
+            return fits[lhs] > fits[rhs] || (fits[lhs] == fits[rhs] && lhs < rhs);
+        };
+        const auto worse = [&better](size_t lhs, size_t rhs) {
+            return better(rhs, lhs);
+        };
+
+        const size_t threads = static_cast<size_t>(std::max(omp_get_max_threads(), 1));
+        m_order.resize(size);
+        // the best heaps of all threads, then their worst heaps
+        m_candidates.resize(threads * (best + worst));
+        m_counts.resize(3 * threads);
+
+        #pragma omp parallel num_threads(threads)
+        {
+            const size_t team = static_cast<size_t>(omp_get_num_threads());
+            const size_t thread = static_cast<size_t>(omp_get_thread_num());
+            const size_t begin = size * thread / team, end = size * (thread + 1) / team;
+
+            // the top of the best heap is the worst of the kept candidates and vice versa
+            size_t* best_heap = m_candidates.data() + thread * best;
+            size_t* worst_heap = m_candidates.data() + threads * best + thread * worst;
+            size_t best_count = 0, worst_count = 0;
+            for (size_t i = begin; i < end; ++i) {
+                if (best_count < best) {
+                    best_heap[best_count++] = i;
+                    std::push_heap(best_heap, best_heap + best_count, better);
+                } else if (best && better(i, best_heap[0])) {
+                    std::pop_heap(best_heap, best_heap + best, better);
+                    best_heap[best - 1] = i;
+                    std::push_heap(best_heap, best_heap + best, better);
+                }
+                if (worst_count < worst) {
+                    worst_heap[worst_count++] = i;
+                    std::push_heap(worst_heap, worst_heap + worst_count, worse);
+                } else if (worst && worse(i, worst_heap[0])) {
+                    std::pop_heap(worst_heap, worst_heap + worst, worse);
+                    worst_heap[worst - 1] = i;
+                    std::push_heap(worst_heap, worst_heap + worst, worse);
+                }
+            }
+            m_counts[3 * thread] = best_count;
+            m_counts[3 * thread + 1] = worst_count;
+
+            #pragma omp barrier
+            #pragma omp single
+            {
+                // merge the candidates of all threads, every ranked individual is among them
+                const auto best_candidates = m_candidates.begin();
+                size_t merged = 0;
+                for (size_t t = 0; t < team; ++t) {
+                    for (size_t j = 0; j < m_counts[3 * t]; ++j)
+                        best_candidates[merged++] = best_candidates[t * best + j];
+                }
+                std::partial_sort(best_candidates, best_candidates + best, best_candidates + merged, better);
+                std::copy_n(best_candidates, best, m_order.begin());
+
+                const auto worst_candidates = m_candidates.begin() + threads * best;
+                merged = 0;
+                for (size_t t = 0; t < team; ++t) {
+                    for (size_t j = 0; j < m_counts[3 * t + 1]; ++j)
+                        worst_candidates[merged++] = worst_candidates[t * worst + j];
+                }
+                std::partial_sort(worst_candidates, worst_candidates + worst, worst_candidates + merged, worse);
+                std::reverse_copy(worst_candidates, worst_candidates + worst, m_order.end() - worst);
+            }
+
+            // the unranked individuals are compacted in index order
+            const auto ranked = [&](size_t i) {
+                return (best && !better(m_order[best - 1], i)) || (worst && !worse(m_order[size - worst], i));
+            };
+            size_t unranked = 0;
+            for (size_t i = begin; i < end; ++i)
+                unranked += !ranked(i);
+            m_counts[3 * thread + 2] = unranked;
+
+            #pragma omp barrier
+            size_t position = best;
+            for (size_t t = 0; t < thread; ++t)
+                position += m_counts[3 * t + 2];
+            for (size_t i = begin; i < end; ++i) {
+                if (!ranked(i))
+                    m_order[position++] = i;
+            }
+        }
+    }
+
+    // ranks everyone
+    void sort(const PopulationStore& population) {
+        sort_by_fit(population, m_order);
+        m_best = m_order.size();
+        m_worst = 0;
+    }
+
+    std::span<const size_t> order() const {
+        return m_order;
+    }
+
+    // number of ranked entries at the front and the back of order()
+    size_t best() const {
+        return m_best;
+    }
+
+    size_t worst() const {
+        return m_worst;
+    }
+};
+
+} // namespace dl
+
+#endif // #define POPULATION_HEADER
@@ -0,0 +1,295 @@
+#ifndef PROCESS_ISLANDS_HEADER
+#define PROCESS_ISLANDS_HEADER
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <bit>
+#include <omp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "island_optimizer.h"
+
+namespace dl
+{
+
+// Anonymous shared memory mapping, visible to the processes forked after its creation
+class SharedMemoryBlock
+{
+    void* m_memory = nullptr;
+    size_t m_bytes = 0;
+public:
+    explicit SharedMemoryBlock(size_t bytes) :
+        m_bytes(std::max<size_t>(bytes, 1)) {
+        m_memory = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (m_memory == MAP_FAILED)
+            throw std::runtime_error(std::string("failed to map shared memory: ") + std::strerror(errno));
+    }
+
+    SharedMemoryBlock(const SharedMemoryBlock&) = delete;
+    SharedMemoryBlock& operator=(const SharedMemoryBlock&) = delete;
+
+    ~SharedMemoryBlock() {
+        munmap(m_memory, m_bytes);
+    }
+
+    std::byte* data() const {
+        return static_cast<std::byte*>(m_memory);
+    }
+
+    size_t size() const {
+        return m_bytes;
+    }
+};
+
+// Transport between forked processes: one MigrantRing per edge, all in one shared mapping.
+// Must be created before the workers are forked
+class SharedMemoryTransport : public MigrationTransport
+{
+    size_t m_islands;
+    std::unique_ptr<SharedMemoryBlock> m_memory;
+    // ring of the edge source -> target at source * islands + target
+    std::vector<MigrantRing> m_rings;
+public:
+    SharedMemoryTransport(size_t islands, MigrationTopology topology, size_t capacity, size_t record_words) :
+        m_islands(islands),
+        m_rings(islands * islands) {
+        // page aligned mapping, rings padded to their alignment
+        const size_t alignment = MigrantRing::alignment;
+        const size_t stride = (MigrantRing::bytes(capacity, record_words) + alignment - 1) / alignment * alignment;
+
+        size_t edges = 0;
+        for (size_t source = 0; source < islands; ++source)
+            edges += migration_targets(source, islands, topology).size();
+        m_memory = std::make_unique<SharedMemoryBlock>(edges * stride);
+
+        size_t edge = 0;
+        for (size_t source = 0; source < islands; ++source) {
+            for (const size_t target : migration_targets(source, islands, topology))
+                m_rings[source * islands + target] = MigrantRing(m_memory->data() + (edge++) * stride, capacity, record_words);
+        }
+    }
+
+    bool send(size_t source, size_t target, std::span<const uint64_t> record) override {
+        return m_rings[source * m_islands + target].push(record);
+    }
+
+    bool receive(size_t source, size_t target, std::span<uint64_t> record) override {
+        return m_rings[source * m_islands + target].pop(record);
+    }
+};
+
+// creates the transport of a run; called in the parent before forking, so the transport must
+// stay usable from the forked workers (shared memory, socket pairs...)
+using TransportFactory = std::function<std::unique_ptr<MigrationTransport>(size_t islands,
+    MigrationTopology topology, size_t capacity, size_t record_words)>;
+
+// Island model over processes: every island of an IslandOptimizer configuration runs in its
+// own forked worker, so a run is not bound to the memory and the OpenMP team of one process.
+// Workers exchange the same migrant records as threads do, through a pluggable transport
+// (shared memory by default), and report their best individual through shared memory.
+// With synchronous migration the result equals the one of the threaded IslandOptimizer
+class ProcessIslandOptimizer : public OptimizerFrontend<ProcessIslandOptimizer>
+{
+    // result slot of a worker: [status][fit bits][evaluation counters x4][error message][encoded words...]
+    static constexpr size_t message_words = 32;
+    static constexpr size_t message_offset = 6;
+    static constexpr size_t result_header_words = message_offset + message_words;
+    static constexpr uint64_t worker_succeeded = 1;
+    static constexpr uint64_t worker_failed = 2;
+
+    // copies the message, truncated and null terminated, into the message area of a result slot
+    static void report_error(std::span<uint64_t> result, const char* message) {
+        char* text = reinterpret_cast<char*>(result.data() + message_offset);
+        const size_t length = std::min(std::strlen(message), message_words * sizeof(uint64_t) - 1);
+        std::memcpy(text, message, length);
+        text[length] = '\0';
+        result[0] = worker_failed;
+    }
+
+    IslandOptimizer m_model;
+    TransportFactory m_transport_factory;
+    size_t m_threads_per_island = 0;
+
+    EvaluationStatistics m_statistics;
+    size_t m_best_island = 0;
+    std::vector<Genome::GenomeType> m_best_genome;
+
+    [[noreturn]] void run_worker(size_t island, const FitnessEvaluator& evaluator, MigrationTransport& transport,
+        std::span<uint64_t> result) const {
+        int status = 1;
+        try {
+            omp_set_num_threads(static_cast<int>(threads_per_island()));
+            const auto optimizer = m_model.create_island(island);
+            FitnessEvaluator island_evaluator = evaluator;
+            const Island owned{island, optimizer.get(), &island_evaluator};
+            evolve_islands(std::span<const Island>(&owned, 1), islands(), m_model.policy(), transport);
+
+            const auto best_genome = optimizer->finish(island_evaluator);
+            const EvaluationStatistics& statistics = optimizer->statistics();
+            result[1] = std::bit_cast<uint64_t>(optimizer->best_fit());
+            result[2] = statistics.evaluations;
+            result[3] = statistics.skipped;
+            result[4] = statistics.cache_lookups;
+            result[5] = statistics.cache_hits;
+            std::copy(best_genome.begin(), best_genome.end(), result.begin() + result_header_words);
+            result[0] = worker_succeeded;
+            status = 0;
+        } catch (const std::exception& e) {
+            report_error(result, e.what());
+        } catch (...) {
+            report_error(result, "unknown exception");
+        }
+
+        // skip the exit handlers and stdio buffers inherited from the parent
+        _exit(status);
+    }
+
+    // waits for all workers, kills the remaining ones as soon as one of them fails
+    static bool wait_workers(std::vector<pid_t> workers) {
+        bool succeeded = true;
+        while (!workers.empty()) {
+            bool reaped = false;
+            for (size_t i = 0; i < workers.size(); ++i) {
+                int status = 0;
+                const pid_t pid = waitpid(workers[i], &status, WNOHANG);
+                if (pid == 0)
+                    continue;
+
+                if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    // a synchronous run cannot progress without this island
+                    succeeded = false;
+                    for (const pid_t worker : workers) {
+                        if (worker != workers[i])
+                            kill(worker, SIGKILL);
+                    }
+                }
+                workers.erase(workers.begin() + i);
+                reaped = true;
+                break;
+            }
+            if (!reaped)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return succeeded;
+    }
+public:
+    using OptimizerFrontend<ProcessIslandOptimizer>::optimize;
+
+    ProcessIslandOptimizer(size_t islands, size_t island_population_size, size_t max_generations, PipelineFactory pipeline,
+        MigrationPolicy policy = {}, uint64_t seed = random_seed()) :
+        m_model(islands, island_population_size, max_generations, std::move(pipeline), policy, seed),
+        m_transport_factory([](size_t islands, MigrationTopology topology, size_t capacity, size_t record_words) {
+            return std::make_unique<SharedMemoryTransport>(islands, topology, capacity, record_words);
+        })
+    {}
+
+    uint64_t seed() const {
+        return m_model.seed();
+    }
+
+    size_t islands() const {
+        return m_model.islands();
+    }
+
+    void enable_fitness_cache(size_t capacity) {
+        m_model.enable_fitness_cache(capacity);
+    }
+
+    void set_transport_factory(TransportFactory factory) {
+        m_transport_factory = std::move(factory);
+    }
+
+    // OpenMP threads of every worker, by default the threads of this process split between them
+    size_t threads_per_island() const {
+        return m_threads_per_island ? m_threads_per_island :
+            std::max<size_t>(omp_get_max_threads() / islands(), 1);
+    }
+
+    void set_threads_per_island(size_t threads) {
+        m_threads_per_island = threads;
+    }
+
+    // evaluation counters of the last optimize call, summed over the workers
+    const EvaluationStatistics& statistics() const {
+        return m_statistics;
+    }
+
+    size_t best_island() const {
+        return m_best_island;
+    }
+
+    // returns the encoded words of the best individual over all islands, valid until the next call
+    std::span<const Genome::GenomeType> optimize(FitnessEvaluator evaluator)
+    {
+        // an invalid pipeline throws here rather than in every worker
+        m_model.create_island(0);
+
+        const GenomeLayout layout = evaluator.layout();
+        const auto transport = m_transport_factory(islands(), m_model.policy().topology, m_model.channel_capacity(),
+            migrant_record_words(layout));
+
+        const size_t result_words = result_header_words + layout.words();
+        const SharedMemoryBlock results_memory(islands() * result_words * sizeof(uint64_t));
+        const std::span<uint64_t> results(reinterpret_cast<uint64_t*>(results_memory.data()), islands() * result_words);
+        std::fill(results.begin(), results.end(), 0);
+
+        std::vector<pid_t> workers;
+        for (size_t island = 0; island < islands(); ++island) {
+            const pid_t pid = fork();
+            if (pid == 0)
+                run_worker(island, evaluator, *transport, results.subspan(island * result_words, result_words));
+
+            if (pid < 0) {
+                for (const pid_t worker : workers)
+                    kill(worker, SIGKILL);
+                wait_workers(workers);
+                throw std::runtime_error(std::string("failed to fork island worker: ") + std::strerror(errno));
+            }
+            workers.push_back(pid);
+        }
+
+        if (!wait_workers(workers)) {
+            // the lowest island that reported its exception, the others may have been killed
+            for (size_t island = 0; island < islands(); ++island) {
+                const auto result = results.subspan(island * result_words, result_words);
+                if (result[0] == worker_failed) {
+                    throw std::runtime_error("island worker " + std::to_string(island) + " failed: " +
+                        reinterpret_cast<const char*>(result.data() + message_offset));
+                }
+            }
+            throw std::runtime_error("island worker failed");
+        }
+
+        m_statistics = EvaluationStatistics{};
+        m_best_island = 0;
+        for (size_t island = 0; island < islands(); ++island) {
+            const auto result = results.subspan(island * result_words, result_words);
+            if (result[0] != worker_succeeded)
+                throw std::runtime_error("island worker did not report a result");
+            m_statistics += EvaluationStatistics{result[2], result[3], result[4], result[5]};
+
+            // ties go to the lowest island, as in IslandOptimizer
+            const auto best_result = results.subspan(m_best_island * result_words, result_words);
+            if (std::bit_cast<double>(result[1]) > std::bit_cast<double>(best_result[1]))
+                m_best_island = island;
+        }
+
+        const auto best_genome = results.subspan(m_best_island * result_words + result_header_words, layout.words());
+        m_best_genome.assign(best_genome.begin(), best_genome.end());
+        return m_best_genome;
+    }
+};
+
+} // namespace dl
+
+#endif // #define PROCESS_ISLANDS_HEADER
@@ -2,12 +2,95 @@
 #define RNG_HEADER
 
 #include <random>
+#include <cstdint>
+#include <limits>
 
 namespace dl
 {
 
-static std::random_device _random_device;
-static std::mt19937_64 random_engine{_random_device()};
+// splitmix64 finalizer: a cheap bijective 64-bit mixer
+constexpr uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+constexpr uint64_t golden_gamma = 0x9e3779b97f4a7c15ull;
+
+// Counter-based engine: n-th output is a pure function of (key, n), so the same stream
+// yields the same values no matter which thread consumes it. Models UniformRandomBitGenerator,
+// so std distributions work with it, but the helpers below are cheaper and portable.
+class RandomEngine
+{
+    uint64_t m_key;
+    uint64_t m_counter = 0;
+public:
+    using result_type = uint64_t;
+
+    explicit RandomEngine(uint64_t key = 0) : m_key(key) {}
+
+    static constexpr result_type min() {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        return mix64(m_key + (++m_counter) * golden_gamma);
+    }
+
+    // uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // uniform integer in [0, bound), multiply-shift reduction (bias is below 2^-64 * bound)
+    uint64_t bounded(uint64_t bound) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * bound) >> 64);
+    }
+};
+
+// Root of the random streams of one optimization run. Streams are addressed by a path of
+// integers (generation, pass, individual...) instead of the thread that uses them, so a run is
+// reproducible from a single seed for any number of OpenMP threads
+class RandomSource
+{
+    uint64_t m_key;
+
+    struct KeyTag {};
+    RandomSource(uint64_t key, KeyTag) : m_key(key) {}
+public:
+    explicit RandomSource(uint64_t seed = 0) : m_key(mix64(seed ^ golden_gamma)) {}
+
+    RandomSource fork(uint64_t id) const {
+        return RandomSource(mix64(m_key ^ mix64(id + golden_gamma)), KeyTag{});
+    }
+
+    RandomEngine stream(uint64_t id) const {
+        return RandomEngine(fork(id).m_key);
+    }
+
+    uint64_t key() const {
+        return m_key;
+    }
+};
+
+// uniform double in [0, 1) of the n-th output (n >= 1) of a RandomEngine with the given key;
+// branch-free, so kernels can draw their random numbers inside vectorized loops
+inline double uniform_at(uint64_t key, uint64_t n) {
+    return static_cast<double>(mix64(key + n * golden_gamma) >> 11) * 0x1.0p-53;
+}
+
+// nondeterministic seed for callers that do not care about reproducibility
+inline uint64_t random_seed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
 
 }
 
@@ -0,0 +1,176 @@
+#ifndef SCHEDULER_HEADER
+#define SCHEDULER_HEADER
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <utility>
+
+namespace dl
+{
+
+// Work-stealing thread pool. Every worker owns a deque: tasks submitted from a worker go to
+// the back of its own deque and are taken back LIFO, idle workers steal from the front of the
+// other deques. Tasks may submit further tasks; wait() returns once all of them are done
+class WorkStealingScheduler
+{
+public:
+    using Task = std::function<void()>;
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    // tasks sitting in the deques, and tasks submitted but not finished yet
+    std::atomic<size_t> m_queued{0};
+    std::atomic<size_t> m_unfinished{0};
+    std::atomic<size_t> m_next_worker{0};
+    std::atomic<size_t> m_steals{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop = false;
+    std::exception_ptr m_exception;
+
+    inline static thread_local const WorkStealingScheduler* t_scheduler = nullptr;
+    inline static thread_local size_t t_worker = 0;
+
+    bool pop(size_t self, Task& task) {
+        Worker& worker = *m_workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty())
+            return false;
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t self, Task& task) {
+        for (size_t k = 1; k < m_workers.size(); ++k) {
+            Worker& victim = *m_workers[(self + k) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(Task& task) {
+        m_queued--;
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_exception)
+                m_exception = std::current_exception();
+        }
+        task = nullptr;
+
+        if (--m_unfinished == 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+
+    void work(size_t self) {
+        t_scheduler = this;
+        t_worker = self;
+
+        Task task;
+        while (true) {
+            if (pop(self, task) || steal(self, task)) {
+                run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+            if (m_stop)
+                return;
+        }
+    }
+public:
+    explicit WorkStealingScheduler(size_t threads = std::thread::hardware_concurrency()) {
+        threads = std::max<size_t>(threads, 1);
+        for (size_t i = 0; i < threads; ++i)
+            m_workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < threads; ++i)
+            m_threads.emplace_back([this, i] { work(i); });
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    ~WorkStealingScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    size_t threads() const {
+        return m_threads.size();
+    }
+
+    // index of the calling worker in [0, threads()), threads() when called from another thread
+    size_t current_worker() const {
+        return t_scheduler == this ? t_worker : m_threads.size();
+    }
+
+    // tasks taken from another worker's deque since construction
+    size_t steals() const {
+        return m_steals.load();
+    }
+
+    void submit(Task task) {
+        const size_t target = t_scheduler == this ? t_worker : m_next_worker++ % m_workers.size();
+        m_unfinished++;
+        {
+            // counted under the lock and before it is queued, so a worker about to sleep cannot
+            // miss the task and the counter never drops below zero
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued++;
+        }
+        {
+            Worker& worker = *m_workers[target];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+        m_wake.notify_one();
+    }
+
+    // blocks until every submitted task (and every task they submitted) finished, then
+    // rethrows the first exception thrown by a task. Must not be called from a worker
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_unfinished.load() == 0; });
+        if (m_exception) {
+            std::exception_ptr exception = std::exchange(m_exception, nullptr);
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace dl
+
+#endif // #define SCHEDULER_HEADER
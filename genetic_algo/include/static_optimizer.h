@@ -0,0 +1,306 @@
+#ifndef STATIC_OPTIMIZER_HEADER
+#define STATIC_OPTIMIZER_HEADER
+
+#include <array>
+#include <tuple>
+#include <span>
+#include <vector>
+#include <utility>
+#include <concepts>
+#include <type_traits>
+
+#include "rng.h"
+#include "pass.h"
+#include "fitness.h"
+
+namespace dl
+{
+
+// Passes with a per-individual form (see CrossoverPass::begin): begin() does the work that is
+// not per individual, individual() processes one individual. individual() writes only its own
+// individual, and reads others only when called for an individual appended by a begin() of
+// the same generation
+template <typename Pass>
+concept IndividualPass = std::derived_from<Pass, PopulationPass> &&
+    requires(const Pass& pass, Population& population, size_t idx, const PassContext& context) {
+        pass.begin(population, context);
+        pass.individual(population, idx, context);
+    };
+
+// whether Pass overrides PopulationPass::complete, e.g. ElitismPass
+template <typename Pass>
+inline constexpr bool overrides_complete =
+    !std::is_same_v<decltype(&Pass::complete), void (PopulationPass::*)(Population&, const PassContext&) const>;
+
+// Objective of one individual, with the genome shape known at compile time
+template <typename Transformer>
+struct StaticTransform;
+
+template <size_t Variables, size_t Bits>
+struct StaticTransform<BoxTransformer<Variables, Bits>>
+{
+    static constexpr GenomeLayout layout() {
+        return BoxTransformer<Variables, Bits>::layout();
+    }
+
+    template <typename Fitness>
+    static double evaluate(const Fitness& fitness, const BoxTransformer<Variables, Bits>& transformer,
+        std::span<const Genome::GenomeType> genome) {
+        std::array<double, Variables> x;
+        transformer(genome, x);
+        return fitness(std::span<const double>(x));
+    }
+};
+
+template <>
+struct StaticTransform<LinearTransformer>
+{
+    static constexpr GenomeLayout layout() {
+        return GenomeLayout{};
+    }
+
+    template <typename Fitness>
+    static double evaluate(const Fitness& fitness, const LinearTransformer& transformer, std::span<const Genome::GenomeType> genome) {
+        return fitness(transformer(gray_decode(genome[0])));
+    }
+};
+
+// GeneticOptimizer with the pipeline, the objective and the transformer fixed at compile time:
+// passes are held by value and called without virtual dispatch, the objective and the
+// transformer are inlined into the evaluation. Adjacent IndividualPasses are fused into one loop
+// over the population, and a fused group ending the pipeline evaluates every individual right
+// after its last pass touched it, while the genome is still in cache. A pipeline with a pass
+// overriding complete() evaluates after the complete() hooks instead, as GeneticOptimizer does,
+// so that nothing complete() overwrites is evaluated.
+//
+// The same seed and pipeline give the populations of a GeneticOptimizer run. Fitness takes
+// std::span<const double> for a BoxTransformer, a double for a LinearTransformer. Telemetry,
+// stop conditions, checkpoints and caching stay with the runtime-registered GeneticOptimizer, as
+// do passes that need the evaluator of the run (see PopulationPass::needs_evaluator)
+template <typename Fitness, typename Transformer, typename... Passes>
+class StaticGeneticOptimizer
+{
+    static_assert((std::derived_from<Passes, PopulationPass> && ...), "passes must be PopulationPasses");
+    static_assert(!(Passes::needs_evaluator || ...), "passes evaluating individuals of their own need a GeneticOptimizer");
+
+    using Transform = StaticTransform<Transformer>;
+    using PassTuple = std::tuple<Passes...>;
+
+    static constexpr size_t pass_count = sizeof...(Passes);
+    // evaluation in the last fused group, when no complete() hook may overwrite what it evaluated
+    static constexpr bool fuses_evaluation = !(overrides_complete<Passes> || ...);
+
+    template <size_t I>
+    using PassAt = std::tuple_element_t<I, PassTuple>;
+
+    // end of the group of IndividualPasses starting at I
+    template <size_t I>
+    static constexpr size_t group_end() {
+        if constexpr (I < pass_count) {
+            if constexpr (IndividualPass<PassAt<I>>)
+                return group_end<I + 1>();
+        }
+        return I;
+    }
+
+    size_t m_population_size;
+    size_t m_max_generations;
+    uint64_t m_seed;
+
+    Fitness m_fitness;
+    Transformer m_transformer;
+    PassTuple m_passes;
+
+    Population m_population;
+    size_t m_generation = 0;
+    size_t m_evaluations = 0;
+    RandomSource m_generations_random;
+    FitRanking m_ranking;
+    GenerationArena m_arena;
+    std::array<PassState, pass_count> m_pass_states;
+
+    std::vector<Genome::GenomeType> m_best_genome;
+
+    // returns 1 if the individual was evaluated
+    size_t evaluate_if_dirty(size_t idx) {
+        if (!m_population.is_dirty(idx))
+            return 0;
+        m_population.set_fit(idx, Transform::evaluate(m_fitness, m_transformer, m_population.genome(idx)));
+        return 1;
+    }
+
+    void evaluate_dirty() {
+        size_t evaluations = 0;
+        #pragma omp parallel for reduction(+:evaluations)
+        for (size_t i = 0; i < m_population.size(); ++i)
+            evaluations += evaluate_if_dirty(i);
+        m_evaluations += evaluations;
+    }
+
+    PassContext context(const RandomSource& generation_random, size_t pass) {
+        return PassContext{m_generation, generation_random.fork(pass), &m_arena, nullptr, &m_pass_states[pass]};
+    }
+
+    // passes [Begin, End) in one loop over the individuals
+    template <size_t Begin, size_t End>
+    void run_group(const RandomSource& generation_random) {
+        constexpr bool evaluates = End == pass_count && fuses_evaluation;
+        const size_t existing = m_population.size();
+
+        m_arena.prepare();
+        std::array<PassContext, End - Begin> contexts;
+        for (size_t j = 0; j < contexts.size(); ++j)
+            contexts[j] = context(generation_random, Begin + j);
+        [&]<size_t... J>(std::index_sequence<J...>) {
+            (std::get<Begin + J>(m_passes).begin(m_population, contexts[J]), ...);
+        }(std::make_index_sequence<End - Begin>{});
+
+        const auto body = [&](size_t idx) -> size_t {
+            [&]<size_t... J>(std::index_sequence<J...>) {
+                (std::get<Begin + J>(m_passes).individual(m_population, idx, contexts[J]), ...);
+            }(std::make_index_sequence<End - Begin>{});
+            if constexpr (evaluates)
+                return evaluate_if_dirty(idx);
+            else
+                return 0;
+        };
+
+        // appended individuals first, they may read the existing ones, which change only afterwards
+        size_t evaluations = 0;
+        #pragma omp parallel for reduction(+:evaluations)
+        for (size_t idx = existing; idx < m_population.size(); ++idx)
+            evaluations += body(idx);
+        #pragma omp parallel for reduction(+:evaluations)
+        for (size_t idx = 0; idx < std::min(existing, m_population.size()); ++idx)
+            evaluations += body(idx);
+        m_evaluations += evaluations;
+    }
+
+    template <size_t I>
+    void run_passes(const RandomSource& generation_random) {
+        if constexpr (I < pass_count) {
+            if constexpr (IndividualPass<PassAt<I>>) {
+                constexpr size_t end = group_end<I>();
+                run_group<I, end>(generation_random);
+                run_passes<end>(generation_random);
+            } else {
+                using Pass = PassAt<I>;
+                Pass& pass = std::get<I>(m_passes);
+                m_arena.prepare();
+                pass.Pass::run(m_population, context(generation_random, I));
+                run_passes<I + 1>(generation_random);
+            }
+        }
+    }
+
+    // the hooks of every pass, in registration order
+    template <size_t... I>
+    void complete_passes(const RandomSource& generation_random, std::index_sequence<I...>) {
+        (complete_pass<I>(generation_random), ...);
+    }
+
+    template <size_t I>
+    void complete_pass(const RandomSource& generation_random) {
+        using Pass = PassAt<I>;
+        m_arena.prepare();
+        std::get<I>(m_passes).Pass::complete(m_population, context(generation_random, I));
+    }
+
+    template <size_t... I>
+    void passes_evaluated(const RandomSource& generation_random, std::index_sequence<I...>) {
+        (pass_evaluated<I>(generation_random), ...);
+    }
+
+    template <size_t I>
+    void pass_evaluated(const RandomSource& generation_random) {
+        using Pass = PassAt<I>;
+        m_arena.prepare();
+        std::get<I>(m_passes).Pass::evaluated(m_population, context(generation_random, I));
+    }
+
+    bool needs_swarm_state() const {
+        return std::apply([](const auto&... passes) { return (passes.needs_swarm_state() || ...); }, m_passes);
+    }
+public:
+    StaticGeneticOptimizer(size_t population_size, size_t max_generations, uint64_t seed, Fitness fitness,
+        Transformer transformer, Passes... passes) :
+        m_population_size(population_size),
+        m_max_generations(max_generations),
+        m_seed(seed),
+        m_fitness(std::move(fitness)),
+        m_transformer(std::move(transformer)),
+        m_passes(std::move(passes)...) {}
+
+    // step-wise interface of GeneticOptimizer
+    void start() {
+        m_generation = 0;
+        m_evaluations = 0;
+        m_generations_random = RandomSource(m_seed).fork(1);
+        for (auto& state : m_pass_states)
+            state.clear();
+
+        const RandomSource initial_random = RandomSource(m_seed).fork(0);
+        constexpr GenomeLayout layout = Transform::layout();
+        m_population = Population(m_population_size, layout, needs_swarm_state());
+        #pragma omp parallel for
+        for (size_t i = 0; i < m_population.size(); ++i) {
+            RandomEngine engine = initial_random.stream(i);
+            for (auto& word : m_population.genome(i))
+                word = Genome(engine() & layout.mask()).getEncodedGenome();
+            m_population.assign(i, m_population.genome(i), 0);
+        }
+        evaluate_dirty();
+        m_ranking.rank(m_population, 1, 0);
+    }
+
+    void step() {
+        const RandomSource generation_random = m_generations_random.fork(m_generation);
+        run_passes<0>(generation_random);
+        complete_passes(generation_random, std::index_sequence_for<Passes...>{});
+        evaluate_dirty();
+        passes_evaluated(generation_random, std::index_sequence_for<Passes...>{});
+        m_ranking.rank(m_population, 1, 0);
+        m_generation++;
+    }
+
+    bool finished() const {
+        return m_generation > m_max_generations;
+    }
+
+    // returns the encoded words of the best individual, valid until the next call
+    std::span<const Genome::GenomeType> optimize() {
+        start();
+        while (!finished())
+            step();
+
+        const auto best_genome = m_population.genome(m_ranking.order().front());
+        m_best_genome.assign(best_genome.begin(), best_genome.end());
+        return m_best_genome;
+    }
+
+    size_t generation() const {
+        return m_generation;
+    }
+
+    // objective evaluations of the current run
+    size_t evaluations() const {
+        return m_evaluations;
+    }
+
+    double best_fit() const {
+        return m_population.fits()[m_ranking.order().front()];
+    }
+
+    const Population& population() const {
+        return m_population;
+    }
+
+    template <size_t I>
+    const PassAt<I>& pass() const {
+        return std::get<I>(m_passes);
+    }
+};
+
+} // namespace dl
+
+#endif // #define STATIC_OPTIMIZER_HEADER
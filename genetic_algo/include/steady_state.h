@@ -0,0 +1,214 @@
+#ifndef STEADY_STATE_HEADER
+#define STEADY_STATE_HEADER
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "genetic_optimizer.h"
+#include "scheduler.h"
+
+namespace dl
+{
+
+// Asynchronous steady-state engine for expensive objectives of varying cost. There is no
+// generation barrier: up to in_flight children are evaluated concurrently on a work-stealing
+// scheduler, and every finished evaluation immediately replaces the worst individual (if the
+// child is better) and breeds the next child with the per-individual forms of the selection,
+// crossover and mutation passes. Breeding and replacement are serialized by a lock, only the
+// objective runs in parallel. The order in which children finish depends on timing, so runs
+// are not reproducible from the seed alone
+class SteadyStateOptimizer : public OptimizerFrontend<SteadyStateOptimizer>
+{
+    using GenomeType = Genome::GenomeType;
+
+    size_t m_population_size;
+    size_t m_max_evaluations;
+    uint64_t m_seed;
+    size_t m_threads;
+    size_t m_in_flight;
+
+    std::unique_ptr<SelectionPass> m_selection;
+    std::unique_ptr<CrossoverPass> m_crossover;
+    std::unique_ptr<MutationPass> m_mutation;
+
+    EvaluationStatistics m_statistics;
+    size_t m_replacements = 0;
+    std::vector<GenomeType> m_best_genome;
+
+    // state of the run in progress, guarded by m_mutex
+    struct Run
+    {
+        const FitnessEvaluator* evaluator;
+        RandomSource births_random;
+        Population population;
+        // min-heap of (fit, index): the top is the individual replaced next
+        std::vector<std::pair<double, size_t>> worst;
+        size_t best_idx = 0;
+        size_t births = 0;
+        size_t replacements = 0;
+        // selection tables of roulette and rank selection
+        ScratchArena scratch = {};
+    };
+
+    std::mutex m_mutex;
+
+    static bool worse(const std::pair<double, size_t>& lhs, const std::pair<double, size_t>& rhs) {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    }
+
+    // child of birth number birth, called under the lock
+    std::vector<GenomeType> breed(Run& run, size_t birth) const {
+        const Population& population = run.population;
+        RandomEngine engine = run.births_random.stream(birth);
+        run.scratch.reset();
+
+        const size_t first_parent = m_selection->select(population, engine, run.scratch);
+        std::vector<GenomeType> child(population.genome(first_parent).begin(), population.genome(first_parent).end());
+        if (m_crossover) {
+            const size_t second_parent = m_selection->select(population, engine, run.scratch);
+            m_crossover->crossover(child, population.genome(second_parent), child, population.layout(), engine);
+        }
+        if (m_mutation)
+            m_mutation->mutate(child, population.layout().bits, engine);
+        return child;
+    }
+
+    // called under the lock
+    void replace(Run& run, std::span<const GenomeType> child, double fit) {
+        const auto [worst_fit, worst_idx] = run.worst.front();
+        if (!(fit > worst_fit))
+            return;
+
+        std::pop_heap(run.worst.begin(), run.worst.end(), worse);
+        run.population.assign(worst_idx, child, 0);
+        run.population.set_fit(worst_idx, fit);
+        run.worst.back() = {fit, worst_idx};
+        std::push_heap(run.worst.begin(), run.worst.end(), worse);
+        run.replacements++;
+
+        if (fit > run.population.fits()[run.best_idx])
+            run.best_idx = worst_idx;
+    }
+
+    void evaluate_child(WorkStealingScheduler& scheduler, Run& run, std::vector<GenomeType> child) {
+        // the only part running outside the lock
+        const double fit = run.evaluator->evaluate_genome(child);
+
+        std::vector<GenomeType> next_child;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            replace(run, child, fit);
+            if (run.births == m_max_evaluations - m_population_size)
+                return;
+            next_child = breed(run, run.births++);
+        }
+
+        scheduler.submit([this, &scheduler, &run, next_child = std::move(next_child)]() mutable {
+            evaluate_child(scheduler, run, std::move(next_child));
+        });
+    }
+public:
+    using OptimizerFrontend<SteadyStateOptimizer>::optimize;
+
+    // max_evaluations counts the initial population too; in_flight = 0 keeps two evaluations per thread
+    SteadyStateOptimizer(size_t population_size, size_t max_evaluations, uint64_t seed = random_seed(),
+        size_t threads = std::thread::hardware_concurrency(), size_t in_flight = 0) :
+        m_population_size(std::max<size_t>(population_size, 1)),
+        m_max_evaluations(std::max(max_evaluations, m_population_size)),
+        m_seed(seed),
+        m_threads(std::max<size_t>(threads, 1)),
+        m_in_flight(in_flight ? in_flight : 2 * m_threads),
+        m_selection(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION))
+    {}
+
+    uint64_t seed() const {
+        return m_seed;
+    }
+
+    // tournament selection by default; tournaments do not rebuild a table for every parent
+    void set_selection(std::unique_ptr<SelectionPass> selection) {
+        m_selection = std::move(selection);
+    }
+
+    // without crossover children are mutated clones of one parent
+    void set_crossover(std::unique_ptr<CrossoverPass> crossover) {
+        m_crossover = std::move(crossover);
+    }
+
+    void set_mutation(std::unique_ptr<MutationPass> mutation) {
+        m_mutation = std::move(mutation);
+    }
+
+    // evaluation counters of the last optimize call
+    const EvaluationStatistics& statistics() const {
+        return m_statistics;
+    }
+
+    // children of the last optimize call that were better than the worst individual
+    size_t replacements() const {
+        return m_replacements;
+    }
+
+    // returns the encoded words of the best individual, valid until the next call
+    std::span<const GenomeType> optimize(FitnessEvaluator evaluator)
+    {
+        if (!m_selection)
+            throw std::runtime_error("steady-state optimizer needs a selection pass");
+
+        const RandomSource random(m_seed);
+        const RandomSource initial_random = random.fork(0);
+        Run run{&evaluator, random.fork(1), Population(m_population_size, evaluator.layout()), {}};
+
+        // the initial population is evaluated in one batch, same as the generational optimizer
+        const GenomeLayout layout = evaluator.layout();
+        Population& population = run.population;
+        #pragma omp parallel for
+        for (size_t i = 0; i < population.size(); ++i) {
+            RandomEngine engine = initial_random.stream(i);
+            for (auto& word : population.genome(i))
+                word = Genome(engine() & layout.mask()).getEncodedGenome();
+            population.assign(i, population.genome(i), 0);
+        }
+        evaluator.evaluate(population);
+
+        const auto fits = population.fits();
+        for (size_t i = 0; i < population.size(); ++i) {
+            run.worst.emplace_back(fits[i], i);
+            if (fits[i] > fits[run.best_idx])
+                run.best_idx = i;
+        }
+        std::make_heap(run.worst.begin(), run.worst.end(), worse);
+
+        // the first children are bred before any worker runs, later ones as evaluations finish
+        std::vector<std::vector<GenomeType>> children;
+        for (; run.births < std::min(m_in_flight, m_max_evaluations - m_population_size); ++run.births)
+            children.push_back(breed(run, run.births));
+
+        {
+            WorkStealingScheduler scheduler(m_threads);
+            for (auto& child : children) {
+                scheduler.submit([this, &scheduler, &run, child = std::move(child)]() mutable {
+                    evaluate_child(scheduler, run, std::move(child));
+                });
+            }
+            scheduler.wait();
+        }
+
+        m_statistics = evaluator.statistics();
+        m_statistics.evaluations += run.births;
+        m_replacements = run.replacements;
+
+        const auto best_genome = population.genome(run.best_idx);
+        m_best_genome.assign(best_genome.begin(), best_genome.end());
+        return m_best_genome;
+    }
+};
+
+} // namespace dl
+
+#endif // #define STEADY_STATE_HEADER
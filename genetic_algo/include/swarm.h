@@ -0,0 +1,404 @@
+#ifndef SWARM_HEADER
+#define SWARM_HEADER
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <omp.h>
+
+#include "rng.h"
+#include "pass.h"
+#include "fitness.h"
+
+namespace dl
+{
+
+// Neighbourhood a particle is attracted to, besides its personal best
+enum class SwarmTopology
+{
+    // best of the whole swarm: fastest convergence, most prone to premature convergence
+    GLOBAL,
+    // best of the particles within radius positions on a ring of particle indices
+    RING,
+    // best of the particle and its four neighbours on a wrapped grid of particle indices
+    VON_NEUMANN,
+};
+
+struct SwarmParameters
+{
+    // constriction coefficients of Clerc and Kennedy
+    double inertia = 0.7298;
+    double cognitive = 1.49618;
+    double social = 1.49618;
+    // velocity limit per coordinate, as a share of the coordinate's range
+    double max_velocity = 0.2;
+    SwarmTopology topology = SwarmTopology::GLOBAL;
+    size_t ring_radius = 1;
+};
+
+// particles moved per block of the update kernels, the bounds are tiled over one block
+inline constexpr size_t swarm_block = 64;
+
+// Index of the highest fit, the lowest index among equal ones; a parallel reduction
+inline size_t best_particle(std::span<const double> fits) {
+    size_t best = 0;
+    #pragma omp parallel
+    {
+        size_t local = fits.size();
+        #pragma omp for nowait
+        for (size_t i = 0; i < fits.size(); ++i) {
+            if (local == fits.size() || fits[i] > fits[local])
+                local = i;
+        }
+        #pragma omp critical
+        {
+            if (local < fits.size() && (fits[local] > fits[best] || (fits[local] == fits[best] && local < best)))
+                best = local;
+        }
+    }
+    return best;
+}
+
+// guides[i] = particle whose personal best attracts particle i
+inline void swarm_guides(std::span<const double> best_fits, SwarmTopology topology, size_t ring_radius, std::span<size_t> guides) {
+    const size_t particles = best_fits.size();
+    if (particles == 0)
+        return;
+
+    const auto better = [best_fits](size_t lhs, size_t rhs) {
+        return best_fits[lhs] > best_fits[rhs] || (best_fits[lhs] == best_fits[rhs] && lhs < rhs);
+    };
+
+    switch (topology) {
+        case SwarmTopology::GLOBAL: {
+            const size_t best = best_particle(best_fits);
+            std::fill(guides.begin(), guides.begin() + particles, best);
+            break;
+        }
+        case SwarmTopology::RING: {
+            const size_t radius = std::min(ring_radius, (particles - 1) / 2);
+            #pragma omp parallel for
+            for (size_t i = 0; i < particles; ++i) {
+                size_t guide = i;
+                for (size_t offset = 1; offset <= radius; ++offset) {
+                    const size_t left = (i + particles - offset) % particles, right = (i + offset) % particles;
+                    guide = better(left, guide) ? left : guide;
+                    guide = better(right, guide) ? right : guide;
+                }
+                guides[i] = guide;
+            }
+            break;
+        }
+        case SwarmTopology::VON_NEUMANN: {
+            const size_t width = std::max<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(particles))), 1);
+            #pragma omp parallel for
+            for (size_t i = 0; i < particles; ++i) {
+                const size_t neighbours[] = {(i + 1) % particles, (i + particles - 1) % particles,
+                    (i + width) % particles, (i + particles - width % particles) % particles};
+                size_t guide = i;
+                for (const size_t neighbour : neighbours)
+                    guide = better(neighbour, guide) ? neighbour : guide;
+                guides[i] = guide;
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("unknown swarm topology");
+    }
+}
+
+// Velocity and position update of the coordinates [begin, end) of row-major swarm arrays, where
+// social holds the personal best of every coordinate's guide. lower, upper and max_velocity
+// are tiled per coordinate over one block of particles and indexed relative to begin, so a
+// call covers at most one block. Random factors are drawn per coordinate from counters, the
+// result is independent of how the coordinates are split between threads. Particles leaving the
+// box stop at its boundary
+inline void swarm_move(std::span<double> positions, std::span<double> velocities, std::span<const double> personal_best,
+    std::span<const double> social, const double* lower, const double* upper, const double* max_velocity,
+    size_t begin, size_t end, const SwarmParameters& parameters, uint64_t cognitive_key, uint64_t social_key) {
+    double* x = positions.data();
+    double* v = velocities.data();
+    const double* p = personal_best.data();
+    const double* g = social.data();
+    const double w = parameters.inertia, c1 = parameters.cognitive, c2 = parameters.social;
+
+    #pragma omp simd
+    for (size_t k = begin; k < end; ++k) {
+        const size_t j = k - begin;
+        const double r1 = uniform_at(cognitive_key, k + 1), r2 = uniform_at(social_key, k + 1);
+        const double velocity = std::clamp(w * v[k] + c1 * r1 * (p[k] - x[k]) + c2 * r2 * (g[k] - x[k]), -max_velocity[j], max_velocity[j]);
+        const double moved = x[k] + velocity;
+        const double bounded = std::clamp(moved, lower[j], upper[j]);
+        v[k] = bounded == moved ? velocity : 0.0;
+        x[k] = bounded;
+    }
+}
+
+// Continuous-space particle swarm optimizer. Positions, velocities and personal bests are kept
+// in separate arrays, row-major with one row of dimension coordinates per particle like the
+// input of a BatchFitnessFunction, so the objective reads the positions in place. Maximizes the
+// objective, like the genetic optimizers. The same seed gives the same run for any number of
+// threads
+class SwarmOptimizer
+{
+    size_t m_particles;
+    size_t m_max_iterations;
+    SwarmParameters m_parameters;
+    uint64_t m_seed;
+
+    BatchFitnessFunction m_objective;
+    size_t m_dimensions = 0;
+    // per coordinate bounds and velocity limit, tiled over one block of particles
+    std::vector<double> m_lower;
+    std::vector<double> m_upper;
+    std::vector<double> m_max_velocity;
+
+    std::vector<double> m_positions;
+    std::vector<double> m_velocities;
+    std::vector<double> m_best_positions;
+    // personal best of every coordinate's guide, gathered once per iteration
+    std::vector<double> m_social;
+    std::vector<double> m_fits;
+    std::vector<double> m_best_fits;
+    std::vector<size_t> m_guides;
+
+    RandomSource m_random;
+    size_t m_iteration = 0;
+    size_t m_best = 0;
+    size_t m_evaluations = 0;
+
+    // chunks of particles are evaluated in parallel, like FitnessEvaluator does for genomes
+    void evaluate() {
+        constexpr size_t chunk = 256;
+        const size_t chunks = (m_particles + chunk - 1) / chunk;
+        #pragma omp parallel for
+        for (size_t c = 0; c < chunks; ++c) {
+            const size_t begin = c * chunk, end = std::min(begin + chunk, m_particles);
+            m_objective(std::span<const double>(m_positions).subspan(begin * m_dimensions, (end - begin) * m_dimensions),
+                std::span<double>(m_fits).subspan(begin, end - begin));
+        }
+        m_evaluations += m_particles;
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < m_particles; ++i) {
+            if (m_fits[i] > m_best_fits[i]) {
+                m_best_fits[i] = m_fits[i];
+                std::copy_n(m_positions.begin() + i * m_dimensions, m_dimensions, m_best_positions.begin() + i * m_dimensions);
+            }
+        }
+        m_best = best_particle(m_best_fits);
+    }
+public:
+    SwarmOptimizer(size_t particles, size_t max_iterations, SwarmParameters parameters = {}, uint64_t seed = random_seed()) :
+        m_particles(std::max<size_t>(particles, 1)),
+        m_max_iterations(max_iterations),
+        m_parameters(parameters),
+        m_seed(seed) {}
+
+    // Step-wise interface like GeneticOptimizer's: start() scatters the particles uniformly
+    // over the box [lower, upper] and evaluates them, every step() moves and evaluates the swarm
+    void start(BatchFitnessFunction objective, std::span<const double> lower, std::span<const double> upper) {
+        if (lower.size() != upper.size() || lower.empty())
+            throw std::runtime_error("swarm bounds need one lower and upper value per dimension");
+
+        m_objective = std::move(objective);
+        m_dimensions = lower.size();
+        m_random = RandomSource(m_seed);
+        m_iteration = 0;
+        m_evaluations = 0;
+
+        const size_t tile = swarm_block * m_dimensions;
+        m_lower.resize(tile);
+        m_upper.resize(tile);
+        m_max_velocity.resize(tile);
+        for (size_t j = 0; j < tile; ++j) {
+            m_lower[j] = lower[j % m_dimensions];
+            m_upper[j] = upper[j % m_dimensions];
+            m_max_velocity[j] = m_parameters.max_velocity * (m_upper[j] - m_lower[j]);
+        }
+
+        const size_t coordinates = m_particles * m_dimensions;
+        m_positions.resize(coordinates);
+        m_velocities.assign(coordinates, 0.0);
+        m_best_positions.resize(coordinates);
+        m_social.resize(coordinates);
+        m_fits.resize(m_particles);
+        m_best_fits.assign(m_particles, -std::numeric_limits<double>::infinity());
+        m_guides.resize(m_particles);
+
+        const uint64_t key = m_random.fork(0).key();
+        #pragma omp parallel for
+        for (size_t k = 0; k < coordinates; ++k) {
+            const size_t d = k % m_dimensions;
+            m_positions[k] = lower[d] + uniform_at(key, k + 1) * (upper[d] - lower[d]);
+        }
+        evaluate();
+    }
+
+    void step() {
+        swarm_guides(m_best_fits, m_parameters.topology, m_parameters.ring_radius, m_guides);
+        #pragma omp parallel for
+        for (size_t i = 0; i < m_particles; ++i)
+            std::copy_n(m_best_positions.begin() + m_guides[i] * m_dimensions, m_dimensions, m_social.begin() + i * m_dimensions);
+
+        const RandomSource iteration_random = m_random.fork(m_iteration + 1);
+        const uint64_t cognitive_key = iteration_random.fork(0).key(), social_key = iteration_random.fork(1).key();
+        const size_t blocks = (m_particles + swarm_block - 1) / swarm_block;
+        #pragma omp parallel for
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t begin = b * swarm_block * m_dimensions;
+            const size_t end = std::min((b + 1) * swarm_block, m_particles) * m_dimensions;
+            swarm_move(m_positions, m_velocities, m_best_positions, m_social, m_lower.data(), m_upper.data(),
+                m_max_velocity.data(), begin, end, m_parameters, cognitive_key, social_key);
+        }
+
+        evaluate();
+        m_iteration++;
+    }
+
+    bool finished() const {
+        return m_iteration >= m_max_iterations;
+    }
+
+    // returns the best position found
+    std::span<const double> optimize(BatchFitnessFunction objective, std::span<const double> lower, std::span<const double> upper) {
+        start(std::move(objective), lower, upper);
+        while (!finished())
+            step();
+        return best_position();
+    }
+
+    std::span<const double> optimize(MultiFitnessFunction objective, std::span<const double> lower, std::span<const double> upper) {
+        const size_t dimensions = lower.size();
+        return optimize([objective = std::move(objective), dimensions](std::span<const double> x, std::span<double> fits) {
+            for (size_t i = 0; i < fits.size(); ++i)
+                fits[i] = objective(x.subspan(i * dimensions, dimensions));
+        }, lower, upper);
+    }
+
+    // searches the box of a genetic optimizer's transformer
+    template <size_t Variables, size_t Bits>
+    std::span<const double> optimize(BatchFitnessFunction objective, const BoxTransformer<Variables, Bits>& transformer) {
+        return optimize(std::move(objective), transformer.start, transformer.end);
+    }
+
+    size_t iteration() const {
+        return m_iteration;
+    }
+
+    size_t dimensions() const {
+        return m_dimensions;
+    }
+
+    // objective evaluations of the current run
+    size_t evaluations() const {
+        return m_evaluations;
+    }
+
+    double best_fit() const {
+        return m_best_fits[m_best];
+    }
+
+    std::span<const double> best_position() const {
+        return std::span<const double>(m_best_positions).subspan(m_best * m_dimensions, m_dimensions);
+    }
+
+    // row-major, dimensions() coordinates per particle
+    std::span<const double> positions() const { return m_positions; }
+    std::span<const double> velocities() const { return m_velocities; }
+    std::span<const double> fits() const { return m_fits; }
+    std::span<const double> best_fits() const { return m_best_fits; }
+};
+
+// The swarm update as a pass of a GeneticOptimizer pipeline. Every variable of a genome is
+// decoded to a coordinate in [0, 1]; the population's swarm state holds the velocities in those
+// units and the personal bests. Moved coordinates are rounded back onto the bit grid and
+// Gray-encoded, individuals that moved are marked dirty. Replaces ParticleSwarmOptimizationPass,
+// which moves the raw integers; the two must not share a pipeline
+class SwarmPass : public PopulationPass {
+    SwarmParameters m_parameters;
+public:
+    explicit SwarmPass(SwarmParameters parameters = {}) :
+        m_parameters(parameters) {}
+
+    bool needs_swarm_state() const override {
+        return true;
+    }
+
+    const char* name() const override {
+        return "swarm";
+    }
+
+    std::vector<double> configuration() const override {
+        return {m_parameters.inertia, m_parameters.cognitive, m_parameters.social, m_parameters.max_velocity,
+            static_cast<double>(m_parameters.topology), static_cast<double>(m_parameters.ring_radius)};
+    }
+
+    void run(Population& population, const PassContext& context) const override {
+        population.enable_swarm_state();
+        const size_t size = population.size();
+        if (size == 0)
+            return;
+
+        std::optional<GenerationArena> local_arena;
+        GenerationArena& arena = context.arena ? *context.arena : local_arena.emplace();
+        ScratchArena& scratch = arena.scratch();
+
+        const size_t dimensions = population.words();
+        const size_t coordinates = size * dimensions;
+        const GenomeLayout& layout = population.layout();
+        const auto genomes = population.genomes();
+        const auto best_genomes = population.best_genomes();
+
+        const auto positions = scratch.allocate<double>(coordinates);
+        const auto personal_best = scratch.allocate<double>(coordinates);
+        const auto social = scratch.allocate<double>(coordinates);
+        const auto guides = scratch.allocate<size_t>(size);
+        const auto lower = scratch.allocate<double>(swarm_block * dimensions);
+        const auto upper = scratch.allocate<double>(swarm_block * dimensions);
+        const auto max_velocity = scratch.allocate<double>(swarm_block * dimensions);
+        std::fill(lower.begin(), lower.end(), 0.0);
+        std::fill(upper.begin(), upper.end(), 1.0);
+        std::fill(max_velocity.begin(), max_velocity.end(), m_parameters.max_velocity);
+
+        #pragma omp parallel for
+        for (size_t k = 0; k < coordinates; ++k) {
+            positions[k] = layout.to_unit(genomes[k]);
+            personal_best[k] = layout.to_unit(best_genomes[k]);
+        }
+
+        swarm_guides(population.best_fits(), m_parameters.topology, m_parameters.ring_radius, guides);
+        #pragma omp parallel for
+        for (size_t i = 0; i < size; ++i)
+            std::copy_n(personal_best.begin() + guides[i] * dimensions, dimensions, social.begin() + i * dimensions);
+
+        const uint64_t cognitive_key = context.random.fork(0).key(), social_key = context.random.fork(1).key();
+        const auto velocities = population.velocities();
+        const size_t blocks = (size + swarm_block - 1) / swarm_block;
+        #pragma omp parallel for
+        for (size_t b = 0; b < blocks; ++b) {
+            const size_t begin_particle = b * swarm_block, end_particle = std::min(begin_particle + swarm_block, size);
+            swarm_move(positions, velocities, personal_best, social, lower.data(), upper.data(), max_velocity.data(),
+                begin_particle * dimensions, end_particle * dimensions, m_parameters, cognitive_key, social_key);
+
+            for (size_t i = begin_particle; i < end_particle; ++i) {
+                bool changed = false;
+                for (size_t k = i * dimensions; k < (i + 1) * dimensions; ++k) {
+                    const Genome::GenomeType moved = layout.from_unit(positions[k]);
+                    changed |= moved != genomes[k];
+                    genomes[k] = moved;
+                }
+                if (changed)
+                    population.mark_dirty(i);
+            }
+        }
+    }
+};
+
+} // namespace dl
+
+#endif // #define SWARM_HEADER
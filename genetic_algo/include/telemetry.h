@@ -0,0 +1,300 @@
+#ifndef TELEMETRY_HEADER
+#define TELEMETRY_HEADER
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "population.h"
+
+namespace dl
+{
+
+// Global heap allocation counter. Counting is compiled in by defining DL_COUNT_ALLOCATIONS in
+// exactly one translation unit of the program, before it includes any header of this library;
+// that unit then replaces the global operator new and delete. Otherwise allocations() stays 0
+inline std::atomic<uint64_t> allocation_count{0};
+// true if the counting operator new is compiled in
+inline bool allocation_counting = false;
+
+inline uint64_t allocations() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+// best, mean and bitwise diversity of the current fits and genomes
+struct PopulationSummary
+{
+    double best = 0;
+    double mean = 0;
+    // mean over all genome bits of 4 p (1 - p), p being the share of individuals with the bit
+    // set: 0 once every individual carries the same genome, about 1 for a random population
+    double diversity = 0;
+};
+
+inline PopulationSummary summarize(const Population& population) {
+    PopulationSummary summary;
+    const size_t size = population.size();
+    if (size == 0)
+        return summary;
+
+    const auto fits = population.fits();
+    summary.best = *std::max_element(fits.begin(), fits.end());
+    double sum = 0;
+    for (const double fit : fits)
+        sum += fit;
+    summary.mean = sum / size;
+
+    // per bit set counts, summed per word position
+    const GenomeLayout& layout = population.layout();
+    const size_t words = layout.words();
+    std::vector<uint64_t> counts(words * layout.bits, 0);
+    uint64_t* counts_data = counts.data();
+    #pragma omp parallel for reduction(+:counts_data[:words * layout.bits])
+    for (size_t i = 0; i < size; ++i) {
+        const auto genome = population.genome(i);
+        for (size_t word = 0; word < words; ++word) {
+            for (uint64_t bits = genome[word] & layout.mask(); bits; bits &= bits - 1)
+                counts_data[word * layout.bits + std::countr_zero(bits)]++;
+        }
+    }
+
+    double diversity = 0;
+    for (const uint64_t count : counts) {
+        const double p = static_cast<double>(count) / size;
+        diversity += 4.0 * p * (1.0 - p);
+    }
+    summary.diversity = diversity / counts.size();
+    return summary;
+}
+
+struct TelemetryEvent
+{
+    enum Kind : uint8_t {
+        PASS,
+        EVALUATION,
+        GENERATION,
+    };
+
+    Kind kind;
+    // index of the recording thread within its Telemetry
+    uint32_t thread;
+    // static string, e.g. the name of the pass
+    const char* name;
+    uint64_t generation;
+    // nanoseconds since the Telemetry was created
+    uint64_t start;
+    uint64_t duration;
+    uint64_t evaluations;
+    uint64_t allocations;
+    // population summary, GENERATION events only
+    double best;
+    double mean;
+    double diversity;
+};
+
+// Collects TelemetryEvents of an optimizer. Disabled by default: instrumented code then costs a
+// single relaxed load per pass. Every recording thread writes into its own fixed-size ring
+// without locks, keeping the latest events once full. Export after the run, events being
+// recorded concurrently with an export may be skipped or torn
+class Telemetry
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Ring
+    {
+        std::unique_ptr<TelemetryEvent[]> events;
+        std::atomic<uint64_t> written{0};
+    };
+
+    static constexpr size_t max_threads = 256;
+
+    inline static std::atomic<uint64_t> s_next_id{0};
+
+    uint64_t m_id = s_next_id++;
+    size_t m_capacity;
+    std::atomic<bool> m_enabled{false};
+    Clock::time_point m_origin = Clock::now();
+
+    std::unique_ptr<std::atomic<Ring*>[]> m_rings;
+    // owns the rings published in m_rings, slot by slot
+    std::unique_ptr<std::unique_ptr<Ring>[]> m_owned;
+    std::atomic<size_t> m_threads{0};
+
+    // ring of the calling thread, claimed on its first event
+    Ring* thread_ring(uint32_t& thread) {
+        struct Entry { uint64_t owner; Ring* ring; uint32_t thread; };
+        thread_local std::vector<Entry> t_rings;
+        for (const Entry& entry : t_rings) {
+            if (entry.owner == m_id) {
+                thread = entry.thread;
+                return entry.ring;
+            }
+        }
+
+        const size_t slot = m_threads++;
+        if (slot >= max_threads)
+            return nullptr;
+
+        m_owned[slot] = std::make_unique<Ring>();
+        m_owned[slot]->events.reset(new TelemetryEvent[m_capacity]);
+        Ring* raw = m_owned[slot].get();
+        m_rings[slot].store(raw, std::memory_order_release);
+
+        thread = static_cast<uint32_t>(slot);
+        t_rings.push_back(Entry{m_id, raw, thread});
+        return raw;
+    }
+public:
+    // capacity: events kept per thread, rounded up to a power of two
+    explicit Telemetry(size_t capacity = 1 << 14) :
+        m_capacity(std::bit_ceil(std::max<size_t>(capacity, 1))),
+        m_rings(new std::atomic<Ring*>[max_threads]),
+        m_owned(new std::unique_ptr<Ring>[max_threads]) {
+        for (size_t i = 0; i < max_threads; ++i)
+            m_rings[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    bool enabled() const {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void set_enabled(bool enabled) {
+        m_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_origin).count();
+    }
+
+    void record(TelemetryEvent event) {
+        Ring* ring = thread_ring(event.thread);
+        if (!ring)
+            return;
+        const uint64_t written = ring->written.load(std::memory_order_relaxed);
+        ring->events[written & (m_capacity - 1)] = event;
+        ring->written.store(written + 1, std::memory_order_release);
+    }
+
+    // drops the recorded events, the rings stay claimed
+    void clear() {
+        for (size_t i = 0; i < std::min(m_threads.load(), max_threads); ++i) {
+            if (Ring* ring = m_rings[i].load(std::memory_order_acquire))
+                ring->written.store(0, std::memory_order_release);
+        }
+    }
+
+    // events kept by all threads, ordered by start time
+    std::vector<TelemetryEvent> events() const {
+        std::vector<TelemetryEvent> events;
+        for (size_t i = 0; i < std::min(m_threads.load(), max_threads); ++i) {
+            const Ring* ring = m_rings[i].load(std::memory_order_acquire);
+            if (!ring)
+                continue;
+            const uint64_t written = ring->written.load(std::memory_order_acquire);
+            for (uint64_t k = written - std::min<uint64_t>(written, m_capacity); k < written; ++k)
+                events.push_back(ring->events[k & (m_capacity - 1)]);
+        }
+        std::stable_sort(events.begin(), events.end(), [](const TelemetryEvent& lhs, const TelemetryEvent& rhs) {
+            return lhs.start < rhs.start;
+        });
+        return events;
+    }
+
+    void write_json(std::ostream& out) const {
+        static const char* kinds[] = {"pass", "evaluation", "generation"};
+        out << std::setprecision(10) << "{\"events\":[";
+        const auto all_events = events();
+        for (size_t i = 0; i < all_events.size(); ++i) {
+            const TelemetryEvent& event = all_events[i];
+            out << (i ? ",\n" : "\n") << "{\"kind\":\"" << kinds[event.kind] << "\",\"name\":\"" << event.name
+                << "\",\"thread\":" << event.thread << ",\"generation\":" << event.generation
+                << ",\"start_ns\":" << event.start << ",\"duration_ns\":" << event.duration
+                << ",\"evaluations\":" << event.evaluations << ",\"allocations\":" << event.allocations;
+            if (event.kind == TelemetryEvent::GENERATION)
+                out << ",\"best\":" << event.best << ",\"mean\":" << event.mean << ",\"diversity\":" << event.diversity;
+            out << "}";
+        }
+        out << "\n]}\n";
+    }
+
+    // Chrome trace-event format (chrome://tracing, Perfetto): one complete event per record and
+    // counter tracks for the population summary
+    void write_chrome_trace(std::ostream& out) const {
+        out << std::setprecision(10) << "{\"traceEvents\":[";
+        bool first = true;
+        for (const TelemetryEvent& event : events()) {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0
+                << ",\"args\":{\"generation\":" << event.generation << ",\"evaluations\":" << event.evaluations
+                << ",\"allocations\":" << event.allocations << "}}";
+            if (event.kind == TelemetryEvent::GENERATION) {
+                out << ",\n{\"name\":\"population\",\"ph\":\"C\",\"pid\":0,\"tid\":" << event.thread
+                    << ",\"ts\":" << (event.start + event.duration) / 1000.0 << ",\"args\":{\"best\":" << event.best
+                    << ",\"mean\":" << event.mean << ",\"diversity\":" << event.diversity << "}}";
+            }
+            first = false;
+        }
+        out << "\n]}\n";
+    }
+};
+
+} // namespace dl
+
+#ifdef DL_COUNT_ALLOCATIONS
+
+namespace dl {
+inline const bool allocation_counting_installed = (allocation_counting = true);
+}
+
+// the replacements pair malloc with free, which GCC cannot see through once they are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(std::size_t size) {
+    dl::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    dl::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* memory = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#pragma GCC diagnostic pop
+
+#endif // #ifdef DL_COUNT_ALLOCATIONS
+
+#endif // #define TELEMETRY_HEADER
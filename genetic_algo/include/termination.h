@@ -0,0 +1,249 @@
+#ifndef TERMINATION_HEADER
+#define TERMINATION_HEADER
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <limits>
+
+#include "population.h"
+#include "telemetry.h"
+
+namespace dl
+{
+
+// State of a run handed to the stop conditions after every generation
+struct OptimizationProgress
+{
+    // generations completed so far
+    size_t generation;
+    size_t evaluations;
+    double best_fit;
+    std::chrono::steady_clock::duration elapsed;
+    const Population& population;
+};
+
+class StopCondition
+{
+public:
+    virtual bool should_stop(const OptimizationProgress& progress) = 0;
+
+    // called when a run starts, conditions with state forget the previous run
+    virtual void reset() {}
+
+    // static string reported as the stop reason
+    virtual const char* name() const = 0;
+
+    virtual ~StopCondition() {}
+};
+
+// stops once the best fit reaches target
+class FitnessTarget : public StopCondition
+{
+    double m_target;
+public:
+    explicit FitnessTarget(double target) :
+        m_target(target) {}
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        return progress.best_fit >= m_target;
+    }
+
+    const char* name() const override {
+        return "fitness_target";
+    }
+};
+
+// stops when the best fit did not improve by more than tolerance for window generations
+class Stagnation : public StopCondition
+{
+    size_t m_window;
+    double m_tolerance;
+    double m_best_fit = -std::numeric_limits<double>::infinity();
+    size_t m_improved_at = 0;
+public:
+    explicit Stagnation(size_t window, double tolerance = 0.0) :
+        m_window(window),
+        m_tolerance(tolerance) {}
+
+    void reset() override {
+        m_best_fit = -std::numeric_limits<double>::infinity();
+        m_improved_at = 0;
+    }
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        if (progress.best_fit > m_best_fit + m_tolerance) {
+            m_best_fit = progress.best_fit;
+            m_improved_at = progress.generation;
+        }
+        return progress.generation - m_improved_at >= m_window;
+    }
+
+    const char* name() const override {
+        return "stagnation";
+    }
+};
+
+// stops when the bitwise diversity of the population (see summarize) drops below threshold;
+// the O(population bits) summary is only computed every check_interval generations
+class DiversityCollapse : public StopCondition
+{
+    double m_threshold;
+    size_t m_check_interval;
+public:
+    explicit DiversityCollapse(double threshold, size_t check_interval = 1) :
+        m_threshold(threshold),
+        m_check_interval(std::max<size_t>(check_interval, 1)) {}
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        if (progress.generation % m_check_interval != 0)
+            return false;
+        return summarize(progress.population).diversity < m_threshold;
+    }
+
+    const char* name() const override {
+        return "diversity_collapse";
+    }
+};
+
+// stops once the run took longer than budget; checked between generations, so a run may
+// overshoot by up to one generation
+class TimeBudget : public StopCondition
+{
+    std::chrono::steady_clock::duration m_budget;
+public:
+    explicit TimeBudget(std::chrono::steady_clock::duration budget) :
+        m_budget(budget) {}
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        return progress.elapsed >= m_budget;
+    }
+
+    const char* name() const override {
+        return "time_budget";
+    }
+};
+
+// stops once at least budget objective evaluations were performed
+class EvaluationBudget : public StopCondition
+{
+    size_t m_budget;
+public:
+    explicit EvaluationBudget(size_t budget) :
+        m_budget(budget) {}
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        return progress.evaluations >= m_budget;
+    }
+
+    const char* name() const override {
+        return "evaluation_budget";
+    }
+};
+
+// Flag shared between a run and whoever wants to cancel it from another thread
+class CancellationToken
+{
+    std::shared_ptr<std::atomic<bool>> m_cancelled = std::make_shared<std::atomic<bool>>(false);
+public:
+    void cancel() {
+        m_cancelled->store(true, std::memory_order_relaxed);
+    }
+
+    bool cancelled() const {
+        return m_cancelled->load(std::memory_order_relaxed);
+    }
+};
+
+// stops after the token was cancelled
+class Cancellation : public StopCondition
+{
+    CancellationToken m_token;
+public:
+    explicit Cancellation(CancellationToken token) :
+        m_token(std::move(token)) {}
+
+    bool should_stop(const OptimizationProgress&) override {
+        return m_token.cancelled();
+    }
+
+    const char* name() const override {
+        return "cancelled";
+    }
+};
+
+// stops when every one of its conditions would stop, e.g. a stagnating run past a time budget
+class AllOf : public StopCondition
+{
+    std::vector<std::unique_ptr<StopCondition>> m_conditions;
+public:
+    explicit AllOf(std::vector<std::unique_ptr<StopCondition>> conditions) :
+        m_conditions(std::move(conditions)) {}
+
+    void reset() override {
+        for (auto& condition : m_conditions)
+            condition->reset();
+    }
+
+    bool should_stop(const OptimizationProgress& progress) override {
+        // every condition sees every generation, stateful ones must not miss any
+        bool stop = !m_conditions.empty();
+        for (auto& condition : m_conditions)
+            stop &= condition->should_stop(progress);
+        return stop;
+    }
+
+    const char* name() const override {
+        return "all_of";
+    }
+};
+
+// Best individual seen so far by a run in progress, offered after every generation and readable
+// from any thread while the run goes on. Without elitism the best of a generation may be worse
+// than an earlier one, so publish only keeps improvements
+class AnytimeBest
+{
+    mutable std::mutex m_mutex;
+    std::vector<Genome::GenomeType> m_genome;
+    double m_fit = 0;
+    size_t m_generation = 0;
+    bool m_valid = false;
+public:
+    struct Snapshot
+    {
+        // encoded words of the best individual, empty before the initial population is evaluated
+        std::vector<Genome::GenomeType> genome;
+        double fit = 0;
+        // generations completed when it was found
+        size_t generation = 0;
+    };
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_genome.clear();
+        m_valid = false;
+    }
+
+    void publish(std::span<const Genome::GenomeType> genome, double fit, size_t generation) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_valid && fit <= m_fit)
+            return;
+        m_genome.assign(genome.begin(), genome.end());
+        m_fit = fit;
+        m_generation = generation;
+        m_valid = true;
+    }
+
+    Snapshot snapshot() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_valid)
+            return Snapshot{};
+        return Snapshot{m_genome, m_fit, m_generation};
+    }
+};
+
+} // namespace dl
+
+#endif // #define TERMINATION_HEADER
@@ -1,8 +1,23 @@
+// counts heap allocations for the telemetry, must precede the library headers
+#define DL_COUNT_ALLOCATIONS
 #include "genetic_optimizer.h"
+#include "differential_evolution.h"
+#include "batch.h"
+#include "expression.h"
+#include "local_search.h"
+#include "island_optimizer.h"
+#include "process_islands.h"
+#include "steady_state.h"
 
 #include <omp.h>
 #include <chrono>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <mutex>
 #include <boost/program_options.hpp>
+#include <boost/lexical_cast.hpp>
 
 namespace po = boost::program_options;
 using namespace dl;
@@ -11,16 +26,334 @@ double target_function(double x) {
     return x * x * sin(x * x) + 1 / (x + 0.001);
 }
 
+// Minimized function of x: target_function, or an expression given on the command line
+struct Objective
+{
+    std::optional<Expression> expression;
+
+    explicit Objective(const std::string& text) {
+        if (!text.empty())
+            expression.emplace(text);
+    }
+
+    double operator()(double x) const {
+        return expression ? expression->evaluate(std::span<const double>(&x, 1)) : target_function(x);
+    }
+
+    void operator()(std::span<const double> xs, std::span<double> ys) const {
+        if (expression) {
+            (*expression)(xs, ys);
+            return;
+        }
+        for (size_t i = 0; i < xs.size(); ++i)
+            ys[i] = target_function(xs[i]);
+    }
+};
+
+// the built-in target keeps its squashed fit, an expression is minimized as it is
+BatchFitnessFunction make_fitness_function(const Objective& objective) {
+    if (objective.expression) {
+        return [objective](std::span<const double> xs, std::span<double> fits) {
+            objective(xs, fits);
+            for (double& fit : fits)
+                fit = -fit;
+        };
+    }
+    return [](std::span<const double> xs, std::span<double> fits) {
+        for (size_t i = 0; i < xs.size(); ++i) {
+            double y = target_function(xs[i]);
+            fits[i] = -y / (1 + exp(y));
+        }
+    };
+}
+
+// Parameters of one optimization. Options without a default stay empty until the command line
+// or a batch job line sets them
+struct JobSpec
+{
+    std::string id;
+    std::optional<size_t> population_size;
+    std::optional<size_t> max_generations;
+    std::optional<double> mutation_probability;
+    std::optional<double> c1;
+    std::optional<double> c2;
+    std::optional<double> start;
+    std::optional<double> end;
+    std::optional<uint64_t> seed;
+    size_t elites = 0;
+    // evaluations per generation of the local search, 0 disables it
+    size_t local_search = 0;
+    std::string crossover = "one_point";
+    std::string algorithm = "ga";
+    // expression of x, empty for target_function
+    std::string objective;
+};
+
+template <typename T>
+void set_option(std::optional<T>& option, const po::variables_map& vm, const char* name) {
+    if (vm.count(name))
+        option = vm[name].as<T>();
+}
+
+JobSpec job_from_arguments(const po::variables_map& vm) {
+    JobSpec job;
+    set_option(job.population_size, vm, "population_size");
+    set_option(job.max_generations, vm, "max_generations");
+    set_option(job.mutation_probability, vm, "mutation_probability");
+    set_option(job.c1, vm, "c1");
+    set_option(job.c2, vm, "c2");
+    set_option(job.start, vm, "start");
+    set_option(job.end, vm, "end");
+    set_option(job.seed, vm, "seed");
+    job.elites = vm["elites"].as<size_t>();
+    job.local_search = vm["local_search"].as<size_t>();
+    job.crossover = vm["crossover"].as<std::string>();
+    job.algorithm = vm["algorithm"].as<std::string>();
+    if (vm.count("objective"))
+        job.objective = vm["objective"].as<std::string>();
+    return job;
+}
+
+// overrides the job with the whitespace separated key=value pairs of a batch line
+void parse_job_line(JobSpec& job, const std::string& line) {
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+        const size_t separator = token.find('=');
+        if (separator == std::string::npos)
+            throw std::runtime_error("expected key=value, got " + token);
+        const std::string key = token.substr(0, separator);
+        const std::string value = token.substr(separator + 1);
+        try {
+            if (key == "id")
+                job.id = value;
+            else if (key == "population_size")
+                job.population_size = boost::lexical_cast<size_t>(value);
+            else if (key == "max_generations")
+                job.max_generations = boost::lexical_cast<size_t>(value);
+            else if (key == "mutation_probability")
+                job.mutation_probability = boost::lexical_cast<double>(value);
+            else if (key == "c1")
+                job.c1 = boost::lexical_cast<double>(value);
+            else if (key == "c2")
+                job.c2 = boost::lexical_cast<double>(value);
+            else if (key == "start")
+                job.start = boost::lexical_cast<double>(value);
+            else if (key == "end")
+                job.end = boost::lexical_cast<double>(value);
+            else if (key == "seed")
+                job.seed = boost::lexical_cast<uint64_t>(value);
+            else if (key == "elites")
+                job.elites = boost::lexical_cast<size_t>(value);
+            else if (key == "local_search")
+                job.local_search = boost::lexical_cast<size_t>(value);
+            else if (key == "crossover")
+                job.crossover = value;
+            else if (key == "algorithm")
+                job.algorithm = value;
+            else if (key == "objective")
+                job.objective = value;
+            else
+                throw std::runtime_error("unknown key " + key);
+        }
+        catch (const boost::bad_lexical_cast&) {
+            throw std::runtime_error("invalid value of " + key + ": " + value);
+        }
+    }
+}
+
+template <typename T>
+T required(const std::optional<T>& option, const char* name) {
+    if (!option)
+        throw std::runtime_error(std::string("the option '--") + name + "' is required but missing");
+    return *option;
+}
+
+CrossoverPass::CrossoverStrategy parse_crossover(const std::string& crossover_name) {
+    const CrossoverPass::CrossoverStrategy crossover = crossover_name == "one_point" ? CrossoverPass::ONE_POINT_CROSSOVER :
+        crossover_name == "two_point" ? CrossoverPass::TWO_POINT_CROSSOVER : crossover_name == "uniform" ? CrossoverPass::UNIFORM_CROSSOVER :
+        crossover_name == "variable" ? CrossoverPass::VARIABLE_CROSSOVER : CrossoverPass::INVALID_CROSSOVER;
+    if (crossover == CrossoverPass::INVALID_CROSSOVER)
+        throw std::runtime_error("unknown crossover " + crossover_name);
+    return crossover;
+}
+
+// INVALID_STRATEGY stands for the genetic algorithm
+DifferentialEvolutionPass::DifferentialEvolutionStrategy parse_algorithm(const std::string& algorithm) {
+    const auto evolution = algorithm == "de_rand" ? DifferentialEvolutionPass::RAND_1_BIN :
+        algorithm == "de_best" ? DifferentialEvolutionPass::BEST_1_BIN : algorithm == "jade" ? DifferentialEvolutionPass::JADE :
+        DifferentialEvolutionPass::INVALID_STRATEGY;
+    if (algorithm != "ga" && evolution == DifferentialEvolutionPass::INVALID_STRATEGY)
+        throw std::runtime_error("unknown algorithm " + algorithm);
+    return evolution;
+}
+
+// checks every option the pipeline of the job needs, and that it sets none the pipeline ignores
+void validate_job(const JobSpec& job) {
+    required(job.population_size, "population_size");
+    required(job.max_generations, "max_generations");
+    required(job.start, "start");
+    required(job.end, "end");
+    if (parse_algorithm(job.algorithm) == DifferentialEvolutionPass::INVALID_STRATEGY) {
+        required(job.mutation_probability, "mutation_probability");
+        required(job.c1, "c1");
+        required(job.c2, "c2");
+        parse_crossover(job.crossover);
+    } else {
+        // the differential evolution pass is the whole pipeline
+        const auto reject = [&job](bool set, const char* name) {
+            if (set)
+                throw std::runtime_error(std::string("the option '--") + name + "' is not supported with --algorithm " + job.algorithm);
+        };
+        reject(job.mutation_probability.has_value(), "mutation_probability");
+        reject(job.c1.has_value(), "c1");
+        reject(job.c2.has_value(), "c2");
+        reject(job.elites != 0, "elites");
+        reject(job.local_search != 0, "local_search");
+        reject(job.crossover != "one_point", "crossover");
+    }
+    Objective{job.objective};
+}
+
+void register_pipeline(GeneticOptimizer& optimizer, const JobSpec& job) {
+    // differential evolution replaces the whole pipeline, it keeps the better of every target and trial
+    if (job.algorithm != "ga") {
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new DifferentialEvolutionPass(parse_algorithm(job.algorithm))));
+        return;
+    }
+    if (job.local_search)
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new LocalSearchPass(1, 8, job.local_search)));
+    if (job.elites)
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new ElitismPass(job.elites)));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass()));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass(parse_crossover(job.crossover))));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new ParticleSwarmOptimizationPass(*job.c1, *job.c2)));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(*job.mutation_probability)));
+}
+
+void add_stop_conditions(GeneticOptimizer& optimizer, const po::variables_map& vm) {
+    if (vm.count("stagnation"))
+        optimizer.add_stop_condition(std::make_unique<dl::Stagnation>(vm["stagnation"].as<size_t>()));
+    if (vm.count("time_budget_ms"))
+        optimizer.add_stop_condition(std::make_unique<dl::TimeBudget>(std::chrono::milliseconds(vm["time_budget_ms"].as<size_t>())));
+}
+
+// throws if any of the options is set on the command line, they are not supported by the given mode
+void reject_options(const po::variables_map& vm, std::initializer_list<const char*> options, const std::string& mode) {
+    for (const char* option : options) {
+        if (vm.count(option) && !vm[option].defaulted())
+            throw std::runtime_error(std::string("--") + option + " is not supported with " + mode);
+    }
+}
+
+// Reads one job per line (key=value pairs overriding the command line, '#' starts a comment
+// line) and runs them on a shared pool, printing one result line per job as soon as it finished
+void run_batch(const po::variables_map& vm, const JobSpec& defaults) {
+    // every job is one population on one worker; stop conditions and the fitness cache apply to each
+    reject_options(vm, {"islands", "island_processes", "steady_state", "checkpoint", "resume", "telemetry"}, "--batch");
+    const size_t fitness_cache = vm["fitness_cache"].as<size_t>();
+
+    const std::string& path = vm["batch"].as<std::string>();
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file)
+            throw std::runtime_error("cannot open job file " + path);
+    }
+    std::istream& input = path == "-" ? std::cin : file;
+
+    std::mutex output_mutex;
+    const auto report = [&output_mutex](const std::string& result) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << result << std::endl;
+    };
+
+    dl::BatchRunner runner(vm["batch_workers"].as<size_t>(), vm["threads_per_job"].as<size_t>());
+    std::string line;
+    for (size_t number = 1; std::getline(input, line); ++number) {
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        JobSpec job = defaults;
+        job.id = std::to_string(number);
+        try {
+            parse_job_line(job, line);
+            validate_job(job);
+        }
+        catch (const std::exception& e) {
+            report("id=" + job.id + " error=\"" + e.what() + "\"");
+            continue;
+        }
+        if (!job.seed)
+            job.seed = random_seed();
+
+        runner.submit([job, fitness_cache, &vm, &report](GeneticOptimizer& optimizer) {
+            std::ostringstream result;
+            result << "id=" << job.id << " seed=" << *job.seed;
+            try {
+                const auto begin = std::chrono::steady_clock::now();
+                optimizer.reset(*job.population_size, *job.max_generations, *job.seed);
+                register_pipeline(optimizer, job);
+                add_stop_conditions(optimizer, vm);
+                // the fits of the previous job do not hold for this one
+                optimizer.enable_fitness_cache(fitness_cache);
+                const Objective objective(job.objective);
+                const LinearTransformer transformer{*job.start, *job.end};
+                const double x = transformer(optimizer.optimize(make_fitness_function(objective), transformer).getDecodedGenome());
+                const auto end = std::chrono::steady_clock::now();
+                result << " x=" << x << " y=" << objective(x) << " evaluations=" << optimizer.statistics().evaluations
+                    << " generations=" << optimizer.generation() << " stopped=" << optimizer.stop_reason()
+                    << " cache_hit_rate=" << optimizer.statistics().cache_hit_rate()
+                    << " ms=" << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+            }
+            catch (const std::exception& e) {
+                result << " error=\"" << e.what() << "\"";
+            }
+            report(result.str());
+        });
+    }
+    runner.wait();
+}
+
 po::variables_map parse_arguments(int argc, char* argv[]) {
     po::options_description desc("Allowed options");
     desc.add_options()
-        ("population_size", po::value<size_t>()->required(), "set population size")
-        ("max_generations", po::value<size_t>()->required(), "set maximum amount of generations")
-        ("mutation_probability", po::value<double>()->required(), "set probability of mutation in each genome")
-        ("c1", po::value<double>()->required(), "set coef1 for particle swarm optimization")
-        ("c2", po::value<double>()->required(), "set coef2 for particle swarm optimization")
-        ("start", po::value<double>()->required(), "set search interval start")
-        ("end", po::value<double>()->required(), "set search interval end")
+        ("population_size", po::value<size_t>(), "set population size")
+        ("max_generations", po::value<size_t>(), "set maximum amount of generations")
+        ("mutation_probability", po::value<double>(), "set probability of mutation in each genome")
+        ("c1", po::value<double>(), "set coef1 for particle swarm optimization")
+        ("c2", po::value<double>(), "set coef2 for particle swarm optimization")
+        ("start", po::value<double>(), "set search interval start")
+        ("end", po::value<double>(), "set search interval end")
+        ("elites", po::value<size_t>()->default_value(0), "set number of best individuals kept unchanged every generation")
+        ("local_search", po::value<size_t>()->default_value(0), "set evaluations per generation of a hill-climb on the best individual (0 disables it)")
+        ("crossover", po::value<std::string>()->default_value("one_point"), "set crossover: one_point, two_point, uniform or variable")
+        ("algorithm", po::value<std::string>()->default_value("ga"), "set algorithm: ga, de_rand (DE/rand/1/bin), de_best (DE/best/1/bin) or jade; "
+            "the DE algorithms take none of the GA options (mutation_probability, c1, c2, elites, local_search, crossover)")
+        ("objective", po::value<std::string>(), "set minimized function of x, e.g. \"x*x*sin(x*x) + 1/(x+0.001)\" (the built-in target function by default); "
+            "+ - * / ^, sin cos tan exp log sqrt abs tanh pow min max, pi and e")
+        ("seed", po::value<uint64_t>(), "set random seed (random by default)")
+        ("fitness_cache", po::value<size_t>()->default_value(0), "set capacity of the genome to fit cache (0 disables it)")
+        ("islands", po::value<size_t>()->default_value(1), "set number of islands, each evolving population_size individuals on its own thread")
+        ("migration_interval", po::value<size_t>()->default_value(10), "set generations between two migrations")
+        ("migrants", po::value<size_t>()->default_value(2), "set number of individuals sent to every neighbour island")
+        ("topology", po::value<std::string>()->default_value("ring"), "set migration topology: ring or full")
+        ("async_migration", "do not wait for the immigrants of the same generation")
+        ("island_processes", "run every island in its own forked process instead of a thread")
+        ("telemetry", po::value<std::string>(), "record per pass telemetry and write it to the given file (not with --steady_state or --island_processes)")
+        ("telemetry_format", po::value<std::string>()->default_value("chrome"), "set telemetry file format: chrome (trace events) or json")
+        ("stagnation", po::value<size_t>(), "stop after the given number of generations without improvement (islands need --async_migration)")
+        ("time_budget_ms", po::value<size_t>(), "stop after the given wall-clock time in milliseconds (islands need --async_migration)")
+        ("checkpoint", po::value<std::string>(), "periodically write the state of the run to the given file (single population only)")
+        ("checkpoint_interval", po::value<size_t>()->default_value(10), "set generations between two checkpoints")
+        ("resume", po::value<std::string>(), "continue the run saved in the given checkpoint file (single population only)")
+        ("steady_state", "evolve asynchronously, replacing one individual per evaluation (population_size * max_generations evaluations); "
+            "genetic algorithm with --crossover and --mutation_probability only")
+        ("batch", po::value<std::string>(), "run the jobs of the given file (- for stdin), one line of key=value options per job; "
+            "stop conditions and the fitness cache apply to every job, islands, steady state, checkpoints and telemetry are not supported")
+        ("batch_workers", po::value<size_t>()->default_value(std::thread::hardware_concurrency()), "set number of jobs running at once in batch mode")
+        ("threads_per_job", po::value<size_t>()->default_value(1), "set OpenMP threads of every job in batch mode")
     ;
 
     po::variables_map vm;        
@@ -34,38 +367,129 @@ int main(int argc, char* argv[])
 {   
     try {
         auto vm = parse_arguments(argc, argv);
-        const size_t population_size = vm["population_size"].as<size_t>();
-        const size_t max_generations = vm["max_generations"].as<size_t>();
-        const double a = vm["start"].as<double>();
-        const double b = vm["end"].as<double>();
+        JobSpec job = job_from_arguments(vm);
+        if (vm.count("batch")) {
+            run_batch(vm, job);
+            return 0;
+        }
+
+        validate_job(job);
+        const size_t population_size = *job.population_size;
+        const size_t max_generations = *job.max_generations;
+        const double a = *job.start;
+        const double b = *job.end;
+        const uint64_t seed = job.seed ? *job.seed : random_seed();
 
         #pragma omp parallel
         {
             #pragma omp single
             std::cout << "OpenMP threads: " << omp_get_num_threads() << std::endl;
         }
+        std::cout << "Seed: " << seed << std::endl;
+
+        const size_t islands = vm["islands"].as<size_t>();
+        const bool island_processes = vm.count("island_processes");
+        const bool steady_state = vm.count("steady_state");
+
+        const std::string& topology = vm["topology"].as<std::string>();
+        if (topology != "ring" && topology != "full")
+            throw std::runtime_error("unknown migration topology " + topology);
+        MigrationPolicy policy;
+        policy.interval = vm["migration_interval"].as<size_t>();
+        policy.migrants = vm["migrants"].as<size_t>();
+        policy.topology = topology == "ring" ? MigrationTopology::RING : MigrationTopology::FULLY_CONNECTED;
+        policy.synchronous = !vm.count("async_migration");
+
+        // islands stop on their own, which IslandOptimizer only allows with asynchronous migration
+        const auto register_island = [job, &vm](dl::GeneticOptimizer& island) {
+            register_pipeline(island, job);
+            add_stop_conditions(island, vm);
+        };
 
-        dl::GeneticOptimizer optimizer(population_size, max_generations);
-        optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass()));
-        optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass()));
-        optimizer.register_pass(std::unique_ptr<PopulationPass>(new ParticleSwarmOptimizationPass(vm["c1"].as<double>(), vm["c2"].as<double>())));
-        optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(vm["mutation_probability"].as<double>())));
+        const auto telemetry = std::make_shared<Telemetry>();
+        telemetry->set_enabled(vm.count("telemetry"));
 
-        const auto& fitness_function = [](double x) {double y = target_function(x); return -y / (1 + exp(y));};
+        const Objective objective(job.objective);
+        const BatchFitnessFunction fitness_function = make_fitness_function(objective);
         //const auto& fitness_function = [](double x) {double y = target_function(x); return 100 * exp(-y);};
         // tranformer should map integer decoded genome value to double value
-        const auto& tranformer = [a, b](Genome::GenomeType g) {
-            double v = static_cast<double>(g) / static_cast<double>(Genome::getDistributionMaximumValue() - Genome::getDistributionMinimumValue()) * (b - a) + a;
-            return v;
-        };
-        
+        const LinearTransformer tranformer{a, b};
+        const size_t fitness_cache = vm["fitness_cache"].as<size_t>();
+
+        // only the selected optimizer is built; options it cannot honour are rejected
         const auto& begin = std::chrono::system_clock::now();
-        const auto& optimized_genome = optimizer.optimize(fitness_function, tranformer);
+        Genome optimized_genome;
+        EvaluationStatistics statistics;
+        std::string stopped;
+        if (steady_state) {
+            // the steady-state loop has a fixed crossover and mutation pipeline, no cache and no telemetry
+            reject_options(vm, {"stagnation", "time_budget_ms", "checkpoint", "resume", "island_processes", "elites", "local_search",
+                "fitness_cache", "telemetry"}, "--steady_state");
+            if (islands != 1)
+                throw std::runtime_error("--islands is not supported with --steady_state");
+            if (job.algorithm != "ga")
+                throw std::runtime_error("--algorithm " + job.algorithm + " is not supported with --steady_state");
+
+            dl::SteadyStateOptimizer steady_optimizer(population_size, population_size * max_generations, seed);
+            steady_optimizer.set_crossover(std::make_unique<CrossoverPass>(parse_crossover(job.crossover)));
+            steady_optimizer.set_mutation(std::make_unique<MutationPass>(*job.mutation_probability));
+            optimized_genome = steady_optimizer.optimize(fitness_function, tranformer);
+            statistics = steady_optimizer.statistics();
+        } else if (islands > 1) {
+            reject_options(vm, {"checkpoint", "resume"}, "--islands");
+            if (island_processes) {
+                // the events of the workers stay in their processes
+                reject_options(vm, {"telemetry"}, "--island_processes");
+                dl::ProcessIslandOptimizer process_optimizer(islands, population_size, max_generations, register_island, policy, seed);
+                process_optimizer.enable_fitness_cache(fitness_cache);
+                optimized_genome = process_optimizer.optimize(fitness_function, tranformer);
+                statistics = process_optimizer.statistics();
+            } else {
+                dl::IslandOptimizer island_optimizer(islands, population_size, max_generations, register_island, policy, seed);
+                island_optimizer.enable_fitness_cache(fitness_cache);
+                island_optimizer.set_telemetry(telemetry);
+                optimized_genome = island_optimizer.optimize(fitness_function, tranformer);
+                statistics = island_optimizer.statistics();
+            }
+        } else {
+            dl::GeneticOptimizer optimizer(population_size, max_generations, seed);
+            optimizer.enable_fitness_cache(fitness_cache);
+            register_pipeline(optimizer, job);
+            add_stop_conditions(optimizer, vm);
+            if (vm.count("checkpoint"))
+                optimizer.enable_checkpoints(vm["checkpoint"].as<std::string>(), vm["checkpoint_interval"].as<size_t>());
+            optimizer.set_telemetry(telemetry);
+
+            if (vm.count("resume")) {
+                // a resumed run goes through the step-wise interface
+                dl::FitnessEvaluator evaluator(fitness_function, tranformer);
+                optimizer.resume(evaluator, dl::Checkpoint(vm["resume"].as<std::string>()));
+                while (!optimizer.finished())
+                    optimizer.step(evaluator);
+                optimized_genome = Genome::fromEncodedGenome(optimizer.finish(evaluator)[0]);
+            } else {
+                optimized_genome = optimizer.optimize(fitness_function, tranformer);
+            }
+            statistics = optimizer.statistics();
+            stopped = std::string(optimizer.stop_reason()) + " after " + std::to_string(optimizer.generation()) + " generations";
+        }
         const auto& end = std::chrono::system_clock::now();
 
         const auto& x = tranformer(optimized_genome.getDecodedGenome());
-        std::cout << "Result: x = " << x << ", y = " << target_function(x) << std::endl;
+        std::cout << "Result: x = " << x << ", y = " << objective(x) << std::endl;
+        std::cout << "Evaluations: " << statistics.evaluations << " (skipped unchanged: " << statistics.skipped
+            << ", cache hit rate: " << statistics.cache_hit_rate() << ")" << std::endl;
+        if (!stopped.empty())
+            std::cout << "Stopped: " << stopped << std::endl;
         std::cout << "Ellapsed time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms" << std::endl;
+
+        if (vm.count("telemetry")) {
+            std::ofstream telemetry_file(vm["telemetry"].as<std::string>());
+            if (vm["telemetry_format"].as<std::string>() == "json")
+                telemetry->write_json(telemetry_file);
+            else
+                telemetry->write_chrome_trace(telemetry_file);
+        }
     }
     catch (const std::exception& e) {
         std::cout << "Failed to parse arguments: " << e.what() << std::endl;
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <steady_state.h>
+
+#include <cmath>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+// the counting operator new is installed by telemetry.cpp, one per test binary
+constexpr size_t warm_up_generations = 5;
+constexpr size_t measured_generations = 20;
+
+uint64_t allocations_per_run(GeneticOptimizer& optimizer, FitnessEvaluator& evaluator) {
+    optimizer.start(evaluator);
+    for (size_t i = 0; i < warm_up_generations; ++i)
+        optimizer.step(evaluator);
+
+    const uint64_t before = allocations();
+    for (size_t i = 0; i < measured_generations; ++i)
+        optimizer.step(evaluator);
+    return allocations() - before;
+}
+
+}
+
+class GenerationAllocationTest : public ::testing::TestWithParam<SelectionPass::SelectionStrategy>
+{
+protected:
+    int m_previous_threads = omp_get_max_threads();
+
+    void SetUp() override {
+        ASSERT_TRUE(allocation_counting);
+        // several threads, so that the per-thread paths are taken too
+        omp_set_num_threads(4);
+    }
+
+    void TearDown() override {
+        omp_set_num_threads(m_previous_threads);
+    }
+
+    GeneticOptimizer pipeline(bool with_swarm) const {
+        GeneticOptimizer optimizer(500, 1000, 3);
+        optimizer.register_pass(std::make_unique<ElitismPass>(5));
+        optimizer.register_pass(std::make_unique<SelectionPass>(GetParam()));
+        optimizer.register_pass(std::make_unique<CrossoverPass>());
+        optimizer.register_pass(std::make_unique<MutationPass>(0.01));
+        if (with_swarm)
+            optimizer.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(0.3, 0.3));
+        return optimizer;
+    }
+};
+
+TEST_P(GenerationAllocationTest, ScalarEvaluation) {
+    GeneticOptimizer optimizer = pipeline(false);
+    FitnessEvaluator evaluator([](double x) { return -x * x * std::sin(x); }, LinearTransformer{0.0, 3.0});
+    EXPECT_EQ(allocations_per_run(optimizer, evaluator), 0u);
+}
+
+TEST_P(GenerationAllocationTest, BatchedEvaluationWithCache) {
+    GeneticOptimizer optimizer = pipeline(true);
+    optimizer.enable_fitness_cache(1 << 12);
+    FitnessEvaluator evaluator([](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i)
+            fits[i] = -x[i] * x[i];
+    }, LinearTransformer{0.0, 3.0});
+    EXPECT_EQ(allocations_per_run(optimizer, evaluator), 0u);
+}
+
+TEST_P(GenerationAllocationTest, MultiVariableEvaluation) {
+    GeneticOptimizer optimizer = pipeline(true);
+    FitnessEvaluator evaluator([](std::span<const double> x) { return -(x[0] * x[0] + x[1] * x[1]); },
+        BoxTransformer<2, 20>(-1.0, 1.0));
+    EXPECT_EQ(allocations_per_run(optimizer, evaluator), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllStrategies, GenerationAllocationTest, ::testing::Values(SelectionPass::ROULETTE_WHEEL_SELECTION,
+    SelectionPass::RANK_SELECTION, SelectionPass::TOURNAMENT_SELECTION));
+
+TEST(ScratchArenaTest, GrowsOnceThenReusesItsBlock) {
+    ScratchArena arena;
+    for (size_t round = 0; round < 3; ++round) {
+        const uint64_t before = allocations();
+        auto doubles = arena.allocate<double>(1000);
+        auto indices = arena.allocate<size_t>(500);
+        if (round == 0)
+            EXPECT_GT(allocations() - before, 0u);
+        else
+            EXPECT_EQ(allocations() - before, 0u);
+
+        // spans of one round never overlap
+        EXPECT_TRUE(reinterpret_cast<std::byte*>(doubles.data() + doubles.size()) <= reinterpret_cast<std::byte*>(indices.data()) ||
+            reinterpret_cast<std::byte*>(indices.data() + indices.size()) <= reinterpret_cast<std::byte*>(doubles.data()));
+        std::fill(doubles.begin(), doubles.end(), 1.0);
+        std::fill(indices.begin(), indices.end(), size_t{2});
+        arena.reset();
+    }
+    EXPECT_GE(arena.capacity(), 1000 * sizeof(double) + 500 * sizeof(size_t));
+}
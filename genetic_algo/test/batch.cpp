@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <batch.h>
+
+#include <cmath>
+#include <mutex>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+double negative_sphere(std::span<const double> x) {
+    double sum = 0;
+    for (const double xi : x)
+        sum += (xi - 0.5) * (xi - 0.5);
+    return -sum;
+}
+
+void register_pipeline(GeneticOptimizer& optimizer) {
+    optimizer.register_pass(std::make_unique<SelectionPass>());
+    optimizer.register_pass(std::make_unique<CrossoverPass>(CrossoverPass::UNIFORM_CROSSOVER));
+    optimizer.register_pass(std::make_unique<MutationPass>(0.02));
+}
+
+// jobs alternate between a scalar and a three variable objective, of growing and shrinking size
+std::vector<Genome::GenomeType> run_job(GeneticOptimizer& optimizer, size_t job) {
+    optimizer.reset(20 + (job * 37) % 150, 10 + job % 7, job);
+    register_pipeline(optimizer);
+    if (job % 2) {
+        FitnessEvaluator evaluator([](double x) { return -x * x * std::sin(x); }, LinearTransformer{0.0, 3.0});
+        optimizer.optimize(evaluator);
+    } else {
+        FitnessEvaluator evaluator(MultiFitnessFunction(negative_sphere), BoxTransformer<3, 20>(-1.0, 1.0));
+        optimizer.optimize(evaluator);
+    }
+    const auto genomes = optimizer.population().genomes();
+    return std::vector<Genome::GenomeType>(genomes.begin(), genomes.end());
+}
+
+}
+
+TEST(GeneticOptimizerTest, ResetRunsLikeAFreshOptimizer) {
+    GeneticOptimizer reused(0, 0, 0);
+    reused.add_stop_condition(std::make_unique<Stagnation>(1));
+    for (size_t job = 0; job < 6; ++job) {
+        GeneticOptimizer fresh(0, 0, 0);
+        EXPECT_EQ(run_job(reused, job), run_job(fresh, job));
+        EXPECT_EQ(reused.generation(), fresh.generation());
+    }
+}
+
+TEST(PopulationStoreTest, ResetKeepsCapacity) {
+    Population population(100, BoxTransformer<3, 20>::layout(), true);
+    const auto* genomes = population.genomes().data();
+    population.reset(50, GenomeLayout{}, false);
+    EXPECT_EQ(population.size(), 50u);
+    EXPECT_EQ(population.words(), 1u);
+    EXPECT_FALSE(population.with_swarm_state());
+    EXPECT_EQ(population.genomes().data(), genomes);
+    for (size_t i = 0; i < population.size(); ++i)
+        EXPECT_TRUE(population.is_dirty(i));
+}
+
+TEST(BatchRunnerTest, JobsMatchStandaloneRuns) {
+    constexpr size_t jobs = 24;
+    std::vector<std::vector<Genome::GenomeType>> results(jobs);
+    // one pending job at a time exercises the backpressure
+    for (const size_t max_pending : {size_t(0), size_t(1)}) {
+        BatchRunner runner(3, 1, max_pending);
+        for (size_t job = 0; job < jobs; ++job)
+            runner.submit([&results, job](GeneticOptimizer& optimizer) { results[job] = run_job(optimizer, job); });
+        runner.wait();
+
+        for (size_t job = 0; job < jobs; ++job) {
+            GeneticOptimizer standalone(0, 0, 0);
+            EXPECT_EQ(results[job], run_job(standalone, job));
+        }
+    }
+}
+
+TEST(BatchRunnerTest, LimitsThreadsOfEveryJob) {
+    BatchRunner runner(2, 3);
+    std::mutex mutex;
+    std::vector<int> threads;
+    for (size_t job = 0; job < 8; ++job)
+        runner.submit([&](GeneticOptimizer&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.push_back(omp_get_max_threads());
+        });
+    runner.wait();
+
+    ASSERT_EQ(threads.size(), 8u);
+    for (const int count : threads)
+        EXPECT_EQ(count, 3);
+}
+
+TEST(BatchRunnerTest, WaitRethrowsFailedJobs) {
+    BatchRunner runner(2);
+    runner.submit([](GeneticOptimizer&) { throw std::runtime_error("failed job"); });
+    EXPECT_THROW(runner.wait(), std::runtime_error);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace dl;
+
+namespace {
+
+void register_swarm_pipeline(GeneticOptimizer& optimizer, double mutation_probability = 0.02) {
+    optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(mutation_probability));
+    optimizer.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(0.3, 0.3));
+}
+
+std::string checkpoint_path(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}
+
+TEST(CheckpointTest, ResumedRunMatchesUninterruptedRun) {
+    FitnessEvaluator evaluator = sphere_evaluator<3, 20>(-2.0, 2.0);
+    GeneticOptimizer uninterrupted(64, 30, 11);
+    register_swarm_pipeline(uninterrupted);
+    const auto expected = uninterrupted.optimize(evaluator);
+    const std::vector<Genome::GenomeType> expected_genome(expected.begin(), expected.end());
+
+    const std::string path = checkpoint_path("dl_checkpoint_resume.bin");
+    {
+        FitnessEvaluator first_evaluator = sphere_evaluator<3, 20>(-2.0, 2.0);
+        GeneticOptimizer first(64, 30, 11);
+        register_swarm_pipeline(first);
+        first.start(first_evaluator);
+        while (first.generation() < 12)
+            first.step(first_evaluator);
+        first.save_checkpoint(path, first_evaluator);
+    }
+
+    // a different seed in the constructor, the checkpoint's seed wins
+    FitnessEvaluator resumed_evaluator = sphere_evaluator<3, 20>(-2.0, 2.0);
+    GeneticOptimizer resumed(64, 30, 99);
+    register_swarm_pipeline(resumed);
+    const Checkpoint checkpoint(path);
+    EXPECT_EQ(checkpoint.generation(), 12u);
+    EXPECT_TRUE(checkpoint.header().with_swarm_state);
+    resumed.resume(resumed_evaluator, checkpoint);
+    while (!resumed.finished())
+        resumed.step(resumed_evaluator);
+    const auto result = resumed.finish(resumed_evaluator);
+
+    EXPECT_EQ(std::vector<Genome::GenomeType>(result.begin(), result.end()), expected_genome);
+    EXPECT_EQ(resumed.best_fit(), uninterrupted.best_fit());
+    EXPECT_EQ(resumed.statistics().evaluations, uninterrupted.statistics().evaluations);
+    EXPECT_EQ(resumed.seed(), 11u);
+    std::filesystem::remove(path);
+}
+
+TEST(CheckpointTest, PeriodicCheckpointsInBackground) {
+    const std::string path = checkpoint_path("dl_checkpoint_periodic.bin");
+    std::filesystem::remove(path);
+
+    // the run ends after generation 20, the last one checkpointed
+    GeneticOptimizer optimizer(64, 19, 5);
+    register_swarm_pipeline(optimizer);
+    optimizer.enable_checkpoints(path, 5);
+    optimizer.optimize(sphere_evaluator<3, 20>(-2.0, 2.0));
+
+    // finish waits for the last checkpoint
+    const Checkpoint checkpoint(path);
+    EXPECT_EQ(checkpoint.generation(), 20u);
+    EXPECT_EQ(checkpoint.size(), optimizer.population().size());
+    EXPECT_EQ(checkpoint.layout(), (GenomeLayout{3, 20}));
+    EXPECT_EQ(checkpoint.header().evaluations, optimizer.statistics().evaluations);
+
+    const auto genomes = optimizer.population().genomes();
+    EXPECT_TRUE(std::equal(genomes.begin(), genomes.end(), checkpoint.genomes().begin()));
+    const auto fits = optimizer.population().fits();
+    EXPECT_TRUE(std::equal(fits.begin(), fits.end(), checkpoint.fits().begin()));
+
+    Population restored;
+    checkpoint.restore(restored);
+    const auto velocities = optimizer.population().velocities();
+    EXPECT_TRUE(std::equal(velocities.begin(), velocities.end(), restored.velocities().begin()));
+    std::filesystem::remove(path);
+}
+
+TEST(CheckpointTest, RejectsMismatchAndCorruption) {
+    const std::string path = checkpoint_path("dl_checkpoint_invalid.bin");
+    FitnessEvaluator evaluator = sphere_evaluator<3, 20>(-2.0, 2.0);
+    GeneticOptimizer optimizer(16, 5, 1);
+    register_swarm_pipeline(optimizer);
+    optimizer.start(evaluator);
+    optimizer.save_checkpoint(path, evaluator);
+
+    // different mutation probability
+    GeneticOptimizer other(16, 5, 1);
+    register_swarm_pipeline(other, 0.5);
+    FitnessEvaluator other_evaluator = sphere_evaluator<3, 20>(-2.0, 2.0);
+    EXPECT_THROW(other.resume(other_evaluator, Checkpoint(path)), std::runtime_error);
+
+    // different genome layout
+    GeneticOptimizer scalar(16, 5, 1);
+    register_swarm_pipeline(scalar);
+    FitnessEvaluator scalar_evaluator([](double x) { return x; }, LinearTransformer{0.0, 1.0});
+    EXPECT_THROW(scalar.resume(scalar_evaluator, Checkpoint(path)), std::runtime_error);
+
+    // a population size whose section sizes wrap around
+    {
+        CheckpointHeader header;
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        header.size = (uint64_t{1} << 62) + 1;
+        header.variables = 4;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    EXPECT_THROW(Checkpoint checkpoint(path), std::runtime_error);
+
+    optimizer.save_checkpoint(path, evaluator);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    EXPECT_THROW(Checkpoint checkpoint(path), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << std::string(512, 'x');
+    EXPECT_THROW(Checkpoint checkpoint(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+
+#include <bit>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+constexpr CrossoverPass::CrossoverStrategy strategies[] = {CrossoverPass::ONE_POINT_CROSSOVER,
+    CrossoverPass::TWO_POINT_CROSSOVER, CrossoverPass::UNIFORM_CROSSOVER, CrossoverPass::VARIABLE_CROSSOVER};
+
+Population random_population(size_t size, GenomeLayout layout) {
+    Population population(size, layout);
+    RandomEngine engine = RandomSource(21).stream(0);
+    for (size_t i = 0; i < size; ++i) {
+        for (auto& word : population.genome(i))
+            word = engine() & layout.mask();
+        population.set_fit(i, engine.uniform());
+    }
+    return population;
+}
+
+// bits of the child taken from rhs, as one string over the whole genome (bit 0 of word 0 first)
+std::vector<bool> from_rhs(std::span<const uint64_t> child, const GenomeLayout& layout) {
+    std::vector<bool> bits;
+    for (size_t word = 0; word < layout.words(); ++word) {
+        for (size_t bit = 0; bit < layout.bits; ++bit)
+            bits.push_back(!((child[word] >> bit) & 1));
+    }
+    return bits;
+}
+
+}
+
+TEST(CrossoverTest, ChildBitsComeFromTheParents) {
+    // lhs all ones and rhs all zeros: every set bit of the child is a bit from lhs
+    const GenomeLayout layout{3, 40};
+    const std::vector<uint64_t> lhs(layout.words(), layout.mask()), rhs(layout.words(), 0);
+    std::vector<uint64_t> child(layout.words());
+
+    for (const auto strategy : strategies) {
+        const CrossoverPass pass(strategy);
+        for (uint64_t seed = 0; seed < 200; ++seed) {
+            RandomEngine engine = RandomSource(seed).stream(0);
+            pass.crossover(lhs, rhs, child, layout, engine);
+            for (const auto word : child)
+                EXPECT_EQ(word & ~layout.mask(), 0u);
+
+            // the bits taken from rhs form 1 suffix, 1 range, any set, or whole words
+            const std::vector<bool> bits = from_rhs(child, layout);
+            size_t switches = 0;
+            for (size_t k = 1; k < bits.size(); ++k)
+                switches += bits[k] != bits[k - 1];
+            if (strategy == CrossoverPass::ONE_POINT_CROSSOVER) {
+                EXPECT_LE(switches, 1u);
+                EXPECT_TRUE(bits.front() || switches == 0);
+            } else if (strategy == CrossoverPass::TWO_POINT_CROSSOVER) {
+                EXPECT_LE(switches, 2u);
+            } else if (strategy == CrossoverPass::VARIABLE_CROSSOVER) {
+                for (const auto word : child)
+                    EXPECT_TRUE(word == 0 || word == layout.mask());
+            }
+        }
+    }
+
+    // uniform crossover takes about half of the bits from each parent
+    const CrossoverPass uniform(CrossoverPass::UNIFORM_CROSSOVER);
+    size_t set_bits = 0;
+    for (uint64_t seed = 0; seed < 100; ++seed) {
+        RandomEngine engine = RandomSource(seed).stream(0);
+        uniform.crossover(lhs, rhs, child, layout, engine);
+        for (const auto word : child)
+            set_bits += std::popcount(word);
+    }
+    EXPECT_NEAR(static_cast<double>(set_bits) / (100 * layout.total_bits()), 0.5, 0.02);
+}
+
+TEST(CrossoverTest, ParallelRunIsIndependentOfThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    const GenomeLayout layout{4, 24};
+    for (const auto strategy : strategies) {
+        const CrossoverPass pass(strategy, 3);
+        Population single = random_population(101, layout);
+        Population parallel = random_population(101, layout);
+
+        omp_set_num_threads(1);
+        pass.run(single, PassContext{2, RandomSource(8)});
+        omp_set_num_threads(4);
+        pass.run(parallel, PassContext{2, RandomSource(8)});
+
+        ASSERT_EQ(single.size(), 303u);
+        EXPECT_TRUE(std::equal(single.genomes().begin(), single.genomes().end(), parallel.genomes().begin()));
+        for (size_t i = 101; i < single.size(); ++i) {
+            EXPECT_EQ(single.generations()[i], 2u);
+            EXPECT_TRUE(single.is_dirty(i));
+        }
+    }
+    omp_set_num_threads(previous_threads);
+}
+
+TEST(CrossoverTest, ParentsStayInRange) {
+    // a parent drawn past the end would be the first child slot, still zero when it is read
+    const GenomeLayout layout{1, 64};
+    const uint64_t genomes[] = {0x5555555555555555ull, 0xaaaaaaaaaaaaaaaaull};
+    for (const size_t parents : {1u, 2u}) {
+        Population population(parents, layout);
+        for (size_t i = 0; i < parents; ++i)
+            population.genome(i)[0] = genomes[i];
+        const CrossoverPass pass(CrossoverPass::VARIABLE_CROSSOVER, 50);
+        pass.run(population, PassContext{1, RandomSource(3)});
+
+        ASSERT_EQ(population.size(), 50 * parents);
+        for (size_t i = parents; i < population.size(); ++i) {
+            const uint64_t word = population.genome(i)[0];
+            EXPECT_TRUE(word == genomes[0] || (parents == 2 && word == genomes[1]));
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <differential_evolution.h>
+#include "test_helpers.h"
+
+#include <cmath>
+#include <filesystem>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 5;
+using Transformer = BoxTransformer<variables, 32>;
+
+GeneticOptimizer differential_evolution(DifferentialEvolutionPass::DifferentialEvolutionStrategy strategy, size_t generations, uint64_t seed) {
+    GeneticOptimizer optimizer(60, generations, seed);
+    optimizer.register_pass(std::make_unique<DifferentialEvolutionPass>(strategy));
+    return optimizer;
+}
+
+}
+
+class DifferentialEvolutionTest : public ::testing::TestWithParam<DifferentialEvolutionPass::DifferentialEvolutionStrategy> {};
+
+TEST_P(DifferentialEvolutionTest, ConvergesOnSphere) {
+    GeneticOptimizer optimizer = differential_evolution(GetParam(), 400, 3);
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+    const auto best = Transformer(-5.0, 5.0)(MultiGenome<variables, 32>::fromEncodedGenome(optimizer.optimize(evaluator)));
+
+    EXPECT_GT(optimizer.best_fit(), -1e-6);
+    for (const double x : best)
+        EXPECT_NEAR(x, 1.0, 1e-3);
+}
+
+TEST_P(DifferentialEvolutionTest, TargetsNeverGetWorse) {
+    GeneticOptimizer optimizer = differential_evolution(GetParam(), 50, 5);
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+    optimizer.start(evaluator);
+    std::vector<double> fits(optimizer.population().fits().begin(), optimizer.population().fits().end());
+    while (!optimizer.finished()) {
+        optimizer.step(evaluator);
+        const auto current = optimizer.population().fits();
+        for (size_t i = 0; i < fits.size(); ++i) {
+            ASSERT_GE(current[i], fits[i]);
+            ASSERT_FALSE(optimizer.population().is_dirty(i));
+        }
+        fits.assign(current.begin(), current.end());
+    }
+}
+
+TEST_P(DifferentialEvolutionTest, SameResultForAnyThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    std::vector<std::vector<Genome::GenomeType>> results;
+    for (const int threads : {1, 3, 4}) {
+        omp_set_num_threads(threads);
+        // more individuals than one block of the kernel
+        GeneticOptimizer optimizer(300, 20, 9);
+        optimizer.register_pass(std::make_unique<DifferentialEvolutionPass>(GetParam()));
+        FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+        optimizer.optimize(evaluator);
+        const auto genomes = optimizer.population().genomes();
+        results.emplace_back(genomes.begin(), genomes.end());
+    }
+    omp_set_num_threads(previous_threads);
+
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_EQ(results[0], results[2]);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllStrategies, DifferentialEvolutionTest, ::testing::Values(DifferentialEvolutionPass::RAND_1_BIN,
+    DifferentialEvolutionPass::BEST_1_BIN, DifferentialEvolutionPass::JADE));
+
+TEST(JadeTest, MeansFollowSuccessfulTrials) {
+    GeneticOptimizer optimizer = differential_evolution(DifferentialEvolutionPass::JADE, 30, 4);
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+    optimizer.optimize(evaluator);
+
+    const PassState& state = optimizer.pass_state(0);
+    EXPECT_NE(DifferentialEvolutionPass::scale_mean(state), 0.5);
+    EXPECT_NE(DifferentialEvolutionPass::crossover_rate_mean(state), 0.5);
+    EXPECT_GT(DifferentialEvolutionPass::scale_mean(state), 0.0);
+    EXPECT_LE(DifferentialEvolutionPass::scale_mean(state), 1.0);
+    EXPECT_GE(DifferentialEvolutionPass::crossover_rate_mean(state), 0.0);
+    EXPECT_LE(DifferentialEvolutionPass::crossover_rate_mean(state), 1.0);
+
+    // a new run starts from the initial means
+    optimizer.start(evaluator);
+    EXPECT_EQ(DifferentialEvolutionPass::scale_mean(optimizer.pass_state(0)), 0.5);
+}
+
+TEST(JadeTest, SameMeansForAnyThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    std::vector<PassState> states;
+    for (const int threads : {1, 3, 7}) {
+        omp_set_num_threads(threads);
+        // long enough for a thread dependent summation order to show in the means
+        GeneticOptimizer optimizer(300, 300, 9);
+        optimizer.register_pass(std::make_unique<DifferentialEvolutionPass>(DifferentialEvolutionPass::JADE));
+        FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+        optimizer.optimize(evaluator);
+        states.push_back(optimizer.pass_state(0));
+    }
+    omp_set_num_threads(previous_threads);
+
+    EXPECT_EQ(states[0], states[1]);
+    EXPECT_EQ(states[0], states[2]);
+}
+
+TEST(JadeTest, ResumedRunKeepsTheMeans) {
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+    GeneticOptimizer uninterrupted = differential_evolution(DifferentialEvolutionPass::JADE, 40, 6);
+    uninterrupted.optimize(evaluator);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "dl_jade_resume.bin").string();
+    {
+        FitnessEvaluator first_evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+        GeneticOptimizer first = differential_evolution(DifferentialEvolutionPass::JADE, 40, 6);
+        first.start(first_evaluator);
+        while (first.generation() < 15)
+            first.step(first_evaluator);
+        first.save_checkpoint(path, first_evaluator);
+    }
+
+    FitnessEvaluator resumed_evaluator = sphere_evaluator<variables, 32>(-5.0, 5.0);
+    GeneticOptimizer resumed = differential_evolution(DifferentialEvolutionPass::JADE, 40, 6);
+    resumed.resume(resumed_evaluator, Checkpoint(path));
+    EXPECT_NE(DifferentialEvolutionPass::scale_mean(resumed.pass_state(0)), 0.5);
+    while (!resumed.finished())
+        resumed.step(resumed_evaluator);
+    resumed.finish(resumed_evaluator);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(resumed.pass_state(0), uninterrupted.pass_state(0));
+    const auto expected = uninterrupted.population().genomes();
+    const auto genomes = resumed.population().genomes();
+    EXPECT_TRUE(std::equal(genomes.begin(), genomes.end(), expected.begin(), expected.end()));
+}
+
+TEST(JadeTest, RejectsTinyPopulations) {
+    EXPECT_THROW(DifferentialEvolutionPass(DifferentialEvolutionPass::INVALID_STRATEGY), std::runtime_error);
+
+    Population population(3);
+    EXPECT_THROW(DifferentialEvolutionPass().run(population, PassContext{0, RandomSource(1)}), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+
+#include <cmath>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+Population population_with_ties(size_t size) {
+    Population population(size);
+    RandomEngine engine = RandomSource(17).stream(0);
+    for (size_t i = 0; i < size; ++i)
+        population.set_fit(i, std::floor(engine.uniform() * 200.0) - 100.0);
+    return population;
+}
+
+}
+
+TEST(FitRankingTest, RankedEntriesMatchTheFullSort) {
+    const int previous_threads = omp_get_max_threads();
+    const Population population = population_with_ties(20000);
+    std::vector<size_t> sorted;
+    sort_by_fit(population, sorted);
+
+    FitRanking ranking;
+    for (const int threads : {1, 3, 4}) {
+        omp_set_num_threads(threads);
+        for (const auto& [best, worst] : {std::pair<size_t, size_t>{1, 0}, {10, 0}, {7, 25}, {0, 3}, {200, 100}}) {
+            ranking.rank(population, best, worst);
+            const auto order = ranking.order();
+            ASSERT_EQ(order.size(), population.size());
+            EXPECT_EQ(ranking.best(), best);
+            EXPECT_EQ(ranking.worst(), worst);
+
+            EXPECT_TRUE(std::equal(order.begin(), order.begin() + best, sorted.begin()));
+            EXPECT_TRUE(std::equal(order.end() - worst, order.end(), sorted.end() - worst));
+
+            // the rest keeps index order and everyone appears once
+            EXPECT_TRUE(std::is_sorted(order.begin() + best, order.end() - worst));
+            std::vector<size_t> permutation(order.begin(), order.end());
+            std::sort(permutation.begin(), permutation.end());
+            for (size_t i = 0; i < permutation.size(); ++i)
+                ASSERT_EQ(permutation[i], i);
+        }
+    }
+    omp_set_num_threads(previous_threads);
+}
+
+TEST(ElitismPassTest, ElitesSurviveUnchanged) {
+    const auto fitness_function = [](double x) { return -std::abs(x - 0.7); };
+    FitnessEvaluator evaluator(fitness_function, LinearTransformer{0.0, 1.0});
+
+    constexpr size_t elites = 4;
+    GeneticOptimizer optimizer(100, 30, 2);
+    optimizer.register_pass(std::make_unique<ElitismPass>(elites));
+    optimizer.register_pass(std::make_unique<SelectionPass>());
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    // heavy mutation and swarm moves would destroy anything not protected
+    optimizer.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(1.0, 1.0));
+    optimizer.register_pass(std::make_unique<MutationPass>(0.3));
+    optimizer.set_ranking(elites, 0);
+
+    optimizer.start(evaluator);
+    while (!optimizer.finished()) {
+        std::vector<std::pair<double, Genome::GenomeType>> previous;
+        for (size_t j = 0; j < elites; ++j) {
+            const size_t idx = optimizer.order()[j];
+            previous.emplace_back(optimizer.population().fits()[idx], optimizer.population().genome(idx)[0]);
+        }
+
+        const size_t evaluations = evaluator.statistics().evaluations;
+        optimizer.step(evaluator);
+        // the elites were not evaluated again
+        EXPECT_LE(evaluator.statistics().evaluations - evaluations, optimizer.population().size() - elites);
+
+        const auto& population = optimizer.population();
+        for (const auto& [fit, genome] : previous) {
+            bool found = false;
+            for (size_t i = 0; i < population.size() && !found; ++i)
+                found = population.genome(i)[0] == genome && population.fits()[i] == fit;
+            EXPECT_TRUE(found);
+        }
+        EXPECT_GE(optimizer.best_fit(), previous.front().first);
+    }
+}
+
+TEST(ElitismPassTest, NeedsAnOptimizerArena) {
+    Population population(4);
+    EXPECT_THROW(ElitismPass(2).run(population, PassContext{0, RandomSource(1)}), std::runtime_error);
+}
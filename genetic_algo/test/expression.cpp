@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <expression.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace dl;
+
+namespace {
+
+double target_function(double x) {
+    return x * x * std::sin(x * x) + 1 / (x + 0.001);
+}
+
+double value(const std::string& text, double x = 0) {
+    return Expression(text).evaluate(std::span<const double>(&x, 1));
+}
+
+}
+
+TEST(ExpressionTest, MatchesNativeCodeOverBatches) {
+    const Expression expression("x*x*sin(x*x) + 1/(x+0.001)");
+    // not a multiple of the block
+    std::vector<double> x(3 * Expression::block + 17);
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = -2.0 + 0.01 * i;
+    std::vector<double> values(x.size());
+    expression(x, values);
+
+    for (size_t i = 0; i < x.size(); ++i)
+        EXPECT_DOUBLE_EQ(values[i], target_function(x[i]));
+}
+
+TEST(ExpressionTest, PrecedenceAndFunctions) {
+    EXPECT_DOUBLE_EQ(value("1 + 2 * 3 - 4 / 2"), 5.0);
+    EXPECT_DOUBLE_EQ(value("2 ^ 3 ^ 2"), 512.0);
+    EXPECT_DOUBLE_EQ(value("-2^2"), -4.0);
+    EXPECT_DOUBLE_EQ(value("2^-1"), 0.5);
+    EXPECT_DOUBLE_EQ(value("(1 + 2) * 3"), 9.0);
+    EXPECT_DOUBLE_EQ(value("8 / 4 / 2"), 1.0);
+    EXPECT_DOUBLE_EQ(value("min(x, 3) + max(x, 3) + pow(x, 3)", 2.0), 13.0);
+    EXPECT_DOUBLE_EQ(value("abs(x) + sqrt(4) + exp(0) + log(e) + cos(pi)", -1.5), 4.5);
+    EXPECT_DOUBLE_EQ(value("tanh(x) + tan(x)", 0.3), std::tanh(0.3) + std::tan(0.3));
+    EXPECT_DOUBLE_EQ(value("1.5e2 + .5"), 150.5);
+}
+
+TEST(ExpressionTest, FoldsConstantsAndSharesSubexpressions) {
+    // x*x once, sin(x*x) once: load, mul, sin, mul
+    EXPECT_EQ(Expression("x*x*sin(x*x)").instructions(), 4u);
+    EXPECT_EQ(Expression("x ^ 2 + x * x").instructions(), 3u);
+    // everything folded, the value is a constant register
+    EXPECT_EQ(Expression("2 * pi + sqrt(16)").instructions(), 0u);
+    EXPECT_DOUBLE_EQ(value("2 * pi + sqrt(16)"), 2 * 3.141592653589793 + 4);
+    // registers are reused once their last reader ran
+    EXPECT_LE(Expression("((x+1)*(x+2))*((x+3)*(x+4))").registers(), 4u + 3u);
+}
+
+TEST(ExpressionTest, RowsOfSeveralVariables) {
+    const Expression expression("10 * (y - x^2)^2 + (1 - x)^2 + 0 * z", {"x", "y", "z"});
+    const std::vector<double> x = {1, 1, 5, 0, 0, 5, 2, 3, 5};
+    std::vector<double> values(3);
+    expression(x, values);
+
+    EXPECT_DOUBLE_EQ(values[0], 0.0);
+    EXPECT_DOUBLE_EQ(values[1], 1.0);
+    EXPECT_DOUBLE_EQ(values[2], 11.0);
+}
+
+TEST(ExpressionTest, RejectsInvalidText) {
+    for (const char* text : {"", "x +", "(x", "x)", "sin x", "foo(x)", "y", "2 $ 3", "pow(x)", "min(x, 1, 2)"})
+        EXPECT_THROW(Expression{text}, std::runtime_error) << text;
+}
+
+TEST(ExpressionTest, DrivesTheOptimizer) {
+    const auto optimize = [](BatchFitnessFunction fitness) {
+        GeneticOptimizer optimizer(100, 20, 3);
+        optimizer.register_pass(std::make_unique<SelectionPass>());
+        optimizer.register_pass(std::make_unique<CrossoverPass>());
+        optimizer.register_pass(std::make_unique<MutationPass>(0.01));
+        return optimizer.optimize(std::move(fitness), LinearTransformer{0.5, 3.0}).getEncodedGenome();
+    };
+
+    const Expression expression("-(x*x*sin(x*x) + 1/(x+0.001))");
+    const auto native = [](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i)
+            fits[i] = -target_function(x[i]);
+    };
+    EXPECT_EQ(optimize(expression), optimize(native));
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+
+using namespace dl;
+
+namespace {
+
+double parabola(double x) {
+    return -(x - 1.0) * (x - 1.0);
+}
+
+void batch_parabola(std::span<const double> xs, std::span<double> fits) {
+    for (size_t i = 0; i < xs.size(); ++i)
+        fits[i] = parabola(xs[i]);
+}
+
+} // namespace
+
+TEST(FitnessTest, DecodeTransformMatchesScalarPath) {
+    const LinearTransformer transformer{-2.0, 3.0};
+    RandomEngine engine = RandomSource(5).stream(0);
+
+    std::vector<Genome::GenomeType> encoded(1000);
+    for (auto& value : encoded)
+        value = engine();
+    encoded[0] = 0;
+    encoded[1] = Genome(Genome::getDistributionMaximumValue()).getEncodedGenome();
+
+    std::vector<double> x(encoded.size());
+    decode_transform(encoded, x, transformer);
+    for (size_t i = 0; i < encoded.size(); ++i)
+        EXPECT_EQ(x[i], transformer(Genome::fromEncodedGenome(encoded[i]).getDecodedGenome()));
+    EXPECT_EQ(x[0], -2.0);
+    EXPECT_DOUBLE_EQ(x[1], 3.0);
+}
+
+TEST(FitnessTest, BatchEvaluationMatchesScalarEvaluation) {
+    const LinearTransformer transformer{-2.0, 3.0};
+    Population scalar_population(3000), batch_population(3000);
+    RandomEngine engine = RandomSource(6).stream(0);
+    for (size_t i = 0; i < scalar_population.size(); ++i) {
+        const auto genome = engine();
+        scalar_population.assign(i, genome, 0);
+        batch_population.assign(i, genome, 0);
+    }
+
+    FitnessEvaluator(parabola, transformer).evaluate(scalar_population);
+    FitnessEvaluator(batch_parabola, transformer, 256).evaluate(batch_population);
+    for (size_t i = 0; i < scalar_population.size(); ++i)
+        EXPECT_EQ(scalar_population.fits()[i], batch_population.fits()[i]);
+}
+
+TEST(FitnessTest, OptimizeUsesBatchFunction) {
+    auto run = [](auto fitness_function) {
+        GeneticOptimizer optimizer(128, 20, 99);
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(0.02)));
+        return optimizer.optimize(fitness_function, LinearTransformer{-2.0, 3.0}).getEncodedGenome();
+    };
+
+    EXPECT_EQ(run(FitnessFunction(parabola)), run(BatchFitnessFunction(batch_parabola)));
+}
+
+TEST(FitnessTest, OnlyDirtyIndividualsAreEvaluated) {
+    std::atomic<size_t> calls{0};
+    FitnessEvaluator evaluator([&calls](double x) { calls++; return parabola(x); }, LinearTransformer{-2.0, 3.0});
+
+    Population population(100);
+    for (size_t i = 0; i < population.size(); ++i)
+        population.assign(i, i * 7919, 0);
+
+    evaluator.evaluate(population);
+    EXPECT_EQ(calls, 100u);
+
+    population.mark_dirty(3);
+    population.assign(50, 1, 1);
+    evaluator.evaluate(population);
+    EXPECT_EQ(calls, 102u);
+    EXPECT_EQ(evaluator.statistics().evaluations, 102u);
+    EXPECT_EQ(evaluator.statistics().skipped, 98u);
+}
+
+TEST(FitnessTest, CacheReturnsInsertedFits) {
+    FitnessCache cache(1000);
+    EXPECT_EQ(cache.capacity(), 1024u);
+
+    double fit = 0;
+    EXPECT_FALSE(cache.lookup(42, fit));
+    cache.insert(42, 1.5);
+    ASSERT_TRUE(cache.lookup(42, fit));
+    EXPECT_EQ(fit, 1.5);
+    EXPECT_FALSE(cache.lookup(43, fit));
+
+    cache.clear();
+    EXPECT_FALSE(cache.lookup(42, fit));
+}
+
+TEST(FitnessTest, CacheDoesNotChangeResults) {
+    auto run = [](size_t cache_capacity, EvaluationStatistics& statistics) {
+        GeneticOptimizer optimizer(128, 20, 99);
+        optimizer.enable_fitness_cache(cache_capacity);
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(0.02)));
+        const auto genome = optimizer.optimize(BatchFitnessFunction(batch_parabola), LinearTransformer{-2.0, 3.0});
+        statistics = optimizer.statistics();
+        return genome.getEncodedGenome();
+    };
+
+    EvaluationStatistics uncached, cached;
+    EXPECT_EQ(run(0, uncached), run(1 << 12, cached));
+    EXPECT_GT(cached.cache_hits, 0u);
+    EXPECT_LT(cached.evaluations, uncached.evaluations);
+    EXPECT_EQ(uncached.cache_lookups, 0u);
+}
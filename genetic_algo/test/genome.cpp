@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+
+using namespace dl;
+
+TEST(MultiGenomeTest, EncodeDecodeVariables) {
+    using GenomeT = MultiGenome<3, 10>;
+    const GenomeT genome(GenomeT::Words{0, 1023, 4096 + 5});
+
+    EXPECT_EQ(genome.getDecodedVariable(0), 0u);
+    EXPECT_EQ(genome.getDecodedVariable(1), 1023u);
+    EXPECT_EQ(genome.getDecodedVariable(2), 5u); // bits above 10 are dropped
+    EXPECT_EQ(GenomeT::getGenomeSize(), 30u);
+
+    const BoxTransformer<3, 10> transformer({-1.0, 0.0, 0.0}, {1.0, 2.0, 1023.0});
+    const auto x = transformer(genome);
+    EXPECT_DOUBLE_EQ(x[0], -1.0);
+    EXPECT_DOUBLE_EQ(x[1], 2.0);
+    EXPECT_DOUBLE_EQ(x[2], 5.0);
+}
+
+TEST(MultiGenomeTest, PassesKeepUnusedBitsClear) {
+    const GenomeLayout layout{4, 12};
+    Population population(64, layout);
+    RandomEngine engine = RandomSource(3).stream(0);
+    for (size_t i = 0; i < population.size(); ++i) {
+        for (auto& word : population.genome(i))
+            word = engine() & layout.mask();
+        population.set_fit(i, static_cast<double>(i));
+    }
+
+    CrossoverPass().run(population, PassContext{1, RandomSource(4)});
+    MutationPass(0.5).run(population, PassContext{1, RandomSource(5)});
+    ASSERT_EQ(population.size(), 128u);
+    for (const auto word : population.genomes())
+        EXPECT_EQ(word & ~layout.mask(), 0u);
+}
+
+TEST(MultiGenomeTest, OptimizeMultiVariableSphere) {
+    constexpr size_t variables = 8;
+    const BoxTransformer<variables, 20> transformer(-5.0, 5.0);
+    const auto sphere = [](std::span<const double> x) {
+        double sum = 0.0;
+        for (const double value : x)
+            sum += (value - 1.0) * (value - 1.0);
+        return -sum;
+    };
+
+    GeneticOptimizer optimizer(256, 150, 17);
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass(SelectionPass::TOURNAMENT_SELECTION)));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass()));
+    optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(0.01)));
+
+    const auto best = transformer(optimizer.optimize(MultiFitnessFunction(sphere), transformer));
+    for (const double value : best)
+        EXPECT_NEAR(value, 1.0, 0.5);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <bit>
+#include <vector>
 #include <gray_code.h>
+#include <genome.h>
 
 using namespace dl;
 
@@ -25,3 +28,62 @@ TEST_F(GrayCodeFixture, BasicDecode) {
     EXPECT_EQ(m_encoder.decode(2u), 3u);
     EXPECT_EQ(m_encoder.decode(6u), 4u);
 }
+
+namespace {
+
+// reference: the former one-step-per-bit decode
+template <typename T>
+T reference_decode(T code) {
+    T value = 0;
+    for (; code; code >>= 1)
+        value ^= code;
+    return value;
+}
+
+} // namespace
+
+static_assert(gray_decode(gray_encode<uint64_t>(0x123456789abcdefull)) == 0x123456789abcdefull);
+static_assert(Genome(42u).getDecodedGenome() == 42u);
+static_assert(sizeof(Genome) == sizeof(Genome::GenomeType), "Genome must not carry an encoder vtable");
+
+TEST(GrayCodeTest, Exhaustive16Bit) {
+    for (uint32_t i = 0; i <= 0xffff; ++i) {
+        const uint16_t value = static_cast<uint16_t>(i);
+        const uint16_t code = gray_encode(value);
+        ASSERT_EQ(gray_decode(code), value);
+        ASSERT_EQ(gray_decode(code), reference_decode(code));
+        if (value) { // neighbours differ in exactly one bit
+            ASSERT_EQ(std::popcount(static_cast<uint16_t>(code ^ gray_encode<uint16_t>(value - 1))), 1);
+        }
+    }
+}
+
+TEST(GrayCodeTest, Randomized64Bit) {
+    RandomEngine engine = RandomSource(8).stream(0);
+    GrayEncoder<uint64_t, uint64_t> encoder;
+    for (size_t i = 0; i < 100000; ++i) {
+        const uint64_t value = engine() >> engine.bounded(64);
+        ASSERT_EQ(gray_decode(gray_encode(value)), value);
+        ASSERT_EQ(gray_decode(value), reference_decode(value));
+        ASSERT_EQ(encoder.decode(value), reference_decode(value));
+        ASSERT_EQ(encoder.encode(value), gray_encode(value));
+    }
+}
+
+TEST(GrayCodeTest, BatchMatchesScalar) {
+    RandomEngine engine = RandomSource(9).stream(0);
+    std::vector<uint64_t> values(1037), codes(values.size()), decoded(values.size());
+    for (auto& value : values)
+        value = engine();
+
+    gray_encode<uint64_t>(values, codes);
+    gray_decode<uint64_t>(codes, decoded);
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(codes[i], gray_encode(values[i]));
+        ASSERT_EQ(decoded[i], values[i]);
+    }
+
+    // in place
+    gray_decode<uint64_t>(codes, codes);
+    EXPECT_EQ(codes, values);
+}
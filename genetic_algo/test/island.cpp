@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <island_optimizer.h>
+#include "test_helpers.h"
+
+using namespace dl;
+
+TEST(MigrationTest, TopologyNeighbours) {
+    EXPECT_EQ(migration_targets(3, 4, MigrationTopology::RING), std::vector<size_t>{0});
+    EXPECT_EQ(migration_sources(0, 4, MigrationTopology::RING), std::vector<size_t>{3});
+    EXPECT_EQ(migration_targets(1, 3, MigrationTopology::FULLY_CONNECTED), (std::vector<size_t>{0, 2}));
+    EXPECT_EQ(migration_sources(1, 3, MigrationTopology::FULLY_CONNECTED), (std::vector<size_t>{0, 2}));
+    EXPECT_TRUE(migration_targets(0, 1, MigrationTopology::FULLY_CONNECTED).empty());
+}
+
+TEST(MigrationTest, MailboxIsFifoAndBounded) {
+    const GenomeLayout layout{2, 16};
+    MigrantMailbox mailbox(2, migrant_record_words(layout));
+    MigrantRing& ring = mailbox.ring();
+    std::vector<uint64_t> record(migrant_record_words(layout));
+
+    for (uint64_t epoch = 1; epoch <= 2; ++epoch) {
+        const std::vector<uint64_t> genome{epoch, epoch * 10};
+        encode_migrant(record, epoch, -0.5 * epoch, genome);
+        EXPECT_TRUE(ring.push(record));
+    }
+    EXPECT_FALSE(ring.push(record));
+    EXPECT_EQ(ring.size(), 2u);
+
+    for (uint64_t epoch = 1; epoch <= 2; ++epoch) {
+        ASSERT_TRUE(ring.pop(record));
+        const Migrant migrant = decode_migrant(record);
+        EXPECT_EQ(migrant.epoch, epoch);
+        EXPECT_DOUBLE_EQ(migrant.fit, -0.5 * epoch);
+        EXPECT_EQ(migrant.genome[0], epoch);
+        EXPECT_EQ(migrant.genome[1], epoch * 10);
+    }
+    EXPECT_FALSE(ring.pop(record));
+}
+
+TEST(IslandOptimizerTest, SynchronousRunsAreReproducible) {
+    for (const auto topology : {MigrationTopology::RING, MigrationTopology::FULLY_CONNECTED}) {
+        const MigrationPolicy policy{5, 3, topology, true};
+        IslandOptimizer first(4, 100, 30, register_pipeline, policy, 11);
+        IslandOptimizer second(4, 100, 30, register_pipeline, policy, 11);
+
+        const Genome first_result = first.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+        const Genome second_result = second.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+        EXPECT_EQ(first_result.getEncodedGenome(), second_result.getEncodedGenome());
+        EXPECT_EQ(first.best_island(), second.best_island());
+        EXPECT_EQ(first.statistics().evaluations, second.statistics().evaluations);
+    }
+}
+
+TEST(IslandOptimizerTest, FindsOptimum) {
+    const LinearTransformer transformer{0.0, 1.0};
+    for (const bool synchronous : {true, false}) {
+        IslandOptimizer optimizer(3, 200, 40, register_pipeline, MigrationPolicy{4, 2, MigrationTopology::RING, synchronous}, 5);
+        const Genome result = optimizer.optimize(peak_fitness, transformer);
+        EXPECT_NEAR(transformer(result.getDecodedGenome()), 0.3, 1e-2);
+        EXPECT_GT(optimizer.statistics().evaluations, 3 * 200u);
+    }
+}
+
+TEST(IslandOptimizerTest, SingleIslandMatchesGeneticOptimizer) {
+    // without neighbours an island is a plain GeneticOptimizer seeded from the island seed
+    IslandOptimizer islands(1, 100, 20, register_pipeline, MigrationPolicy{}, 9);
+    GeneticOptimizer optimizer(100, 20, RandomSource(9).fork(0).key());
+    register_pipeline(optimizer);
+
+    const Genome island_result = islands.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    const Genome result = optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_EQ(island_result.getEncodedGenome(), result.getEncodedGenome());
+}
+
+TEST(IslandOptimizerTest, SynchronousIslandsRejectStopConditions) {
+    const auto stopping_pipeline = [](GeneticOptimizer& island) {
+        register_pipeline(island);
+        island.add_stop_condition(std::make_unique<FitnessTarget>(0.99));
+    };
+
+    IslandOptimizer synchronous(3, 50, 200, stopping_pipeline, MigrationPolicy{4, 2, MigrationTopology::RING, true}, 5);
+    EXPECT_THROW(synchronous.optimize(peak_fitness, LinearTransformer{0.0, 1.0}), std::runtime_error);
+
+    // asynchronous islands stop on their own
+    IslandOptimizer asynchronous(3, 50, 200, stopping_pipeline, MigrationPolicy{4, 2, MigrationTopology::RING, false}, 5);
+    asynchronous.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_LT(asynchronous.statistics().evaluations, 3 * 50u * 201);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <local_search.h>
+#include "test_helpers.h"
+
+#include <filesystem>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+constexpr size_t variables = 3;
+using Transformer = BoxTransformer<variables, 24>;
+
+GeneticOptimizer genetic_algorithm(size_t generations, uint64_t seed, std::unique_ptr<PopulationPass> local_search) {
+    GeneticOptimizer optimizer(50, generations, seed);
+    if (local_search)
+        optimizer.register_pass(std::move(local_search));
+    optimizer.register_pass(std::make_unique<ElitismPass>(1));
+    optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(0.01));
+    return optimizer;
+}
+
+}
+
+TEST(LocalSearchTest, ClimbsTheFittestWithinBudget) {
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+    Population population(40, Transformer::layout());
+    RandomEngine engine = RandomSource(3).stream(0);
+    for (size_t i = 0; i < population.size(); ++i) {
+        for (auto& word : population.genome(i))
+            word = engine() & population.layout().mask();
+    }
+    evaluator.evaluate(population);
+    const std::vector<double> before(population.fits().begin(), population.fits().end());
+    GenerationArena arena;
+    arena.ranking().rank(population, 3, 0);
+    const std::vector<size_t> fittest(arena.ranking().order().begin(), arena.ranking().order().begin() + 3);
+
+    const size_t evaluations = evaluator.statistics().evaluations;
+    LocalSearchPass(3, 5, 100).run(population, PassContext{0, RandomSource(1), &arena, &evaluator});
+
+    EXPECT_LE(evaluator.statistics().evaluations - evaluations, 100u);
+    EXPECT_GT(evaluator.statistics().evaluations - evaluations, 0u);
+    for (size_t i = 0; i < population.size(); ++i) {
+        const bool climbed = std::find(fittest.begin(), fittest.end(), i) != fittest.end();
+        if (climbed)
+            EXPECT_GE(population.fits()[i], before[i]);
+        else
+            EXPECT_EQ(population.fits()[i], before[i]);
+        EXPECT_FALSE(population.is_dirty(i));
+    }
+    EXPECT_GT(population.fits()[fittest.front()], before[fittest.front()]);
+
+    // the fits it reports are the fits of the genomes it moved to
+    Population check(population.size(), population.layout());
+    check.gather(population, arena.ranking().order());
+    check.mark_all_dirty();
+    evaluator.evaluate(check);
+    for (size_t i = 0; i < population.size(); ++i)
+        EXPECT_EQ(check.fits()[i], population.fits()[arena.ranking().order()[i]]);
+}
+
+TEST(LocalSearchTest, BudgetBelowElitesLeavesClimbersUnvisited) {
+    // no neighbour ever improves, so every climber that got one stops
+    FitnessEvaluator evaluator([](std::span<const double>, std::span<double> fits) {
+        std::fill(fits.begin(), fits.end(), 0.0);
+    }, Transformer(-5.0, 5.0));
+    Population population(4, Transformer::layout());
+    for (size_t i = 0; i < population.size(); ++i) {
+        for (auto& word : population.genome(i))
+            word = i;
+    }
+    evaluator.evaluate(population);
+
+    // two proposals per generation for four climbers: the two left without one climb next
+    GenerationArena arena;
+    PassState state;
+    const LocalSearchPass local_search(4, 8, 2);
+    std::vector<size_t> evaluations;
+    for (size_t generation = 0; generation < 3; ++generation) {
+        const size_t before = evaluator.statistics().evaluations;
+        local_search.run(population, PassContext{generation, RandomSource(1).fork(generation), &arena, &evaluator, &state});
+        evaluations.push_back(evaluator.statistics().evaluations - before);
+    }
+    EXPECT_EQ(evaluations, (std::vector<size_t>{2, 2, 0}));
+    EXPECT_EQ(state.words.size(), 4u);
+}
+
+TEST(LocalSearchTest, ResumedRunRemembersTheOptima) {
+    FitnessEvaluator evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+    GeneticOptimizer uninterrupted = genetic_algorithm(40, 7, std::make_unique<LocalSearchPass>(3, 4, 24));
+    uninterrupted.optimize(evaluator);
+    EXPECT_FALSE(uninterrupted.pass_state(0).words.empty());
+
+    const std::string path = (std::filesystem::temp_directory_path() / "dl_local_search_resume.bin").string();
+    {
+        FitnessEvaluator first_evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+        GeneticOptimizer first = genetic_algorithm(40, 7, std::make_unique<LocalSearchPass>(3, 4, 24));
+        first.start(first_evaluator);
+        while (first.generation() < 25)
+            first.step(first_evaluator);
+        first.save_checkpoint(path, first_evaluator);
+    }
+
+    FitnessEvaluator resumed_evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+    GeneticOptimizer resumed = genetic_algorithm(40, 7, std::make_unique<LocalSearchPass>(3, 4, 24));
+    resumed.resume(resumed_evaluator, Checkpoint(path));
+    while (!resumed.finished())
+        resumed.step(resumed_evaluator);
+    resumed.finish(resumed_evaluator);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(resumed.pass_state(0), uninterrupted.pass_state(0));
+    EXPECT_EQ(resumed.statistics().evaluations, uninterrupted.statistics().evaluations);
+    const auto expected = uninterrupted.population().genomes();
+    const auto genomes = resumed.population().genomes();
+    EXPECT_TRUE(std::equal(genomes.begin(), genomes.end(), expected.begin(), expected.end()));
+}
+
+TEST(LocalSearchTest, NeedsTheEvaluator) {
+    Population population(10);
+    EXPECT_THROW(LocalSearchPass().run(population, PassContext{0, RandomSource(1)}), std::runtime_error);
+    EXPECT_THROW(LocalSearchPass(4, 0), std::runtime_error);
+}
+
+TEST(LocalSearchTest, RefinesTheGeneticAlgorithm) {
+    FitnessEvaluator plain_evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+    GeneticOptimizer plain = genetic_algorithm(100, 5, nullptr);
+    plain.optimize(plain_evaluator);
+
+    FitnessEvaluator memetic_evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+    GeneticOptimizer memetic = genetic_algorithm(100, 5, std::make_unique<LocalSearchPass>(2, 8, 32));
+    memetic.optimize(memetic_evaluator);
+
+    // at most 32 more evaluations per generation, counted in the statistics
+    EXPECT_LE(memetic.statistics().evaluations, plain.statistics().evaluations + 100 * 32);
+    EXPECT_GT(memetic.statistics().evaluations, plain.statistics().evaluations);
+    EXPECT_GT(memetic.best_fit(), plain.best_fit());
+    EXPECT_GT(memetic.best_fit(), -1e-6);
+}
+
+TEST(LocalSearchTest, SameResultForAnyThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    std::vector<std::vector<Genome::GenomeType>> results;
+    for (const int threads : {1, 3}) {
+        omp_set_num_threads(threads);
+        FitnessEvaluator evaluator = sphere_evaluator<variables, 24>(-5.0, 5.0);
+        GeneticOptimizer optimizer = genetic_algorithm(20, 9, std::make_unique<LocalSearchPass>(5, 4, 60));
+        optimizer.optimize(evaluator);
+        const auto genomes = optimizer.population().genomes();
+        results.emplace_back(genomes.begin(), genomes.end());
+    }
+    omp_set_num_threads(previous_threads);
+
+    EXPECT_EQ(results[0], results[1]);
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <multi_objective.h>
+#include <differential_evolution.h>
+#include <local_search.h>
+
+#include <cmath>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+// rows of `count` values on a coarse grid, so that ties and duplicates occur
+std::vector<double> random_points(size_t size, size_t count, uint64_t seed, size_t levels) {
+    std::vector<double> points(size * count);
+    RandomEngine engine = RandomSource(seed).stream(0);
+    for (double& value : points)
+        value = static_cast<double>(engine.bounded(levels));
+    return points;
+}
+
+// reference: Deb's O(M N^2) peeling of fronts
+std::vector<uint32_t> naive_fronts(std::span<const double> points, size_t count) {
+    const size_t size = points.size() / count;
+    const auto dominates = [&](size_t q, size_t p) {
+        bool better = false;
+        for (size_t j = 0; j < count; ++j) {
+            if (points[q * count + j] < points[p * count + j])
+                return false;
+            better |= points[q * count + j] > points[p * count + j];
+        }
+        return better;
+    };
+
+    std::vector<uint32_t> fronts(size);
+    std::vector<size_t> dominators(size, 0);
+    for (size_t p = 0; p < size; ++p) {
+        for (size_t q = 0; q < size; ++q)
+            dominators[p] += dominates(q, p);
+    }
+    std::vector<size_t> current;
+    for (size_t p = 0; p < size; ++p) {
+        if (dominators[p] == 0)
+            current.push_back(p);
+    }
+    for (uint32_t front = 0; !current.empty(); ++front) {
+        std::vector<size_t> next;
+        for (const size_t q : current) {
+            fronts[q] = front;
+            for (size_t p = 0; p < size; ++p) {
+                if (dominates(q, p) && --dominators[p] == 0)
+                    next.push_back(p);
+            }
+        }
+        current = std::move(next);
+    }
+    return fronts;
+}
+
+// ZDT1 with its objectives negated: the front is f2 = 1 - sqrt(f1), f1 in [0, 1]
+void negative_zdt1(std::span<const double> x, std::span<double> objectives) {
+    constexpr size_t variables = 5;
+    for (size_t i = 0; i < objectives.size() / 2; ++i) {
+        const double* xi = x.data() + i * variables;
+        double sum = 0;
+        for (size_t v = 1; v < variables; ++v)
+            sum += xi[v];
+        const double g = 1 + 9 * sum / (variables - 1);
+        objectives[2 * i] = -xi[0];
+        objectives[2 * i + 1] = -g * (1 - std::sqrt(xi[0] / g));
+    }
+}
+
+}
+
+TEST(ParetoRankingTest, MatchesNaiveSorting) {
+    const int previous_threads = omp_get_max_threads();
+    for (const size_t count : {1, 2, 3, 5}) {
+        for (const size_t levels : {4, 1000}) {
+            // more points than the serial sort threshold
+            const auto points = random_points(4500, count, count * levels, levels);
+            const auto expected = naive_fronts(points, count);
+            for (const int threads : {1, 4}) {
+                omp_set_num_threads(threads);
+                ParetoRanking ranking;
+                ranking.rank(points, count);
+                ASSERT_TRUE(std::equal(expected.begin(), expected.end(), ranking.fronts().begin()))
+                    << count << " objectives, " << levels << " levels, " << threads << " threads";
+            }
+        }
+    }
+    omp_set_num_threads(previous_threads);
+}
+
+TEST(ParetoRankingTest, CrowdingDistancesAndOrder) {
+    // front 0: (0, 4), (1, 3), (3, 1), (4, 0); front 1: (0, 3), (2, 1); front 2: (0, 0)
+    const std::vector<double> points = {1, 3, 0, 0, 4, 0, 0, 3, 3, 1, 2, 1, 0, 4};
+    ParetoRanking ranking;
+    ranking.rank(points, 2);
+
+    EXPECT_EQ(ranking.front_count(), 3u);
+    const std::vector<uint32_t> fronts = {0, 2, 0, 1, 0, 1, 0};
+    EXPECT_TRUE(std::equal(fronts.begin(), fronts.end(), ranking.fronts().begin()));
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    EXPECT_EQ(ranking.crowding()[2], infinity);
+    EXPECT_EQ(ranking.crowding()[6], infinity);
+    // (1, 3) between (0, 4) and (3, 1): 3 / 4 + 3 / 4; (3, 1) between (1, 3) and (4, 0): 3 / 4 + 3 / 4
+    EXPECT_DOUBLE_EQ(ranking.crowding()[0], 1.5);
+    EXPECT_DOUBLE_EQ(ranking.crowding()[4], 1.5);
+    EXPECT_EQ(ranking.crowding()[1], infinity);
+
+    const std::vector<size_t> order = {2, 6, 0, 4, 3, 5, 1};
+    EXPECT_TRUE(std::equal(order.begin(), order.end(), ranking.order().begin()));
+    EXPECT_GT(ranking.fit(0), ranking.fit(3));
+    EXPECT_GT(ranking.fit(2), ranking.fit(0));
+}
+
+TEST(MultiObjectiveOptimizerTest, ApproachesTheZdt1Front) {
+    MultiObjectiveOptimizer optimizer(200, 150, 2, 3);
+    const ParetoFront& front = optimizer.optimize(negative_zdt1, BoxTransformer<5, 20>(0.0, 1.0));
+
+    // the initial population and at most 151 generations of offspring
+    EXPECT_LT(optimizer.evaluations(), 200u * 152);
+    EXPECT_GT(optimizer.evaluations(), 200u * 2);
+    ASSERT_GT(front.size(), 50u);
+    for (size_t i = 0; i < front.size(); ++i) {
+        const auto values = front.objective_values(i);
+        EXPECT_NEAR(-values[1], 1 - std::sqrt(-values[0]), 0.1);
+        // by descending first objective, none dominating another
+        if (i > 0) {
+            EXPECT_LE(values[0], front.objective_values(i - 1)[0]);
+            EXPECT_GT(values[1], front.objective_values(i - 1)[1]);
+        }
+    }
+    // spread over the whole front
+    EXPECT_GT(front.objective_values(0)[0], -0.05);
+    EXPECT_LT(front.objective_values(front.size() - 1)[0], -0.9);
+}
+
+TEST(MultiObjectiveOptimizerTest, RejectsPassesNeedingEvaluationHooks) {
+    MultiObjectiveOptimizer optimizer(20, 5, 2, 1);
+    EXPECT_THROW(optimizer.register_pass(std::make_unique<DifferentialEvolutionPass>()), std::runtime_error);
+    EXPECT_THROW(optimizer.register_pass(std::make_unique<LocalSearchPass>()), std::runtime_error);
+    EXPECT_THROW(optimizer.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(0.3, 0.3)), std::runtime_error);
+    optimizer.register_pass(std::make_unique<MutationPass>(0.1));
+}
+
+TEST(MultiObjectiveOptimizerTest, UnchangedOffspringAreNotEvaluated) {
+    MultiObjectiveOptimizer optimizer(100, 10, 2, 5);
+    optimizer.register_pass(std::make_unique<MutationPass>(0.0));
+    optimizer.optimize(negative_zdt1, BoxTransformer<5, 20>(0.0, 1.0));
+
+    // every offspring is a clone of its parent, the parents stay as they were
+    EXPECT_EQ(optimizer.evaluations(), 100u);
+    EXPECT_EQ(optimizer.population().size(), 100u);
+    std::vector<std::vector<Genome::GenomeType>> genomes;
+    for (size_t i = 0; i < optimizer.population().size(); ++i)
+        genomes.emplace_back(optimizer.population().genome(i).begin(), optimizer.population().genome(i).end());
+    std::sort(genomes.begin(), genomes.end());
+    EXPECT_EQ(std::unique(genomes.begin(), genomes.end()), genomes.end());
+}
+
+TEST(MultiObjectiveOptimizerTest, SameFrontForAnyThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    std::vector<std::vector<double>> results;
+    for (const int threads : {1, 3}) {
+        omp_set_num_threads(threads);
+        // a scalar variable with a custom pipeline, three objectives
+        MultiObjectiveOptimizer optimizer(3000, 5, 3, 11);
+        optimizer.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+        optimizer.register_pass(std::make_unique<CrossoverPass>(CrossoverPass::UNIFORM_CROSSOVER));
+        optimizer.register_pass(std::make_unique<MutationPass>(0.02));
+        const ParetoFront& front = optimizer.optimize([](std::span<const double> x, std::span<double> objectives) {
+            for (size_t i = 0; i < x.size(); ++i) {
+                objectives[3 * i] = -x[i] * x[i];
+                objectives[3 * i + 1] = -(x[i] - 1) * (x[i] - 1);
+                objectives[3 * i + 2] = std::sin(3 * x[i]);
+            }
+        }, LinearTransformer{-2.0, 2.0});
+        results.push_back(front.values);
+    }
+    omp_set_num_threads(previous_threads);
+
+    EXPECT_EQ(results[0], results[1]);
+    EXPECT_FALSE(results[0].empty());
+}
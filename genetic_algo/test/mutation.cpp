@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <bit>
+#include <vector>
+#include <mutation.h>
+
+using namespace dl;
+
+namespace {
+
+double flip_rate(double probability, size_t bits) {
+    const BernoulliMaskGenerator generator(probability);
+    const RandomSource source(probability * 1000);
+    std::vector<uint64_t> words(8);
+
+    size_t flips = 0;
+    const size_t genomes = 20000;
+    for (size_t i = 0; i < genomes; ++i) {
+        std::fill(words.begin(), words.end(), 0);
+        RandomEngine engine = source.stream(i);
+        generator.apply(words, bits, engine);
+        for (const auto word : words)
+            flips += std::popcount(word);
+    }
+    return static_cast<double>(flips) / (genomes * words.size() * bits);
+}
+
+} // namespace
+
+TEST(MutationTest, FlipRateMatchesProbability) {
+    for (const double probability : {0.001, 0.01, 0.05, 0.1, 0.3, 0.5, 0.9}) {
+        const double rate = flip_rate(probability, 64);
+        EXPECT_NEAR(rate, probability, 0.05 * probability + 1e-4) << "p = " << probability;
+    }
+}
+
+TEST(MutationTest, DegenerateProbabilities) {
+    EXPECT_EQ(flip_rate(0.0, 64), 0.0);
+    EXPECT_EQ(flip_rate(1.0, 64), 1.0);
+    EXPECT_EQ(flip_rate(1.0, 10), 1.0);
+}
+
+TEST(MutationTest, OnlyValidBitsFlip) {
+    for (const double probability : {0.01, 0.5, 1.0}) {
+        const BernoulliMaskGenerator generator(probability);
+        RandomEngine engine = RandomSource(1).stream(0);
+        std::vector<uint64_t> words(16, 0);
+        for (size_t i = 0; i < 100; ++i)
+            generator.apply(words, 13, engine);
+        for (const auto word : words)
+            EXPECT_EQ(word >> 13, 0u);
+    }
+}
+
+TEST(MutationTest, ReportsWhetherGenomeChanged) {
+    const BernoulliMaskGenerator generator(0.001);
+    RandomEngine engine = RandomSource(2).stream(0);
+    size_t changed = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        uint64_t word = 0;
+        const bool reported = generator.apply(std::span<uint64_t>(&word, 1), 64, engine);
+        EXPECT_EQ(reported, word != 0);
+        changed += reported;
+    }
+    // expected 1 - 0.999^64 ~ 6.2%
+    EXPECT_GT(changed, 30u);
+    EXPECT_LT(changed, 100u);
+}
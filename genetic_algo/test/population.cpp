@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <population.h>
+
+using namespace dl;
+
+TEST(PopulationStoreTest, SwarmStateIsOptional) {
+    PopulationStore population(4);
+    EXPECT_TRUE(population.velocities().empty());
+
+    population.assign(0, 42u, 3);
+    population.set_fit(0, 1.5);
+    population.enable_swarm_state();
+    ASSERT_EQ(population.velocities().size(), 4u);
+    EXPECT_EQ(population.best_genomes()[0], 42u);
+
+    population.set_fit(0, 2.5);
+    EXPECT_EQ(population.best_fits()[0], 2.5);
+}
+
+TEST(PopulationStoreTest, GatherCopiesIndividuals) {
+    PopulationStore population(3);
+    for (size_t i = 0; i < population.size(); ++i) {
+        population.assign(i, i + 10, i);
+        population.set_fit(i, static_cast<double>(i));
+    }
+
+    PopulationStore gathered;
+    const std::vector<size_t> indices = {2, 2, 0};
+    gathered.gather(population, indices);
+
+    ASSERT_EQ(gathered.size(), 3u);
+    EXPECT_EQ(gathered.genomes()[0], 12u);
+    EXPECT_EQ(gathered.genomes()[1], 12u);
+    EXPECT_EQ(gathered.generations()[1], 2u);
+    EXPECT_EQ(gathered.fits()[2], 0.0);
+}
+
+TEST(PopulationStoreTest, OffspringRoundTrip) {
+    PopulationStore population(0, GenomeLayout{}, true);
+    Offspring offspring(Genome(7u), 5);
+    offspring.fit = 3.0;
+    offspring.velocity = -1.0;
+    population.push_back(offspring);
+
+    const Offspring copy = population.get(0);
+    EXPECT_EQ(copy.genome.getDecodedGenome(), 7u);
+    EXPECT_EQ(copy.generation, 5u);
+    EXPECT_EQ(copy.fit, 3.0);
+    EXPECT_EQ(copy.velocity, -1.0);
+}
+
+TEST(PopulationStoreTest, SortByFitIsDescendingPermutation) {
+    PopulationStore population(5);
+    const double fits[] = {0.5, 2.0, -1.0, 2.0, 1.0};
+    for (size_t i = 0; i < population.size(); ++i)
+        population.set_fit(i, fits[i]);
+
+    std::vector<size_t> order;
+    sort_by_fit(population, order);
+    EXPECT_EQ(order, (std::vector<size_t>{1, 3, 4, 0, 2}));
+}
+
+TEST(PopulationStoreTest, MultiWordGenomesAreContiguous) {
+    PopulationStore population(2, GenomeLayout{3, 16});
+    ASSERT_EQ(population.genomes().size(), 6u);
+
+    const std::vector<Genome::GenomeType> first = {1, 2, 3}, second = {4, 5, 6};
+    population.assign(0, first, 0);
+    population.assign(1, second, 0);
+    EXPECT_EQ(population.genomes()[3], 4u);
+
+    PopulationStore gathered;
+    const std::vector<size_t> indices = {1};
+    gathered.gather(population, indices);
+    EXPECT_EQ(gathered.layout(), (GenomeLayout{3, 16}));
+    EXPECT_TRUE(std::equal(second.begin(), second.end(), gathered.genome(0).begin()));
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <process_islands.h>
+#include "test_helpers.h"
+
+using namespace dl;
+
+TEST(SharedMemoryTransportTest, ChannelsAreSeparate) {
+    const size_t record_words = migrant_record_words(GenomeLayout{});
+    SharedMemoryTransport transport(3, MigrationTopology::FULLY_CONNECTED, 2, record_words);
+    std::vector<uint64_t> record(record_words);
+
+    encode_migrant(record, 1, 0.5, std::vector<uint64_t>{7});
+    EXPECT_TRUE(transport.send(0, 1, record));
+    encode_migrant(record, 1, 0.25, std::vector<uint64_t>{9});
+    EXPECT_TRUE(transport.send(2, 1, record));
+
+    EXPECT_FALSE(transport.receive(1, 0, record));
+    ASSERT_TRUE(transport.receive(2, 1, record));
+    EXPECT_EQ(decode_migrant(record).genome[0], 9u);
+    ASSERT_TRUE(transport.receive(0, 1, record));
+    EXPECT_DOUBLE_EQ(decode_migrant(record).fit, 0.5);
+    EXPECT_FALSE(transport.receive(0, 1, record));
+}
+
+TEST(ProcessIslandOptimizerTest, MatchesThreadedIslands) {
+    for (const auto topology : {MigrationTopology::RING, MigrationTopology::FULLY_CONNECTED}) {
+        const MigrationPolicy policy{5, 3, topology, true};
+        IslandOptimizer threads(3, 100, 30, register_pipeline, policy, 21);
+        ProcessIslandOptimizer processes(3, 100, 30, register_pipeline, policy, 21);
+
+        const Genome threads_result = threads.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+        const Genome processes_result = processes.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+        EXPECT_EQ(processes_result.getEncodedGenome(), threads_result.getEncodedGenome());
+        EXPECT_EQ(processes.best_island(), threads.best_island());
+        EXPECT_EQ(processes.statistics().evaluations, threads.statistics().evaluations);
+    }
+}
+
+TEST(ProcessIslandOptimizerTest, MultiVariableGenomes) {
+    ProcessIslandOptimizer optimizer(2, 200, 40, register_pipeline, MigrationPolicy{5, 2}, 3);
+    const BoxTransformer<2, 16> transformer(-1.0, 1.0);
+    const auto result = optimizer.optimize([](std::span<const double> x) { return -(x[0] * x[0] + x[1] * x[1]); }, transformer);
+    const auto x = transformer(result);
+    EXPECT_NEAR(x[0], 0.0, 0.05);
+    EXPECT_NEAR(x[1], 0.0, 0.05);
+}
+
+TEST(ProcessIslandOptimizerTest, FailedWorkerIsReported) {
+    ProcessIslandOptimizer optimizer(2, 10, 5, register_pipeline, MigrationPolicy{}, 1);
+    const auto failing_fitness = [](std::span<const double>, std::span<double>) { _exit(3); };
+    EXPECT_THROW(optimizer.optimize(failing_fitness, LinearTransformer{0.0, 1.0}), std::runtime_error);
+}
+
+TEST(ProcessIslandOptimizerTest, WorkerExceptionIsReported) {
+    struct FailingPass : PopulationPass
+    {
+        void run(Population&, const PassContext& context) const override {
+            if (context.generation == 3)
+                throw std::runtime_error("pass failed in generation 3");
+        }
+    };
+    ProcessIslandOptimizer optimizer(2, 10, 5, [](GeneticOptimizer& island) {
+        register_pipeline(island);
+        island.register_pass(std::make_unique<FailingPass>());
+    }, MigrationPolicy{}, 1);
+
+    try {
+        optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+        FAIL() << "the worker exception was not reported";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("pass failed in generation 3"), std::string::npos) << e.what();
+    }
+}
+
+TEST(ProcessIslandOptimizerTest, SynchronousIslandsRejectStopConditions) {
+    ProcessIslandOptimizer optimizer(2, 10, 5, [](GeneticOptimizer& island) {
+        register_pipeline(island);
+        island.add_stop_condition(std::make_unique<Stagnation>(2));
+    }, MigrationPolicy{}, 1);
+    EXPECT_THROW(optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0}), std::runtime_error);
+}
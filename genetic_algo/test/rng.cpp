@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <genetic_optimizer.h>
+
+using namespace dl;
+
+TEST(RandomSourceTest, StreamsAreReproducible) {
+    const RandomSource source(42);
+    RandomEngine first = source.fork(3).stream(7);
+    RandomEngine second = RandomSource(42).fork(3).stream(7);
+    for (size_t i = 0; i < 1000; ++i)
+        EXPECT_EQ(first(), second());
+}
+
+TEST(RandomSourceTest, StreamsAreIndependent) {
+    const RandomSource source(42);
+    RandomEngine first = source.stream(0);
+    RandomEngine second = source.stream(1);
+    RandomEngine other_seed = RandomSource(43).stream(0);
+
+    size_t collisions = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        const auto value = first();
+        collisions += (value == second()) + (value == other_seed());
+    }
+    EXPECT_EQ(collisions, 0u);
+}
+
+TEST(RandomSourceTest, UniformAndBoundedRanges) {
+    RandomEngine engine = RandomSource(1).stream(0);
+    for (size_t i = 0; i < 10000; ++i) {
+        const double u = engine.uniform();
+        EXPECT_GE(u, 0.0);
+        EXPECT_LT(u, 1.0);
+        EXPECT_LT(engine.bounded(17), 17u);
+    }
+}
+
+TEST(RandomSourceTest, OptimizeIsIndependentOfThreadCount) {
+    const auto fitness_function = [](double x) { return 1.0 / (1.0 + (x - 0.3) * (x - 0.3)); };
+    const auto transformer = [](Genome::GenomeType g) {
+        return static_cast<double>(g) / static_cast<double>(Genome::getDistributionMaximumValue());
+    };
+
+    auto run = [&](int threads) {
+        omp_set_num_threads(threads);
+        GeneticOptimizer optimizer(64, 10, 1234);
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new SelectionPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new CrossoverPass()));
+        optimizer.register_pass(std::unique_ptr<PopulationPass>(new MutationPass(0.05)));
+        return optimizer.optimize(fitness_function, transformer).getEncodedGenome();
+    };
+
+    const auto single_threaded = run(1);
+    EXPECT_EQ(single_threaded, run(4));
+    EXPECT_EQ(single_threaded, run(3));
+}
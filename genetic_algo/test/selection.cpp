@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <pass.h>
+
+using namespace dl;
+
+class SelectionFixture : public ::testing::Test
+{
+protected:
+    Population m_population;
+
+    void SetUp() override {
+        m_population.resize(1000);
+        for (size_t i = 0; i < m_population.size(); ++i) {
+            m_population.assign(i, Genome(i).getEncodedGenome(), 0);
+            m_population.set_fit(i, static_cast<double>(i) - 500.0);
+        }
+    }
+
+    double select_mean_fit(SelectionPass::SelectionStrategy strategy) {
+        SelectionPass pass(strategy, 0.5, 4);
+        Population population = m_population;
+        pass.run(population, PassContext{0, RandomSource(7)});
+        EXPECT_EQ(population.size(), m_population.size() / 2);
+
+        double mean = 0.0;
+        for (const double fit : population.fits())
+            mean += fit;
+        return mean / population.size();
+    }
+};
+
+TEST_F(SelectionFixture, StrategiesPreferFitterIndividuals) {
+    // mean of the initial population is -0.5
+    EXPECT_GT(select_mean_fit(SelectionPass::ROULETTE_WHEEL_SELECTION), 50.0);
+    EXPECT_GT(select_mean_fit(SelectionPass::RANK_SELECTION), 50.0);
+    EXPECT_GT(select_mean_fit(SelectionPass::TOURNAMENT_SELECTION), 200.0);
+}
+
+TEST_F(SelectionFixture, SelectionIsReproducible) {
+    SelectionPass pass(SelectionPass::RANK_SELECTION);
+    Population first = m_population, second = m_population;
+    pass.run(first, PassContext{3, RandomSource(11)});
+    pass.run(second, PassContext{3, RandomSource(11)});
+
+    ASSERT_EQ(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); ++i)
+        EXPECT_EQ(first.genomes()[i], second.genomes()[i]);
+}
+
+TEST_F(SelectionFixture, InvalidStrategyThrows) {
+    SelectionPass pass(SelectionPass::INVALID_SELECTION);
+    EXPECT_THROW(pass.run(m_population, PassContext{0, RandomSource(0)}), std::runtime_error);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <static_optimizer.h>
+#include <local_search.h>
+
+#include <cmath>
+#include <omp.h>
+
+using namespace dl;
+
+static_assert(IndividualPass<CrossoverPass> && IndividualPass<MutationPass>);
+static_assert(!IndividualPass<SelectionPass> && !IndividualPass<ElitismPass>);
+static_assert(overrides_complete<ElitismPass> && !overrides_complete<CrossoverPass> && !overrides_complete<MutationPass>);
+static_assert(LocalSearchPass::needs_evaluator && !SelectionPass::needs_evaluator);
+
+namespace {
+
+double negative_rastrigin(std::span<const double> x) {
+    double sum = 10.0 * x.size();
+    for (const double xi : x)
+        sum += xi * xi - 10.0 * std::cos(2.0 * 3.141592653589793 * xi);
+    return -sum;
+}
+
+void expect_same_population(const Population& lhs, const Population& rhs) {
+    ASSERT_EQ(lhs.size(), rhs.size());
+    EXPECT_TRUE(std::equal(lhs.genomes().begin(), lhs.genomes().end(), rhs.genomes().begin()));
+    EXPECT_TRUE(std::equal(lhs.fits().begin(), lhs.fits().end(), rhs.fits().begin()));
+}
+
+}
+
+TEST(StaticGeneticOptimizerTest, MatchesTheRuntimePipeline) {
+    const int previous_threads = omp_get_max_threads();
+    const BoxTransformer<3, 20> transformer(-5.12, 5.12);
+    for (const int threads : {1, 4}) {
+        omp_set_num_threads(threads);
+        GeneticOptimizer runtime(200, 40, 7);
+        runtime.register_pass(std::make_unique<ElitismPass>(2));
+        runtime.register_pass(std::make_unique<SelectionPass>(SelectionPass::TOURNAMENT_SELECTION));
+        runtime.register_pass(std::make_unique<CrossoverPass>(CrossoverPass::UNIFORM_CROSSOVER));
+        runtime.register_pass(std::make_unique<MutationPass>(0.02));
+        FitnessEvaluator evaluator(MultiFitnessFunction(negative_rastrigin), transformer);
+        runtime.optimize(evaluator);
+
+        StaticGeneticOptimizer fused(200, 40, 7, negative_rastrigin, transformer, ElitismPass(2),
+            SelectionPass(SelectionPass::TOURNAMENT_SELECTION), CrossoverPass(CrossoverPass::UNIFORM_CROSSOVER), MutationPass(0.02));
+        fused.optimize();
+
+        expect_same_population(runtime.population(), fused.population());
+        EXPECT_EQ(runtime.best_fit(), fused.best_fit());
+        // the elites written back by complete() are not evaluated again
+        EXPECT_EQ(fused.evaluations(), runtime.statistics().evaluations);
+    }
+    omp_set_num_threads(previous_threads);
+}
+
+TEST(StaticGeneticOptimizerTest, ScalarObjectiveAndNonIndividualTail) {
+    const auto fitness = [](double x) { return -x * x * std::sin(x); };
+    const LinearTransformer transformer{0.0, 3.0};
+
+    // the swarm pass ends the pipeline, so the crossover and mutation group is evaluated separately
+    GeneticOptimizer runtime(100, 30, 11);
+    runtime.register_pass(std::make_unique<SelectionPass>());
+    runtime.register_pass(std::make_unique<CrossoverPass>());
+    runtime.register_pass(std::make_unique<MutationPass>(0.01));
+    runtime.register_pass(std::make_unique<ParticleSwarmOptimizationPass>(0.3, 0.3));
+    FitnessEvaluator evaluator(fitness, transformer);
+    runtime.optimize(evaluator);
+
+    StaticGeneticOptimizer fused(100, 30, 11, fitness, transformer, SelectionPass(), CrossoverPass(), MutationPass(0.01),
+        ParticleSwarmOptimizationPass(0.3, 0.3));
+    const auto best = fused.optimize();
+
+    expect_same_population(runtime.population(), fused.population());
+    EXPECT_EQ(best[0], runtime.population().genome(runtime.order().front())[0]);
+    EXPECT_GT(fused.evaluations(), 100u);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <steady_state.h>
+
+#include <atomic>
+#include <chrono>
+
+using namespace dl;
+
+TEST(WorkStealingSchedulerTest, RunsNestedTasks) {
+    WorkStealingScheduler scheduler(4);
+    std::atomic<size_t> done{0};
+    for (size_t i = 0; i < 8; ++i) {
+        scheduler.submit([&] {
+            for (size_t j = 0; j < 100; ++j)
+                scheduler.submit([&] { done++; });
+            done++;
+        });
+    }
+    scheduler.wait();
+    EXPECT_EQ(done.load(), 8u * 101u);
+}
+
+TEST(WorkStealingSchedulerTest, IdleWorkersSteal) {
+    // every task is spawned from the deque of a single worker
+    WorkStealingScheduler scheduler(4);
+    scheduler.submit([&] {
+        for (size_t j = 0; j < 64; ++j)
+            scheduler.submit([] { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+    });
+    scheduler.wait();
+    EXPECT_GT(scheduler.steals(), 0u);
+}
+
+TEST(WorkStealingSchedulerTest, RethrowsTaskException) {
+    WorkStealingScheduler scheduler(2);
+    scheduler.submit([] { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(scheduler.wait(), std::runtime_error);
+
+    // the scheduler stays usable
+    std::atomic<bool> ran{false};
+    scheduler.submit([&] { ran = true; });
+    scheduler.wait();
+    EXPECT_TRUE(ran.load());
+}
+
+TEST(SteadyStateOptimizerTest, FindsOptimum) {
+    const auto fitness_function = [](double x) { return 1.0 / (1.0 + (x - 0.3) * (x - 0.3)); };
+    const LinearTransformer transformer{0.0, 1.0};
+
+    SteadyStateOptimizer optimizer(50, 5000, 3, 4);
+    optimizer.set_crossover(std::make_unique<CrossoverPass>());
+    optimizer.set_mutation(std::make_unique<MutationPass>(0.02));
+    const Genome result = optimizer.optimize(fitness_function, transformer);
+
+    EXPECT_NEAR(transformer(result.getDecodedGenome()), 0.3, 1e-2);
+    EXPECT_EQ(optimizer.statistics().evaluations, 5000u);
+    EXPECT_GT(optimizer.replacements(), 0u);
+}
+
+TEST(SteadyStateOptimizerTest, VariableCostMultiVariable) {
+    // cost varies tenfold between individuals
+    const auto fitness_function = [](std::span<const double> x) {
+        std::this_thread::sleep_for(std::chrono::microseconds(x[0] > 0 ? 100 : 10));
+        return -(x[0] * x[0] + x[1] * x[1]);
+    };
+    const BoxTransformer<2, 16> transformer(-1.0, 1.0);
+
+    SteadyStateOptimizer optimizer(32, 1500, 5, 4);
+    optimizer.set_crossover(std::make_unique<CrossoverPass>());
+    optimizer.set_mutation(std::make_unique<MutationPass>(0.05));
+    const auto x = transformer(optimizer.optimize(fitness_function, transformer));
+
+    EXPECT_NEAR(x[0], 0.0, 0.1);
+    EXPECT_NEAR(x[1], 0.0, 0.1);
+    EXPECT_EQ(optimizer.statistics().evaluations, 1500u);
+}
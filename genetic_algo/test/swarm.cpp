@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include <swarm.h>
+
+#include <cmath>
+#include <omp.h>
+
+using namespace dl;
+
+namespace {
+
+// maximized at x = 0.5 in every dimension
+void negative_sphere(std::span<const double> x, std::span<double> fits) {
+    const size_t dimensions = x.size() / fits.size();
+    for (size_t i = 0; i < fits.size(); ++i) {
+        double sum = 0;
+        for (size_t d = 0; d < dimensions; ++d)
+            sum += (x[i * dimensions + d] - 0.5) * (x[i * dimensions + d] - 0.5);
+        fits[i] = -sum;
+    }
+}
+
+}
+
+TEST(SwarmOptimizerTest, ConvergesOnSphere) {
+    const std::vector<double> lower(5, -10.0), upper(5, 10.0);
+    for (const SwarmTopology topology : {SwarmTopology::GLOBAL, SwarmTopology::RING, SwarmTopology::VON_NEUMANN}) {
+        SwarmParameters parameters;
+        parameters.topology = topology;
+        SwarmOptimizer optimizer(100, 300, parameters, 5);
+        const auto best = optimizer.optimize(negative_sphere, lower, upper);
+
+        ASSERT_EQ(best.size(), 5u);
+        for (const double x : best)
+            EXPECT_NEAR(x, 0.5, 1e-3);
+        EXPECT_EQ(optimizer.evaluations(), 100u * 301u);
+    }
+}
+
+TEST(SwarmOptimizerTest, ConvergesOnRosenbrock) {
+    const MultiFitnessFunction rosenbrock = [](std::span<const double> x) {
+        return -(100.0 * (x[1] - x[0] * x[0]) * (x[1] - x[0] * x[0]) + (1.0 - x[0]) * (1.0 - x[0]));
+    };
+    SwarmOptimizer optimizer(50, 1000, {}, 11);
+    const auto best = optimizer.optimize(rosenbrock, std::vector<double>{-2.0, -2.0}, std::vector<double>{2.0, 2.0});
+
+    EXPECT_NEAR(best[0], 1.0, 1e-2);
+    EXPECT_NEAR(best[1], 1.0, 1e-2);
+    EXPECT_GT(optimizer.best_fit(), -1e-4);
+}
+
+TEST(SwarmOptimizerTest, SameResultForAnyThreadCount) {
+    const int previous_threads = omp_get_max_threads();
+    const std::vector<double> lower(3, -1.0), upper(3, 2.0);
+    SwarmParameters parameters;
+    parameters.topology = SwarmTopology::RING;
+
+    std::vector<std::vector<double>> positions;
+    for (const int threads : {1, 2, 4}) {
+        omp_set_num_threads(threads);
+        // more particles than one block, so the blocks are split between threads
+        SwarmOptimizer optimizer(300, 20, parameters, 3);
+        optimizer.optimize(negative_sphere, lower, upper);
+        positions.emplace_back(optimizer.positions().begin(), optimizer.positions().end());
+    }
+    omp_set_num_threads(previous_threads);
+
+    EXPECT_EQ(positions[0], positions[1]);
+    EXPECT_EQ(positions[0], positions[2]);
+}
+
+TEST(SwarmOptimizerTest, StaysInsideTheBox) {
+    // maximized outside the box, particles pile up on the upper bound
+    const BatchFitnessFunction outside = [](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i)
+            fits[i] = x[2 * i] + x[2 * i + 1];
+    };
+    SwarmParameters parameters;
+    parameters.max_velocity = 0.1;
+    SwarmOptimizer optimizer(40, 0, parameters, 8);
+    const std::vector<double> lower{0.0, -5.0}, upper{1.0, 5.0};
+    optimizer.start(outside, lower, upper);
+    for (size_t i = 0; i < 50; ++i) {
+        optimizer.step();
+        const auto positions = optimizer.positions(), velocities = optimizer.velocities();
+        for (size_t k = 0; k < positions.size(); ++k) {
+            ASSERT_GE(positions[k], lower[k % 2]);
+            ASSERT_LE(positions[k], upper[k % 2]);
+            ASSERT_LE(std::abs(velocities[k]), parameters.max_velocity * (upper[k % 2] - lower[k % 2]) + 1e-12);
+        }
+    }
+    EXPECT_DOUBLE_EQ(optimizer.best_fit(), 6.0);
+}
+
+TEST(SwarmTopologyTest, GuidesAreTheBestNeighbours) {
+    const std::vector<double> best_fits{0, 5, 1, 2, 9, 3, 3, 0, 4};
+    std::vector<size_t> guides(best_fits.size());
+
+    swarm_guides(best_fits, SwarmTopology::GLOBAL, 1, guides);
+    EXPECT_EQ(guides, std::vector<size_t>(best_fits.size(), 4));
+
+    swarm_guides(best_fits, SwarmTopology::RING, 1, guides);
+    EXPECT_EQ(guides, (std::vector<size_t>{1, 1, 1, 4, 4, 4, 5, 8, 8}));
+
+    // 3 x 3 grid: neighbours i +- 1 and i +- 3
+    swarm_guides(best_fits, SwarmTopology::VON_NEUMANN, 1, guides);
+    EXPECT_EQ(guides, (std::vector<size_t>{1, 4, 1, 4, 4, 4, 5, 4, 8}));
+
+    EXPECT_EQ(best_particle(std::vector<double>{1, 7, 3, 7}), 1u);
+}
+
+TEST(SwarmPassTest, ImprovesTheGeneticPipeline) {
+    const BoxTransformer<4, 16> transformer(-5.0, 5.0);
+    FitnessEvaluator evaluator(MultiFitnessFunction([](std::span<const double> x) {
+        double sum = 0;
+        for (const double value : x)
+            sum += (value - 1.0) * (value - 1.0);
+        return -sum;
+    }), transformer);
+
+    GeneticOptimizer optimizer(200, 60, 4);
+    optimizer.register_pass(std::make_unique<ElitismPass>(2));
+    optimizer.register_pass(std::make_unique<SwarmPass>());
+    const auto result = transformer(MultiGenome<4, 16>::fromEncodedGenome(optimizer.optimize(evaluator)));
+
+    EXPECT_GT(optimizer.best_fit(), -1e-2);
+    for (const double x : result)
+        EXPECT_NEAR(x, 1.0, 0.05);
+}
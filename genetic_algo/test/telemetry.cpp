@@ -0,0 +1,107 @@
+#define DL_COUNT_ALLOCATIONS
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include "test_helpers.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace dl;
+
+namespace {
+
+size_t count(const std::string& text, const std::string& pattern) {
+    size_t occurrences = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        occurrences++;
+    return occurrences;
+}
+
+}
+
+TEST(TelemetryTest, DisabledRecordsNothing) {
+    GeneticOptimizer optimizer(100, 10, 1);
+    register_pipeline(optimizer);
+    optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_TRUE(optimizer.telemetry().events().empty());
+}
+
+TEST(TelemetryTest, RecordsPassesEvaluationsAndGenerations) {
+    GeneticOptimizer optimizer(100, 10, 1);
+    register_pipeline(optimizer);
+    optimizer.telemetry().set_enabled(true);
+    optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+
+    size_t passes = 0, generations = 0, evaluations = 0;
+    for (const TelemetryEvent& event : optimizer.telemetry().events()) {
+        passes += event.kind == TelemetryEvent::PASS;
+        if (event.kind == TelemetryEvent::EVALUATION)
+            evaluations += event.evaluations;
+        if (event.kind == TelemetryEvent::GENERATION) {
+            EXPECT_EQ(event.generation, generations++);
+            EXPECT_GE(event.best, event.mean);
+            EXPECT_GE(event.diversity, 0.0);
+            EXPECT_LE(event.diversity, 1.0);
+        }
+    }
+    // generations 0 to 10, three passes each
+    EXPECT_EQ(generations, 11u);
+    EXPECT_EQ(passes, 33u);
+    EXPECT_EQ(evaluations, optimizer.statistics().evaluations);
+
+    std::ostringstream json, trace;
+    optimizer.telemetry().write_json(json);
+    optimizer.telemetry().write_chrome_trace(trace);
+    EXPECT_EQ(count(json.str(), "\"name\":\"selection\""), 11u);
+    EXPECT_EQ(count(trace.str(), "\"ph\":\"X\""), 33u + 11u + 12u);
+    EXPECT_EQ(count(trace.str(), "\"ph\":\"C\""), 11u);
+}
+
+TEST(TelemetryTest, ThreadsGetTheirOwnRings) {
+    Telemetry telemetry(4);
+    telemetry.set_enabled(true);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 3; ++t) {
+        threads.emplace_back([&telemetry, t] {
+            for (uint64_t i = 0; i < 10; ++i)
+                telemetry.record(TelemetryEvent{TelemetryEvent::PASS, 0, "test", t, i, 1, 0, 0, 0, 0, 0});
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // every ring keeps its latest 4 events
+    const auto events = telemetry.events();
+    ASSERT_EQ(events.size(), 12u);
+    std::vector<size_t> per_thread(3, 0);
+    for (const TelemetryEvent& event : events) {
+        EXPECT_GE(event.start, 6u);
+        per_thread[event.thread]++;
+    }
+    EXPECT_EQ(per_thread, (std::vector<size_t>{4, 4, 4}));
+}
+
+TEST(TelemetryTest, CountsAllocations) {
+    ASSERT_TRUE(allocation_counting);
+    const uint64_t before = allocations();
+    auto value = std::make_unique<int>(1);
+    EXPECT_EQ(allocations() - before, 1u);
+}
+
+TEST(TelemetryTest, SummarizeDiversity) {
+    Population population(64, GenomeLayout{2, 16});
+    for (size_t i = 0; i < population.size(); ++i) {
+        population.assign(i, std::vector<uint64_t>{0x1234, 0x00ff}, 0);
+        population.set_fit(i, static_cast<double>(i));
+    }
+    PopulationSummary summary = summarize(population);
+    EXPECT_DOUBLE_EQ(summary.best, 63.0);
+    EXPECT_DOUBLE_EQ(summary.mean, 31.5);
+    EXPECT_DOUBLE_EQ(summary.diversity, 0.0);
+
+    // half of the individuals have every bit flipped
+    for (size_t i = 0; i < population.size(); i += 2)
+        population.assign(i, std::vector<uint64_t>{0x1234 ^ 0xffff, 0x00ff ^ 0xffff}, 0);
+    summary = summarize(population);
+    EXPECT_DOUBLE_EQ(summary.diversity, 1.0);
+}
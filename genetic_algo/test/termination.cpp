@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <genetic_optimizer.h>
+#include "test_helpers.h"
+
+#include <thread>
+
+using namespace dl;
+
+TEST(TerminationTest, MaxGenerationsByDefault) {
+    GeneticOptimizer optimizer(50, 5, 1);
+    register_pipeline(optimizer);
+    optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(optimizer.stop_reason(), "max_generations");
+    EXPECT_EQ(optimizer.generation(), 6u);
+}
+
+TEST(TerminationTest, FitnessTarget) {
+    GeneticOptimizer optimizer(200, 1000, 1);
+    register_pipeline(optimizer);
+    optimizer.add_stop_condition(std::make_unique<FitnessTarget>(0.9999));
+    optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(optimizer.stop_reason(), "fitness_target");
+    EXPECT_GE(optimizer.best_fit(), 0.9999);
+    EXPECT_LT(optimizer.generation(), 1000u);
+}
+
+TEST(TerminationTest, StagnationAndDiversityCollapse) {
+    GeneticOptimizer stagnating(100, 100000, 1);
+    register_pipeline(stagnating);
+    stagnating.add_stop_condition(std::make_unique<Stagnation>(20));
+    stagnating.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(stagnating.stop_reason(), "stagnation");
+
+    // without mutation the population converges onto a single genome
+    GeneticOptimizer converging(100, 100000, 1);
+    converging.register_pass(std::make_unique<SelectionPass>());
+    converging.register_pass(std::make_unique<CrossoverPass>());
+    converging.add_stop_condition(std::make_unique<DiversityCollapse>(0.01, 5));
+    converging.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(converging.stop_reason(), "diversity_collapse");
+    EXPECT_EQ(converging.generation() % 5, 0u);
+}
+
+TEST(TerminationTest, EvaluationAndTimeBudgets) {
+    GeneticOptimizer counted(100, 100000, 1);
+    register_pipeline(counted);
+    counted.add_stop_condition(std::make_unique<EvaluationBudget>(1000));
+    counted.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(counted.stop_reason(), "evaluation_budget");
+    EXPECT_GE(counted.statistics().evaluations, 1000u);
+    EXPECT_LT(counted.statistics().evaluations, 1200u);
+
+    GeneticOptimizer timed(100, std::numeric_limits<size_t>::max() - 1, 1);
+    register_pipeline(timed);
+    timed.add_stop_condition(std::make_unique<TimeBudget>(std::chrono::milliseconds(20)));
+    const auto begin = std::chrono::steady_clock::now();
+    timed.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(timed.stop_reason(), "time_budget");
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(2));
+}
+
+TEST(TerminationTest, AllOfNeedsEveryCondition) {
+    std::vector<std::unique_ptr<StopCondition>> conditions;
+    conditions.push_back(std::make_unique<EvaluationBudget>(2000));
+    conditions.push_back(std::make_unique<Stagnation>(1));
+
+    GeneticOptimizer optimizer(100, 100000, 1);
+    register_pipeline(optimizer);
+    optimizer.add_stop_condition(std::make_unique<AllOf>(std::move(conditions)));
+    optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0});
+    EXPECT_STREQ(optimizer.stop_reason(), "all_of");
+    EXPECT_GE(optimizer.statistics().evaluations, 2000u);
+}
+
+TEST(TerminationTest, CancelAndReadBestFromAnotherThread) {
+    GeneticOptimizer optimizer(100, std::numeric_limits<size_t>::max() - 1, 1);
+    register_pipeline(optimizer);
+    CancellationToken token;
+    optimizer.add_stop_condition(std::make_unique<Cancellation>(token));
+
+    std::thread runner([&optimizer] { optimizer.optimize(peak_fitness, LinearTransformer{0.0, 1.0}); });
+
+    // the anytime best only ever improves
+    double last_fit = 0;
+    size_t snapshots = 0;
+    while (snapshots < 20) {
+        const AnytimeBest::Snapshot best = optimizer.current_best();
+        if (!best.genome.empty()) {
+            EXPECT_GE(best.fit, last_fit);
+            last_fit = best.fit;
+            snapshots++;
+        }
+        std::this_thread::yield();
+    }
+    token.cancel();
+    runner.join();
+
+    EXPECT_STREQ(optimizer.stop_reason(), "cancelled");
+    const AnytimeBest::Snapshot best = optimizer.current_best();
+    EXPECT_GE(best.fit, optimizer.best_fit());
+    EXPECT_EQ(best.genome.size(), optimizer.population().layout().words());
+}
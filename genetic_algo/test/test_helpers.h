@@ -0,0 +1,41 @@
+#ifndef TEST_HELPERS_HEADER
+#define TEST_HELPERS_HEADER
+
+#include <genetic_optimizer.h>
+
+#include <memory>
+#include <span>
+
+namespace dl
+{
+
+// Fitness functions and pipelines shared by the unit tests
+
+// maximized at x = 0.3
+inline double peak_fitness(double x) {
+    return 1.0 / (1.0 + (x - 0.3) * (x - 0.3));
+}
+
+// roulette selection, one-point crossover and mutation
+inline void register_pipeline(GeneticOptimizer& optimizer) {
+    optimizer.register_pass(std::make_unique<SelectionPass>());
+    optimizer.register_pass(std::make_unique<CrossoverPass>());
+    optimizer.register_pass(std::make_unique<MutationPass>(0.01));
+}
+
+// batch evaluator maximized at x = 1 in every variable
+template <size_t Variables, size_t Bits>
+FitnessEvaluator sphere_evaluator(double start, double end) {
+    return FitnessEvaluator([](std::span<const double> x, std::span<double> fits) {
+        for (size_t i = 0; i < fits.size(); ++i) {
+            double sum = 0;
+            for (size_t v = 0; v < Variables; ++v)
+                sum += (x[i * Variables + v] - 1.0) * (x[i * Variables + v] - 1.0);
+            fits[i] = -sum;
+        }
+    }, BoxTransformer<Variables, Bits>(start, end));
+}
+
+}
+
+#endif // #define TEST_HELPERS_HEADER